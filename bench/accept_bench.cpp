@@ -0,0 +1,264 @@
+// accept_bench.cpp
+// 对比两种连接接收模型的 accept 吞吐：
+//   mode 0: 主 Reactor 单线程 accept，通过 socketpair 写 int 轮询分发给从 Reactor（当前 WebServer 模型）
+//   mode 1: 每个从 Reactor 持有自己的 SO_REUSEPORT 监听套接字，直接 accept4
+// 客户端线程不断 connect/close（SO_LINGER=0 避免 TIME_WAIT 耗尽端口），
+// 统计从 Reactor 完成"接收并登记"的连接数/秒。
+//
+// 用法: ./accept_bench [-m 0|1|2] [-r 从Reactor数] [-c 客户端线程数] [-n 连接总数] [-p 起始端口]
+//   -m 2（默认）依次运行两种模型
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static std::atomic<long> g_accepted{0};
+static std::atomic<bool> g_stop{false};
+
+static int make_listen(int port, bool reuse_port)
+{
+    int fd = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (reuse_port)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0)
+    {
+        perror("bind/listen");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+// 从 Reactor 对新连接的最小处理：登记到自己的 epoll，然后关闭（模拟 handle_new_connection 的 epoll_ctl 开销）
+static void register_and_close(int epfd, int connfd)
+{
+    epoll_event ev;
+    ev.data.fd = connfd;
+    ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLONESHOT;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &ev);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, connfd, nullptr);
+    close(connfd);
+    g_accepted.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ---------------- mode 0: 主 Reactor accept + socketpair 分发 ----------------
+static void sub_reactor_pipe(int pipefd)
+{
+    int epfd = epoll_create1(0);
+    epoll_event ev;
+    ev.data.fd = pipefd;
+    ev.events = EPOLLIN;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, pipefd, &ev);
+
+    epoll_event events[64];
+    while (!g_stop.load(std::memory_order_relaxed))
+    {
+        int n = epoll_wait(epfd, events, 64, 100);
+        for (int i = 0; i < n; ++i)
+        {
+            int msgs[64];
+            ssize_t ret = read(pipefd, msgs, sizeof(msgs));
+            if (ret <= 0)
+                continue;
+            for (int j = 0; j < (int)(ret / sizeof(int)); ++j)
+                register_and_close(epfd, msgs[j]);
+        }
+    }
+    close(epfd);
+}
+
+static void main_reactor(int listenfd, const std::vector<int> &pipes)
+{
+    int epfd = epoll_create1(0);
+    epoll_event ev;
+    ev.data.fd = listenfd;
+    ev.events = EPOLLIN;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev);
+
+    size_t rr = 0;
+    epoll_event events[16];
+    while (!g_stop.load(std::memory_order_relaxed))
+    {
+        int n = epoll_wait(epfd, events, 16, 100);
+        for (int i = 0; i < n; ++i)
+        {
+            while (true)
+            {
+                int connfd = accept(listenfd, nullptr, nullptr);
+                if (connfd < 0)
+                    break;
+                int msg = connfd;
+                ssize_t w = write(pipes[rr++ % pipes.size()], &msg, sizeof(msg));
+                (void)w;
+            }
+        }
+    }
+    close(epfd);
+}
+
+// ---------------- mode 1: SO_REUSEPORT 多 acceptor ----------------
+static void sub_reactor_reuseport(int listenfd)
+{
+    int epfd = epoll_create1(0);
+    epoll_event ev;
+    ev.data.fd = listenfd;
+    ev.events = EPOLLIN;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev);
+
+    epoll_event events[16];
+    while (!g_stop.load(std::memory_order_relaxed))
+    {
+        int n = epoll_wait(epfd, events, 16, 100);
+        for (int i = 0; i < n; ++i)
+        {
+            while (true)
+            {
+                int connfd = accept4(listenfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (connfd < 0)
+                    break;
+                register_and_close(epfd, connfd);
+            }
+        }
+    }
+    close(epfd);
+}
+
+// ---------------- 客户端 ----------------
+static void client(int port, long quota)
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    linger lg;
+    lg.l_onoff = 1;
+    lg.l_linger = 0;
+
+    for (long i = 0; i < quota && !g_stop.load(std::memory_order_relaxed); ++i)
+    {
+        int fd = socket(PF_INET, SOCK_STREAM, 0);
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            close(fd);
+            --i; // 监听队列溢出时重试
+            continue;
+        }
+        close(fd);
+    }
+}
+
+static double run(int mode, int reactors, int clients, long total, int port)
+{
+    g_accepted = 0;
+    g_stop = false;
+
+    std::vector<std::thread> servers;
+    std::vector<int> fds_to_close;
+
+    if (mode == 0)
+    {
+        int listenfd = make_listen(port, false);
+        fds_to_close.push_back(listenfd);
+        std::vector<int> write_ends;
+        for (int i = 0; i < reactors; ++i)
+        {
+            int sp[2];
+            socketpair(PF_UNIX, SOCK_STREAM, 0, sp);
+            fcntl(sp[0], F_SETFL, fcntl(sp[0], F_GETFL) | O_NONBLOCK);
+            write_ends.push_back(sp[1]);
+            fds_to_close.push_back(sp[0]);
+            fds_to_close.push_back(sp[1]);
+            servers.emplace_back(sub_reactor_pipe, sp[0]);
+        }
+        servers.emplace_back(main_reactor, listenfd, write_ends);
+    }
+    else
+    {
+        for (int i = 0; i < reactors; ++i)
+        {
+            int listenfd = make_listen(port, true);
+            fds_to_close.push_back(listenfd);
+            servers.emplace_back(sub_reactor_reuseport, listenfd);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> cl;
+    for (int i = 0; i < clients; ++i)
+        cl.emplace_back(client, port, total / clients);
+    for (auto &t : cl)
+        t.join();
+
+    long expect = (total / clients) * clients;
+    while (g_accepted.load() < expect)
+    {
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(30))
+            break;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    g_stop = true;
+    for (auto &t : servers)
+        t.join();
+    for (int fd : fds_to_close)
+        close(fd);
+
+    return g_accepted.load() / secs;
+}
+
+int main(int argc, char *argv[])
+{
+    int mode = 2;
+    int reactors = std::thread::hardware_concurrency();
+    int clients = 4;
+    long total = 20000;
+    int port = 19080;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:r:c:n:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm': mode = atoi(optarg); break;
+        case 'r': reactors = atoi(optarg); break;
+        case 'c': clients = atoi(optarg); break;
+        case 'n': total = atol(optarg); break;
+        case 'p': port = atoi(optarg); break;
+        default: break;
+        }
+    }
+    if (reactors <= 0)
+        reactors = 1;
+    if (clients <= 0)
+        clients = 1;
+
+    printf("accept_bench: reactors=%d clients=%d connections=%ld\n", reactors, clients, total);
+    if (mode == 0 || mode == 2)
+        printf("  main/sub + socketpair : %10.0f conn/s\n", run(0, reactors, clients, total, port));
+    if (mode == 1 || mode == 2)
+        printf("  SO_REUSEPORT accept4  : %10.0f conn/s\n", run(1, reactors, clients, total, port + 1));
+    return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+// micro_bench 公共设施
+// - 用 MICRO_BENCH(name) 定义并自动注册一个基准组，组内调用 microbench::measure 输出每项结果
+// - micro_main.cpp 重载了全局 operator new/delete，统计所有线程的堆分配次数与字节数，
+//   measure 输出的 allocs/op、bytes/op 即测量区间内的分配量除以迭代次数
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace microbench
+{
+    // 全局分配计数（在 micro_main.cpp 中定义）
+    extern std::atomic<uint64_t> g_alloc_count;
+    extern std::atomic<uint64_t> g_alloc_bytes;
+
+    struct Registry
+    {
+        struct Entry
+        {
+            const char *name;
+            void (*fn)();
+        };
+
+        static std::vector<Entry> &entries()
+        {
+            static std::vector<Entry> e;
+            return e;
+        }
+
+        Registry(const char *name, void (*fn)()) { entries().push_back({name, fn}); }
+    };
+
+    // 阻止编译器把基准中计算出的结果优化掉
+    template <class T>
+    inline void do_not_optimize(T const &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /**
+     * @brief 运行 fn(iters) 一次并输出 ns/op、allocs/op、bytes/op
+     * @param name 测试项名称
+     * @param iters 迭代次数，fn 内部自行循环 iters 次
+     * @param fn 被测函数，签名为 void(size_t iters)
+     */
+    template <class F>
+    void measure(const char *name, size_t iters, F &&fn)
+    {
+        // 预热一轮，让各类池、缓存进入稳态
+        fn(iters / 10 + 1);
+
+        uint64_t count0 = g_alloc_count.load(std::memory_order_relaxed);
+        uint64_t bytes0 = g_alloc_bytes.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        fn(iters);
+        auto end = std::chrono::steady_clock::now();
+        uint64_t count = g_alloc_count.load(std::memory_order_relaxed) - count0;
+        uint64_t bytes = g_alloc_bytes.load(std::memory_order_relaxed) - bytes0;
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        printf("  %-40s %12.1f ns/op %10.3f allocs/op %10.1f bytes/op\n", name,
+               ns / iters, (double)count / iters, (double)bytes / iters);
+    }
+
+    // 读取时间戳计数器（非 x86 平台退化为纳秒）
+    inline uint64_t cycles()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /**
+     * @brief 吞吐型测试：运行 fn(iters) 并输出 bytes/cycle 与 GB/s
+     * @param bytes_per_iter 每次迭代处理的输入字节数
+     */
+    template <class F>
+    void measure_bytes(const char *name, size_t iters, size_t bytes_per_iter, F &&fn)
+    {
+        fn(iters / 10 + 1);
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t c0 = cycles();
+        fn(iters);
+        uint64_t c1 = cycles();
+        auto end = std::chrono::steady_clock::now();
+
+        double total = (double)bytes_per_iter * iters;
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        printf("  %-40s %10.3f bytes/cycle %8.2f GB/s %10.1f ns/op\n", name,
+               total / (double)(c1 - c0), total / ns, ns / iters);
+    }
+}
+
+#define MICRO_BENCH(name)                                                       \
+    static void micro_bench_##name();                                           \
+    static microbench::Registry micro_bench_reg_##name(#name, micro_bench_##name); \
+    static void micro_bench_##name()
+
+#endif // MICRO_BENCH_H
@@ -0,0 +1,101 @@
+// buffer_pool_bench.cpp
+// BufferPool 获取/归还的开销：
+//   - 单线程：与 HttpConnection 构造/析构相同的 4KB 读写缓冲区，以及超过池中容量的 16KB 请求
+//   - 多线程争用：N 个线程同时循环 acquire/release，ns/op 为总耗时除以所有线程的总操作数
+//   - 跨线程释放：一个线程分配、另一个线程释放（连接在 SubReactor 与工作线程之间转手），缓冲区经仓库回流
+
+#include "MicroBench.h"
+#include "http/BufferPool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+MICRO_BENCH(buffer_pool)
+{
+    BufferPool &pool = BufferPool::get_instance();
+
+    microbench::measure("acquire+release 4KB", 2000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            PoolBuffer buf = pool.acquire(4096);
+            microbench::do_not_optimize(buf.data());
+            pool.release(std::move(buf));
+        }
+    });
+
+    microbench::measure("acquire+release 16KB", 500000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            PoolBuffer buf = pool.acquire(16 * 1024);
+            microbench::do_not_optimize(buf.data());
+            pool.release(std::move(buf));
+        }
+    });
+
+    // 一个连接的生命周期：读、写缓冲区各一个
+    microbench::measure("connection lifetime (2 x 4KB)", 1000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            PoolBuffer read_buf = pool.acquire(4096);
+            PoolBuffer write_buf = pool.acquire(4096);
+            microbench::do_not_optimize(read_buf.data());
+            microbench::do_not_optimize(write_buf.data());
+            pool.release(std::move(write_buf));
+            pool.release(std::move(read_buf));
+        }
+    });
+
+    for (int threads : {2, 4, 8})
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "contended acquire+release 4KB x%d", threads);
+        microbench::measure(name, 2000000, [&](size_t iters) {
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&pool, per = iters / threads]() {
+                    for (size_t i = 0; i < per; ++i)
+                    {
+                        PoolBuffer buf = pool.acquire(4096);
+                        microbench::do_not_optimize(buf.data());
+                        pool.release(std::move(buf));
+                    }
+                });
+            }
+            for (auto &w : workers)
+                w.join();
+        });
+    }
+
+    // 生产者分配一批交给消费者释放，批与批之间用原子标志交接
+    microbench::measure("cross-thread acquire -> release 4KB", 2000000, [&](size_t iters) {
+        const size_t batch = 256;
+        std::vector<PoolBuffer> handoff(batch);
+        std::atomic<int> state{0}; // 0: 生产者填充，1: 消费者释放，2: 结束
+        std::thread consumer([&]() {
+            while (true)
+            {
+                int s;
+                while ((s = state.load(std::memory_order_acquire)) == 0)
+                    std::this_thread::yield();
+                if (s == 2)
+                    return;
+                for (auto &buf : handoff)
+                    pool.release(std::move(buf));
+                state.store(0, std::memory_order_release);
+            }
+        });
+        for (size_t done = 0; done < iters; done += batch)
+        {
+            while (state.load(std::memory_order_acquire) != 0)
+                std::this_thread::yield();
+            for (auto &buf : handoff)
+                buf = pool.acquire(4096);
+            state.store(1, std::memory_order_release);
+        }
+        while (state.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+        state.store(2, std::memory_order_release);
+        consumer.join();
+    });
+}
@@ -0,0 +1,174 @@
+// compress_bench.cpp
+// 响应压缩的收益与开销：
+//   - 各编码/级别压缩一个典型 html/js/json 响应体的 CPU 时间与压缩后字节数
+//   - handle_static_file 缓存命中时按 Accept-Encoding 返回 identity/gzip/br 版本的开销与线上字节数
+//     （响应头 + 响应体），压缩版本只在第一次请求时生成
+//   - 动态 JSON 响应经 Compression::compress_response 压缩（每次请求都压缩）
+
+#include "MicroBench.h"
+#include "handler/Handler.h"
+#include "http/Compression.h"
+#include "http/StaticFileCache.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // 由常见标记、关键字和随机标识符拼成的文本，压缩率与真实页面/脚本接近（约 4~8 倍）
+    std::string make_text(const char *kind, size_t size)
+    {
+        static const char *html[] = {"<div class=\"msg\">", "</div>\n", "<span>", "</span>", "<a href=\"/chat/",
+                                     "\">", "</a>", "<li class=\"user online\">", "</li>\n", "<p>"};
+        static const char *js[] = {"function ", "(", ") {\n", "  return ", ";\n", "}\n", "const ", " = ",
+                                   "this.", ".addEventListener('click', ", "if (", " === null) "};
+        static const char *json[] = {"{\"id\":", ",\"user\":\"", "\",\"text\":\"", "\",\"ts\":", "},\n",
+                                     "\"online\":true,", "\"room\":\"", "\"}"};
+        const char **words = html;
+        size_t count = sizeof(html) / sizeof(html[0]);
+        if (std::string(kind) == "js")
+        {
+            words = js;
+            count = sizeof(js) / sizeof(js[0]);
+        }
+        else if (std::string(kind) == "json")
+        {
+            words = json;
+            count = sizeof(json) / sizeof(json[0]);
+        }
+
+        std::mt19937 rng(42);
+        // 有限的标识符词表（真实代码/页面中的名字大量重复）加上随机数字
+        std::vector<std::string> idents(256);
+        for (std::string &id : idents)
+            for (int i = 0, n = 3 + rng() % 8; i < n; ++i)
+                id += (char)('a' + rng() % 26);
+
+        std::string text;
+        while (text.size() < size)
+        {
+            text += words[rng() % count];
+            text += idents[rng() % idents.size()];
+            if (rng() % 4 == 0)
+                text += std::to_string(rng() % 10000);
+        }
+        text.resize(size);
+        return text;
+    }
+
+    size_t wire_bytes(const HttpResponse &response)
+    {
+        return response.raw_headers.size() + response.shared_body.size() + response.body.size();
+    }
+}
+
+MICRO_BENCH(compress)
+{
+    // 1. 压缩本身：每个编码的几个级别
+    struct Input
+    {
+        const char *name;
+        std::string data;
+    };
+    Input inputs[] = {
+        {"html 16KB", make_text("html", 16 * 1024)},
+        {"js 256KB", make_text("js", 256 * 1024)},
+    };
+    struct Level
+    {
+        ContentCoding coding;
+        int level;
+    };
+    const Level levels[] = {
+        {ContentCoding::Gzip, 1}, {ContentCoding::Gzip, 6}, {ContentCoding::Gzip, 9},
+        {ContentCoding::Brotli, 1}, {ContentCoding::Brotli, 5}, {ContentCoding::Brotli, 9},
+        {ContentCoding::Brotli, 11},
+    };
+    for (const Input &input : inputs)
+    {
+        for (const Level &l : levels)
+        {
+            if (!Compression::available(l.coding))
+                continue;
+            std::string out;
+            Compression::compress(l.coding, input.data, l.level, out);
+            char name[96];
+            snprintf(name, sizeof(name), "%s %s-%d -> %zu B (%.1fx)", input.name, Compression::name(l.coding),
+                     l.level, out.size(), (double)input.data.size() / out.size());
+            // br 10/11 比其他级别慢一到两个数量级，减少迭代次数
+            size_t iters = std::max<size_t>(4, (l.level >= 10 ? 2 : 32) * 1024 * 1024 / input.data.size());
+            microbench::measure(name, iters, [&](size_t n) {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    Compression::compress(l.coding, input.data, l.level, out);
+                    microbench::do_not_optimize(out.size());
+                }
+            });
+        }
+    }
+
+    // 2. 静态文件缓存命中：线上字节数与每请求开销
+    char dir_template[] = "/tmp/compress_bench.XXXXXX";
+    if (!mkdtemp(dir_template))
+        return;
+    std::string doc_root = dir_template;
+    std::ofstream(doc_root + "/index.html") << inputs[0].data;
+
+    HttpRequest req;
+    req.method = HttpMethod::GET;
+    req.path = "/index.html";
+    RequestContext ctx;
+    ctx.db_pool = nullptr;
+    ctx.doc_root = doc_root.c_str();
+    {
+        StaticFileCache cache;
+        cache.init(doc_root, 16 * 1024 * 1024);
+        ctx.file_cache = &cache;
+        for (const char *accept : {"", "gzip, deflate", "gzip, deflate, br"})
+        {
+            req.headers.clear();
+            if (*accept)
+                req.headers.add("Accept-Encoding", accept);
+            HttpResponse first = handle_static_file(req, ctx);
+            char name[96];
+            snprintf(name, sizeof(name), "static hit AE=\"%s\" %zu B on wire", accept, wire_bytes(first));
+            microbench::measure(name, 1000000, [&](size_t iters) {
+                for (size_t i = 0; i < iters; ++i)
+                    microbench::do_not_optimize(handle_static_file(req, ctx).status_code);
+            });
+        }
+        ctx.file_cache = nullptr;
+    }
+    req.headers.clear();
+
+    // 3. 动态响应：每次都压缩
+    std::string json = make_text("json", 8 * 1024);
+    for (const char *accept : {"gzip", "br"})
+    {
+        req.headers.clear();
+        req.headers.add("Accept-Encoding", accept);
+        HttpResponse sample;
+        sample.set_header("Content-Type", "application/json");
+        sample.body = json;
+        Compression::compress_response(req, sample);
+        char name[96];
+        snprintf(name, sizeof(name), "dynamic json 8KB %s -> %zu B", accept, sample.body.size());
+        microbench::measure(name, 20000, [&](size_t iters) {
+            for (size_t i = 0; i < iters; ++i)
+            {
+                HttpResponse response;
+                response.set_header("Content-Type", "application/json");
+                response.body = json;
+                Compression::compress_response(req, response);
+                microbench::do_not_optimize(response.body.size());
+            }
+        });
+    }
+    req.headers.clear();
+
+    std::error_code ec;
+    std::filesystem::remove_all(doc_root, ec);
+}
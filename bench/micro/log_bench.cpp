@@ -0,0 +1,268 @@
+// log_bench.cpp
+// 日志吞吐：原实现（每条两次 localtime + 拼成 std::string 入 BlockQueue + 写线程 fputs/fflush）
+// vs 每线程环形缓冲区 + 按秒缓存时间戳 + 写线程每批一次 writev
+//   - 1 线程 / 4 线程各写入一批访问日志，计时包含等待写线程全部落盘
+//   - ring+writev 在调用线程格式化（write_log），deferred 只保存格式串与参数（LOG_* 宏），
+//     另单独测调用方的开销（不等待落盘）
+//   - 运行期级别过滤掉的 LOG_DEBUG 的开销
+//   - 另以丢弃策略、4 线程突发写入一次，输出被丢弃的条数
+// 日志文件写在临时目录，测试结束后删除
+
+#include "MicroBench.h"
+#include "log/Log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <sys/time.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const size_t LOG_LINES = 400000;
+
+    // 与原 BlockQueue 相同的有界阻塞队列
+    class LegacyQueue
+    {
+    public:
+        explicit LegacyQueue(size_t max_size) : m_array(max_size), m_max_size(max_size) {}
+
+        void push(const std::string &item)
+        {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_not_full.wait(lk, [this] { return m_size < m_max_size; });
+            m_array[m_back] = item;
+            m_back = (m_back + 1) % m_max_size;
+            ++m_size;
+            lk.unlock();
+            m_not_empty.notify_one();
+        }
+
+        void pop(std::string &item)
+        {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_not_empty.wait(lk, [this] { return m_size > 0; });
+            item = m_array[m_front];
+            m_front = (m_front + 1) % m_max_size;
+            --m_size;
+            lk.unlock();
+            m_not_full.notify_one();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_not_empty;
+        std::condition_variable m_not_full;
+        size_t m_front = 0;
+        size_t m_back = 0;
+        std::vector<std::string> m_array;
+        size_t m_max_size;
+        size_t m_size = 0;
+    };
+
+    // 与原 Log 异步模式相同的写入路径（不含按行切割）
+    class LegacyLog
+    {
+    public:
+        LegacyLog(const std::string &path, size_t queue_size) : m_queue(queue_size)
+        {
+            m_fp = fopen(path.c_str(), "a");
+            m_thread = std::thread([this] {
+                std::string line;
+                while (true)
+                {
+                    m_queue.pop(line);
+                    if (line.empty())
+                        break;
+                    std::lock_guard<std::mutex> lk(m_mutex);
+                    time_t t = time(nullptr);
+                    tm my_tm = *localtime(&t);
+                    do_not_optimize_tm(my_tm);
+                    fputs(line.c_str(), m_fp);
+                    fflush(m_fp);
+                    m_written.fetch_add(1, std::memory_order_release);
+                }
+            });
+        }
+
+        ~LegacyLog()
+        {
+            m_queue.push(std::string());
+            m_thread.join();
+            fclose(m_fp);
+        }
+
+        void write_log(int level, const char *format, ...)
+        {
+            struct timeval now{};
+            gettimeofday(&now, nullptr);
+            time_t t = time(nullptr);
+            tm my_tm = *localtime(&t);
+
+            char s[16] = {0};
+            switch (level)
+            {
+            case 0: strcpy(s, "[debug]:"); break;
+            case 1: strcpy(s, "[info]:"); break;
+            case 2: strcpy(s, "[warn]:"); break;
+            case 3: strcpy(s, "[error]:"); break;
+            default: strcpy(s, "[info]:"); break;
+            }
+
+            char buf[2000];
+            va_list valst;
+            va_start(valst, format);
+            int n = snprintf(buf, 64, "%d-%02d-%02d %02d:%02d:%02d.%06ld %s ",
+                             my_tm.tm_year + 1900, my_tm.tm_mon + 1, my_tm.tm_mday,
+                             my_tm.tm_hour, my_tm.tm_min, my_tm.tm_sec,
+                             (long)now.tv_usec, s);
+            int m = vsnprintf(buf + n, sizeof(buf) - n - 1, format, valst);
+            va_end(valst);
+            buf[n + m] = '\n';
+            buf[n + m + 1] = '\0';
+            m_queue.push(std::string(buf));
+        }
+
+        // 等待写线程写完 total 条
+        void wait_written(uint64_t total)
+        {
+            while (m_written.load(std::memory_order_acquire) < total)
+                std::this_thread::yield();
+        }
+
+        uint64_t written() const { return m_written.load(std::memory_order_acquire); }
+
+    private:
+        static void do_not_optimize_tm(const tm &value) { microbench::do_not_optimize(value.tm_sec); }
+
+        LegacyQueue m_queue;
+        FILE *m_fp;
+        std::mutex m_mutex;
+        std::thread m_thread;
+        std::atomic<uint64_t> m_written{0};
+    };
+
+    // 在 threads 个线程中共写入 iters 条日志
+    template <class F>
+    void run_threads(size_t threads, size_t iters, F &&write_one)
+    {
+        if (threads == 1)
+        {
+            for (size_t i = 0; i < iters; ++i)
+                write_one(i);
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t] {
+                for (size_t i = t; i < iters; i += threads)
+                    write_one(i);
+            });
+        }
+        for (auto &w : workers)
+            w.join();
+    }
+}
+
+MICRO_BENCH(log)
+{
+    namespace fs = std::filesystem;
+    char tmpl[] = "/tmp/log_bench_XXXXXX";
+    if (!mkdtemp(tmpl))
+    {
+        perror("mkdtemp");
+        return;
+    }
+    std::string dir = tmpl;
+
+    Log *log = Log::get_instance();
+    log->set_full_policy(LogFullPolicy::Block);
+    if (!log->init((dir + "/ring.log").c_str(), 0, 2000, 800000, LOG_RING_DEFAULT_KB))
+        return;
+
+    printf(" access log line, %zu lines, timing includes the writer draining to disk\n", LOG_LINES);
+    for (size_t threads : {1, 4})
+    {
+        {
+            LegacyLog legacy(dir + "/legacy.log", 1000);
+            char name[64];
+            snprintf(name, sizeof(name), "legacy queue+fputs, %zu thread(s)", threads);
+            microbench::measure(name, LOG_LINES, [&](size_t iters) {
+                uint64_t target = legacy.written() + iters;
+                run_threads(threads, iters, [&](size_t i) {
+                    legacy.write_log(1, "%s %s %d %zu bytes %.3fms", "127.0.0.1", "GET /index.html", 200, i, 0.125);
+                });
+                legacy.wait_written(target);
+            });
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "ring+writev, %zu thread(s)", threads);
+        microbench::measure(name, LOG_LINES, [&](size_t iters) {
+            run_threads(threads, iters, [&](size_t i) {
+                log->write_log(1, "%s %s %d %zu bytes %.3fms", "127.0.0.1", "GET /index.html", 200, i, 0.125);
+            });
+            log->flush();
+        });
+
+        snprintf(name, sizeof(name), "deferred, %zu thread(s)", threads);
+        microbench::measure(name, LOG_LINES, [&](size_t iters) {
+            run_threads(threads, iters, [&](size_t i) {
+                LOG_INFO("%s %s %d %zu bytes %.3fms", "127.0.0.1", "GET /index.html", 200, i, 0.125);
+            });
+            log->flush();
+        });
+    }
+
+    // 调用方开销：每写 1000 条等一次落盘，计时只包含写入调用
+    std::chrono::steady_clock::duration caller_text{}, caller_deferred{};
+    for (size_t i = 0; i < LOG_LINES; i += 1000)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t j = i; j < i + 1000; ++j)
+            log->write_log(1, "%s %s %d %zu bytes %.3fms", "127.0.0.1", "GET /index.html", 200, j, 0.125);
+        auto t1 = std::chrono::steady_clock::now();
+        log->flush();
+        auto t2 = std::chrono::steady_clock::now();
+        for (size_t j = i; j < i + 1000; ++j)
+            LOG_INFO("%s %s %d %zu bytes %.3fms", "127.0.0.1", "GET /index.html", 200, j, 0.125);
+        auto t3 = std::chrono::steady_clock::now();
+        log->flush();
+        caller_text += t1 - t0;
+        caller_deferred += t3 - t2;
+    }
+    printf("  %-40s %12.1f ns/op\n", "caller only, ring+writev",
+           std::chrono::duration<double, std::nano>(caller_text).count() / LOG_LINES);
+    printf("  %-40s %12.1f ns/op\n", "caller only, deferred",
+           std::chrono::duration<double, std::nano>(caller_deferred).count() / LOG_LINES);
+
+    // 级别过滤：参数不求值（Release 构建默认在编译期就删除了 LOG_DEBUG）
+    log->set_level(1);
+    microbench::measure("LOG_DEBUG below level", LOG_LINES * 10, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+            LOG_DEBUG("%s %zu", std::to_string(i).c_str(), i);
+    });
+    log->set_level(0);
+
+    // 丢弃策略下的突发写入：写线程跟不上时不阻塞调用方
+    log->set_full_policy(LogFullPolicy::Drop);
+    uint64_t dropped0 = log->dropped();
+    microbench::measure("deferred drop policy, 4 threads", LOG_LINES, [&](size_t iters) {
+        run_threads(4, iters, [&](size_t i) {
+            LOG_INFO("%s %s %d %zu bytes %.3fms", "127.0.0.1", "GET /index.html", 200, i, 0.125);
+        });
+        log->flush();
+    });
+    printf("  dropped %llu of %zu records\n", (unsigned long long)(log->dropped() - dropped0),
+           LOG_LINES + LOG_LINES / 10 + 1);
+    log->set_full_policy(LogFullPolicy::Block);
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    log->m_close_log = 1; // 与 micro_main 一致，其余基准不写日志
+}
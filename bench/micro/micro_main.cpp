@@ -0,0 +1,57 @@
+// micro_main.cpp
+// 组件级微基准入口：依次运行所有 MICRO_BENCH 注册的基准组
+//
+// 用法: ./micro_bench [名称过滤]
+//   只运行名称中包含过滤串的基准组，例如 ./micro_bench task
+
+#include "MicroBench.h"
+#include "log/Log.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace microbench
+{
+    std::atomic<uint64_t> g_alloc_count{0};
+    std::atomic<uint64_t> g_alloc_bytes{0};
+}
+
+// 替换全局分配函数以统计堆分配（数组、nothrow 版本默认转发到这里）
+void *operator new(size_t size)
+{
+    microbench::g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    microbench::g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    // 被测组件内部的 LOG_* 不写日志（日志系统未初始化）
+    Log::get_instance()->m_close_log = 1;
+#ifdef WEBSERVER_BUILD_TYPE
+    printf("build: %s\n", WEBSERVER_BUILD_TYPE);
+    if (strcmp(WEBSERVER_BUILD_TYPE, "Debug") == 0)
+        fprintf(stderr, "warning: Debug 构建（-O0），结果不能用于性能对比，请用 cmake -DDEBUG=OFF 重新构建\n");
+#endif
+    for (auto &e : microbench::Registry::entries())
+    {
+        if (filter && !strstr(e.name, filter))
+            continue;
+        printf("[%s]\n", e.name);
+        e.fn();
+    }
+    return 0;
+}
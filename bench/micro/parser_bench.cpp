@@ -0,0 +1,212 @@
+// parser_bench.cpp
+// HttpParser 解析开销：
+//   - 分词吞吐（bytes/cycle）：逐行 string_view::find 的旧做法 vs HttpScanner 的 scalar/SSE2/AVX2 实现
+//   - 请求头查找：逐个 tolower 比较的旧做法 vs 预计算小写哈希的索引
+//   - 完整解析：模拟 keep-alive 连接上反复解析同一个请求
+//     （读缓冲区 -> parse -> 丢弃 consumed() 字节 -> reset），零拷贝路径应为 0 allocs/op
+
+#include "MicroBench.h"
+#include "http/HttpParser.h"
+#include "http/HttpScanner.h"
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    const char *kBrowserGet =
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "Connection: keep-alive\r\n"
+        "Cache-Control: max-age=0\r\n"
+        "Upgrade-Insecure-Requests: 1\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+        "Cookie: sessionId=4f1c2b7e9a; theme=dark\r\n"
+        "\r\n";
+
+    const char *kWrkGet =
+        "GET /api/test HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "\r\n";
+
+    const char *kFormPost =
+        "POST /api/auth/login HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "Connection: keep-alive\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: 29\r\n"
+        "\r\n"
+        "username=alice&password=12345";
+
+    // 浏览器/命令行工具/XHR 抓包得到的典型请求头部
+    const char *kFirefoxGet =
+        "GET /static/js/app.3f9a1c.js HTTP/1.1\r\n"
+        "Host: chat.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64; rv:121.0) Gecko/20100101 Firefox/121.0\r\n"
+        "Accept: */*\r\n"
+        "Accept-Language: zh-CN,zh;q=0.8,zh-TW;q=0.7,zh-HK;q=0.5,en-US;q=0.3,en;q=0.2\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Referer: https://chat.example.com/index.html\r\n"
+        "Connection: keep-alive\r\n"
+        "Cookie: sessionId=9b1f0c2d4e5a6b7c8d9e0f1a2b3c4d5e; _ga=GA1.2.1234567890.1700000000; _gid=GA1.2.987654321.1700000000; theme=dark; lang=zh-CN\r\n"
+        "Sec-Fetch-Dest: script\r\n"
+        "Sec-Fetch-Mode: no-cors\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "If-None-Match: \"5f2a-18c7e2b3a40\"\r\n"
+        "If-Modified-Since: Tue, 12 Dec 2023 08:00:00 GMT\r\n"
+        "\r\n";
+
+    const char *kCurlGet =
+        "GET /api/auth/validate_session HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "User-Agent: curl/8.5.0\r\n"
+        "Accept: */*\r\n"
+        "Cookie: sessionId=4f1c2b7e9a\r\n"
+        "\r\n";
+
+    const char *kWebSocketUpgrade =
+        "GET /api/upgrade HTTP/1.1\r\n"
+        "Host: chat.example.com\r\n"
+        "Connection: Upgrade\r\n"
+        "Pragma: no-cache\r\n"
+        "Cache-Control: no-cache\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+        "Upgrade: websocket\r\n"
+        "Origin: https://chat.example.com\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9\r\n"
+        "Cookie: sessionId=4f1c2b7e9a\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n"
+        "\r\n";
+
+    // 旧做法：先找 "\r\n\r\n"，再逐行 find("\r\n") 与 find(':')
+    size_t legacy_tokenize(std::string_view data, HttpTokens &t)
+    {
+        t.clear();
+        size_t header_end = data.find("\r\n\r\n");
+        if (header_end == std::string_view::npos)
+            return 0;
+        size_t pos = 0;
+        while (pos < header_end + 2 && t.count < HttpTokens::MAX_LINES)
+        {
+            size_t crlf = data.find("\r\n", pos);
+            size_t colon = data.substr(pos, crlf - pos).find(':');
+            t.lines[t.count++] = HttpTokens::Line{(uint32_t)pos, (uint32_t)crlf,
+                                                  colon == std::string_view::npos ? HttpTokens::NO_COLON : (uint32_t)(pos + colon)};
+            pos = crlf + 2;
+        }
+        t.header_end = header_end + 4;
+        return t.header_end;
+    }
+
+    // 旧做法：逐个请求头做 std::tolower 比较
+    std::optional<std::string_view> legacy_get_header(const HttpHeaders &headers, std::string_view key)
+    {
+        for (const auto &[k, v] : headers)
+        {
+            if (std::equal(k.begin(), k.end(), key.begin(), key.end(),
+                           [](char a, char b) { return std::tolower(a) == std::tolower(b); }))
+                return v;
+        }
+        return std::nullopt;
+    }
+
+    // 与 HttpConnection 的用法一致：请求字节追加到读缓冲区，解析完成后丢弃 consumed() 字节并 reset
+    void parse_loop(HttpParser &parser, PoolBuffer &buffer, const std::string &req, size_t iters)
+    {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            buffer.insert(buffer.end(), req.begin(), req.end());
+            HttpParser::ParseResult r = parser.parse(buffer);
+            microbench::do_not_optimize(r);
+            microbench::do_not_optimize(parser.get_request().path);
+            size_t consumed = std::min(parser.consumed(), buffer.size());
+            buffer.erase(buffer.begin(), buffer.begin() + consumed);
+            parser.reset();
+        }
+    }
+}
+
+MICRO_BENCH(parser)
+{
+    std::vector<std::string> corpus = {kBrowserGet, kWrkGet, kFirefoxGet, kCurlGet, kWebSocketUpgrade};
+    size_t corpus_bytes = 0;
+    for (const auto &r : corpus)
+        corpus_bytes += r.size();
+
+    // 1. 分词吞吐
+    HttpTokens tokens;
+    microbench::measure_bytes("tokenize legacy find-per-line", 200000, corpus_bytes, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+            for (const auto &r : corpus)
+                microbench::do_not_optimize(legacy_tokenize(r, tokens));
+    });
+
+    HttpScanner::Impl original = HttpScanner::impl();
+    for (HttpScanner::Impl impl : {HttpScanner::Impl::Scalar, HttpScanner::Impl::SSE2, HttpScanner::Impl::AVX2})
+    {
+        if (!HttpScanner::set_impl(impl))
+            continue;
+        std::string name = std::string("tokenize HttpScanner ") + HttpScanner::impl_name(impl);
+        microbench::measure_bytes(name.c_str(), 200000, corpus_bytes, [&](size_t iters) {
+            for (size_t i = 0; i < iters; ++i)
+                for (const auto &r : corpus)
+                {
+                    tokens.clear();
+                    HttpScanner::scan(r.data(), r.size(), tokens);
+                    microbench::do_not_optimize(tokens.header_end);
+                }
+        });
+    }
+    HttpScanner::set_impl(original);
+
+    // 2. 请求头查找：HttpConnection/HttpParser 每个请求都会查的几个头
+    HttpParser lookup_parser("");
+    PoolBuffer lookup_buffer(kFirefoxGet, kFirefoxGet + strlen(kFirefoxGet));
+    lookup_parser.parse(lookup_buffer);
+    const HttpHeaders &headers = lookup_parser.get_request().headers;
+    const char *keys[] = {"Content-Type", "Content-Length", "Connection", "Upgrade", "If-None-Match"};
+
+    microbench::measure("get_header legacy tolower scan x5", 1000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+            for (const char *k : keys)
+                microbench::do_not_optimize(legacy_get_header(headers, k));
+    });
+    microbench::measure("get_header hashed index x5", 1000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+            for (const char *k : keys)
+                microbench::do_not_optimize(headers.get(k));
+    });
+
+    // 3. 完整解析
+    HttpParser parser("");
+    PoolBuffer buffer;
+    buffer.reserve(4096);
+
+    struct Case
+    {
+        const char *name;
+        std::string req;
+    };
+    Case cases[] = {
+        {"keep-alive GET (browser, 10 headers)", kBrowserGet},
+        {"keep-alive GET (wrk, 1 header)", kWrkGet},
+        {"keep-alive GET (firefox, 13 headers)", kFirefoxGet},
+        {"keep-alive POST form body", kFormPost},
+    };
+
+    for (const auto &c : cases)
+    {
+        microbench::measure(c.name, 200000, [&](size_t iters) {
+            parse_loop(parser, buffer, c.req, iters);
+        });
+    }
+}
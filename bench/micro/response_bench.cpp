@@ -0,0 +1,178 @@
+// response_bench.cpp
+// 响应序列化：ostringstream 拼接后整体拷贝进写缓冲区（旧做法）vs HeaderWriter 直接写入复用的写缓冲区
+//   - 小 JSON 响应：body 与响应头一起放入写缓冲区
+//   - 16KB 页面：旧做法 body 经 ostringstream -> str() -> 写缓冲区拷贝三次；
+//     新做法把 body 移交给发送队列（一次小分配），作为第二个 iovec 发送，不拷贝
+//   - Date/Server 响应头：每个响应格式化一次 vs HttpClock 每秒更新的前缀
+// 每次迭代都重新构造 HttpResponse（模拟 handler），两种做法的这部分开销相同
+
+#include "MicroBench.h"
+#include "http/HeaderWriter.h"
+#include "http/HttpClock.h"
+#include "http/HttpConnection.h"
+#include "http/HttpResponse.h"
+#include <memory>
+#include <sstream>
+#include <string>
+#include <sys/uio.h>
+#include <ctime>
+#include <vector>
+
+namespace
+{
+    // 与原 HttpConnection::prepare_response 相同的做法
+    void legacy_serialize(const HttpResponse &response, std::vector<char> &buffer)
+    {
+        std::ostringstream header_stream;
+        header_stream << "HTTP/1.1 " << response.status_code << " " << response.status_text << "\r\n";
+        for (const auto &[key, value] : response.headers)
+            header_stream << key << ": " << value << "\r\n";
+        if (!response.body.empty() && response.headers.find("Content-Length") == response.headers.end())
+            header_stream << "Content-Length: " << response.body.size() << "\r\n";
+        header_stream << "\r\n";
+        if (!response.body.empty())
+            header_stream << response.body;
+        std::string response_str = header_stream.str();
+        buffer.assign(response_str.begin(), response_str.end());
+    }
+
+    // 与现在的 HttpConnection::prepare_response 相同的做法，返回待发送的 iovec 个数
+    int writer_serialize(HttpResponse &response, std::vector<char> &buffer, iovec *iov,
+                         std::shared_ptr<const void> &pin)
+    {
+        buffer.clear();
+        std::shared_ptr<std::string> body;
+        if (response.body.size() > HTTP_INLINE_BODY_MAX)
+            body = std::make_shared<std::string>(std::move(response.body));
+
+        HeaderWriter<std::vector<char>> writer(buffer);
+        writer.reserve(256 + (body ? 0 : response.body.size()));
+        writer.status_line(response.status_code, response.status_text);
+        char prefix[HTTP_CLOCK_PREFIX_MAX];
+        writer.append(std::string_view(prefix, HttpClock::copy_prefix(prefix)));
+        for (const auto &[key, value] : response.headers)
+            writer.header(key, value);
+        if (response.headers.find("Content-Length") == response.headers.end())
+            writer.header("Content-Length", body ? body->size() : response.body.size());
+        writer.end();
+
+        if (!body)
+        {
+            writer.append(response.body);
+            iov[0] = {buffer.data(), buffer.size()};
+            return 1;
+        }
+        iov[0] = {buffer.data(), buffer.size()};
+        iov[1] = {body->data(), body->size()};
+        pin = std::move(body);
+        return 2;
+    }
+
+    HttpResponse make_response(const std::string &body, const char *type)
+    {
+        HttpResponse response;
+        response.set_header("Content-Type", type);
+        response.body = body;
+        return response;
+    }
+}
+
+MICRO_BENCH(response)
+{
+    std::vector<char> buffer;
+    buffer.reserve(4096); // 连接的写缓冲区来自 BufferPool，已有容量
+
+    struct Case
+    {
+        const char *name;
+        std::string body;
+        const char *type;
+    };
+    Case cases[] = {
+        {"json 61B", R"({"message": "Hello from HttpConnection", "status": "success"})", "application/json"},
+        {"html 16KB", std::string(16 * 1024, 'x'), "text/html"},
+    };
+
+    for (const Case &c : cases)
+    {
+        std::string name = std::string("construct only ") + c.name;
+        microbench::measure(name.c_str(), 200000, [&](size_t iters) {
+            for (size_t i = 0; i < iters; ++i)
+            {
+                HttpResponse response = make_response(c.body, c.type);
+                microbench::do_not_optimize(response.body.data());
+            }
+        });
+
+        name = std::string("legacy ostringstream ") + c.name;
+        microbench::measure(name.c_str(), 200000, [&](size_t iters) {
+            for (size_t i = 0; i < iters; ++i)
+            {
+                HttpResponse response = make_response(c.body, c.type);
+                legacy_serialize(response, buffer);
+                microbench::do_not_optimize(buffer.data());
+            }
+        });
+
+        name = std::string("HeaderWriter + body iovec ") + c.name;
+        microbench::measure(name.c_str(), 200000, [&](size_t iters) {
+            iovec iov[2];
+            for (size_t i = 0; i < iters; ++i)
+            {
+                HttpResponse response = make_response(c.body, c.type);
+                std::shared_ptr<const void> pin;
+                int count = writer_serialize(response, buffer, iov, pin);
+                microbench::do_not_optimize(iov[count - 1].iov_base);
+            }
+        });
+    }
+
+    // 状态行：逐段拼接（状态码经 std::to_string）vs 缓存的整行
+    microbench::measure("status line std::to_string", 1000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            buffer.clear();
+            std::string line = "HTTP/1.1 " + std::to_string((i & 1) ? 404 : 200) + " " +
+                               ((i & 1) ? "Not Found" : "OK") + "\r\n";
+            buffer.insert(buffer.end(), line.begin(), line.end());
+            microbench::do_not_optimize(buffer.data());
+        }
+    });
+    microbench::measure("status line cached", 1000000, [&](size_t iters) {
+        HeaderWriter<std::vector<char>> writer(buffer);
+        for (size_t i = 0; i < iters; ++i)
+        {
+            buffer.clear();
+            writer.status_line((i & 1) ? 404 : 200, (i & 1) ? "Not Found" : "OK");
+            microbench::do_not_optimize(buffer.data());
+        }
+    });
+
+    // Date/Server 响应头：每个响应 time() + strftime vs 每秒更新一次的 seqlock 前缀
+    microbench::measure("Date per response time+strftime", 1000000, [&](size_t iters) {
+        HeaderWriter<std::vector<char>> writer(buffer);
+        for (size_t i = 0; i < iters; ++i)
+        {
+            buffer.clear();
+            char date[64];
+            time_t now = time(nullptr);
+            struct tm tm;
+            gmtime_r(&now, &tm);
+            size_t n = strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+            writer.header("Date", std::string_view(date, n));
+            writer.header("Server", HTTP_SERVER_NAME);
+            microbench::do_not_optimize(buffer.data());
+        }
+    });
+    HttpClock::update();
+    microbench::measure("Date cached prefix (seqlock copy)", 1000000, [&](size_t iters) {
+        HeaderWriter<std::vector<char>> writer(buffer);
+        for (size_t i = 0; i < iters; ++i)
+        {
+            buffer.clear();
+            char prefix[HTTP_CLOCK_PREFIX_MAX];
+            writer.append(std::string_view(prefix, HttpClock::copy_prefix(prefix)));
+            microbench::do_not_optimize(buffer.data());
+        }
+    });
+}
@@ -0,0 +1,174 @@
+// router_bench.cpp
+// 基数树 Router 与旧的线性 std::regex 路由（此处按原实现保留一份 LegacyRouter）的查找开销对比，
+// 路由表由 register_routes 注册，与 WebServer::init 完全相同；route_request 调用真实的 handler
+
+#include "MicroBench.h"
+#include "handler/Handler.h"
+#include "http/Router.h"
+#include "http/StaticFileCache.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // 旧实现：按注册顺序逐条 regex_match / 字符串比较
+    class LegacyRouter
+    {
+    public:
+        void add_route(const std::string &path)
+        {
+            Rule r;
+            r.pattern = path;
+            r.is_regex = path.find_first_of(".*+?^${}()|[]\\") != std::string::npos;
+            if (r.is_regex)
+                r.re = std::regex(path);
+            m_rules.push_back(std::move(r));
+        }
+
+        int find(const std::string &path) const
+        {
+            for (size_t i = 0; i < m_rules.size(); ++i)
+            {
+                const Rule &rule = m_rules[i];
+                bool matches;
+                if (rule.is_regex)
+                {
+                    std::smatch match_result;
+                    matches = std::regex_match(path, match_result, rule.re);
+                }
+                else
+                {
+                    matches = (path == rule.pattern);
+                }
+                if (matches)
+                    return (int)i;
+            }
+            return -1;
+        }
+
+    private:
+        struct Rule
+        {
+            std::string pattern;
+            std::regex re;
+            bool is_regex;
+        };
+        std::vector<Rule> m_rules;
+    };
+
+    HttpResponse dummy_handler(const HttpRequest &, RequestContext &)
+    {
+        return HttpResponse();
+    }
+}
+
+MICRO_BENCH(router)
+{
+    LegacyRouter legacy;
+    for (const char *p : {"/api/test", "/api/auth/validate_session", "/api/auth/logout", "/api/upgrade",
+                          R"(/.*\.(html|htm|css|js|json|txt|xml|csv)$)",
+                          R"(/.*\.(jpg|jpeg|png|gif|bmp|webp|svg|ico)$)",
+                          R"(/.*\.(pdf|doc|docx|xls|xlsx|ppt|pptx)$)",
+                          R"(/.*\.(mp3|wav|mp4|avi)$)",
+                          R"(/.*\.(zip|tar|gz|rar)$)",
+                          R"(/.*\.(ttf|woff|woff2)$)",
+                          R"(^/$)", R"(/[^.]*$)"})
+        legacy.add_route(p);
+
+    // WebServer::init 的路由表，另加一条带参数的路由
+    Router router;
+    register_routes(router, true);
+    router.add_route(HttpMethod::GET, "/api/user/:id/posts/:post", dummy_handler);
+
+    struct Case
+    {
+        const char *label;
+        std::string path;
+    };
+    std::vector<Case> cases = {
+        {"literal   /api/test", "/api/test"},
+        {"static    /index.html", "/index.html"},
+        {"static    /fonts/a/b/icon.woff2", "/fonts/a/b/icon.woff2"},
+        {"no-ext    /about", "/about"},
+        {"miss      /setup.exe", "/setup.exe"},
+    };
+
+    for (const auto &c : cases)
+    {
+        std::string name = std::string("legacy regex  ") + c.label;
+        microbench::measure(name.c_str(), 200000, [&](size_t iters) {
+            int hit = 0;
+            for (size_t i = 0; i < iters; ++i)
+                hit += legacy.find(c.path);
+            microbench::do_not_optimize(hit);
+        });
+
+        name = std::string("radix tree    ") + c.label;
+        microbench::measure(name.c_str(), 2000000, [&](size_t iters) {
+            RouteParams params;
+            const RouteRule *hit = nullptr;
+            for (size_t i = 0; i < iters; ++i)
+            {
+                hit = router.match(HttpMethod::GET, c.path, params);
+                microbench::do_not_optimize(hit);
+            }
+        });
+    }
+
+    std::string param_path = "/api/user/42/posts/7";
+    microbench::measure("radix tree    param /api/user/:id/posts/:post", 2000000, [&](size_t iters) {
+        RouteParams params;
+        for (size_t i = 0; i < iters; ++i)
+        {
+            const RouteRule *hit = router.match(HttpMethod::GET, param_path, params);
+            microbench::do_not_optimize(hit);
+        }
+    });
+
+    // route_request：查找 + 调用真实 handler，即 HttpConnection 中路由一次请求的开销；
+    // 静态文件放在临时目录中并经 StaticFileCache 命中，登录请求不带表单，在访问数据库之前返回 400
+    char dir_template[] = "/tmp/router_bench.XXXXXX";
+    if (!mkdtemp(dir_template))
+        return;
+    std::string doc_root = dir_template;
+    std::ofstream(doc_root + "/index.html") << std::string(2048, 'x');
+    StaticFileCache cache;
+    cache.init(doc_root, 16 * 1024 * 1024);
+    RequestContext ctx;
+    ctx.db_pool = nullptr;
+    ctx.doc_root = doc_root.c_str();
+    ctx.file_cache = &cache;
+
+    struct RequestCase
+    {
+        const char *label;
+        HttpMethod method;
+        std::string path;
+    };
+    std::vector<RequestCase> requests = {
+        {"route_request GET  /api/test", HttpMethod::GET, "/api/test"},
+        {"route_request POST /api/auth/login (400)", HttpMethod::POST, "/api/auth/login"},
+        {"route_request GET  /index.html", HttpMethod::GET, "/index.html"},
+        {"route_request POST /index.html (404)", HttpMethod::POST, "/index.html"},
+    };
+    for (const auto &c : requests)
+    {
+        microbench::measure(c.label, 1000000, [&](size_t iters) {
+            HttpRequest req;
+            req.method = c.method;
+            req.path = c.path;
+            for (size_t i = 0; i < iters; ++i)
+            {
+                HttpResponse resp = router.route_request(req, ctx);
+                microbench::do_not_optimize(resp);
+            }
+        });
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(doc_root, ec);
+}
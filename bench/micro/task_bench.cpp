@@ -0,0 +1,126 @@
+// task_bench.cpp
+// 任务类型与派发路径的分配/耗时对比：
+//   - std::function 与 Task 包装 SubReactor 热路径闭包（shared_ptr + this + fd）的开销
+//   - 与 SubReactor::handle_http_read 相同的往返：ThreadPool::append -> 工作线程 -> Reactor 收件箱，
+//     稳态下应为 0 allocs/op
+//   - 单个提交线程投递阻塞型任务（模拟 SQL 查询）：任务应分摊到所有工作线程，
+//     8 个工作线程下 ns/op 应接近 单任务耗时 / 8，而不是单任务耗时
+
+#include "MicroBench.h"
+#include "thread_pool/Task.h"
+#include "thread_pool/ThreadPool.h"
+#include "thread_pool/MpscQueue.h"
+#include "tools/Tools.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace
+{
+    struct FakeConn
+    {
+        std::atomic<int> handled{0};
+        Action process()
+        {
+            handled.fetch_add(1, std::memory_order_relaxed);
+            return Action::Write;
+        }
+    };
+
+    struct FakeReactor
+    {
+        MpscQueue<Task> inbox{4096};
+        long completed = 0;
+
+        void on_done(int sockfd, Action action)
+        {
+            if (sockfd >= 0 && action == Action::Write)
+                ++completed;
+        }
+    };
+}
+
+MICRO_BENCH(task)
+{
+    auto conn = std::make_shared<FakeConn>();
+    FakeReactor reactor;
+    FakeReactor *self = &reactor;
+    int sockfd = 42;
+
+    // 闭包捕获与 SubReactor 完全一致：shared_ptr + this + fd（+ Action）
+    auto make_closure = [&]() {
+        return [conn, self, sockfd]() { self->on_done(sockfd, conn->process()); };
+    };
+    static_assert(Task::stored_inline<decltype(make_closure())>(), "hot-path closure must fit inline");
+
+    microbench::measure("std::function wrap+move+call", 1000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            std::function<void()> f = make_closure();
+            std::function<void()> g = std::move(f);
+            g();
+        }
+    });
+
+    microbench::measure("Task wrap+move+call", 1000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            Task f = make_closure();
+            Task g = std::move(f);
+            g();
+        }
+    });
+
+    microbench::measure("MpscQueue<Task> push+pop", 1000000, [&](size_t iters) {
+        Task t;
+        for (size_t i = 0; i < iters; ++i)
+        {
+            reactor.inbox.push(make_closure());
+            while (reactor.inbox.pop(t))
+                t();
+        }
+    });
+
+    // 完整派发往返：本线程充当 Reactor，投递到线程池，工作线程再把完成回调投回收件箱
+    ThreadPool pool(4, 1024);
+    microbench::measure("ThreadPool append -> reactor inbox", 200000, [&](size_t iters) {
+        long target = reactor.completed + (long)iters;
+        size_t sent = 0;
+        Task t;
+        while (reactor.completed < target)
+        {
+            // 每批最多投递 256 个，随后回收完成回调，使收件箱始终在预分配节点内
+            for (int k = 0; k < 256 && sent < iters; ++k)
+            {
+                bool queued = pool.append([conn, self, sockfd]() {
+                    Action action = conn->process();
+                    self->inbox.push([self, sockfd, action]() { self->on_done(sockfd, action); });
+                });
+                if (!queued)
+                    break;
+                ++sent;
+            }
+            while (reactor.inbox.pop(t))
+                t();
+            if (sent == iters)
+                std::this_thread::yield();
+        }
+    });
+
+    // 同一提交线程投递的阻塞任务：目标工作线程阻塞时，其余工作线程应接管其收件箱
+    ThreadPool blocking_pool(8, 1024);
+    microbench::measure("ThreadPool blocking 10ms tasks x8 workers", 64, [&](size_t iters) {
+        std::atomic<size_t> done{0};
+        for (size_t i = 0; i < iters; ++i)
+        {
+            blocking_pool.append([&done]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (done.load(std::memory_order_acquire) < iters)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    });
+}
@@ -0,0 +1,201 @@
+// timer_bench.cpp
+// 定时器增删改与到期处理（100 万个定时器）：原 multimap + unordered_map 索引 + 每个定时器 new
+// 的 TimerManager vs 分层时间轮 + 嵌入 client_data 的侵入式节点
+//   - add+del：新连接建立定时器，随后主动关闭
+//   - adjust：已有连接上的每次读写事件都要延期，时间轮只改 deadline
+//   - expire：全部定时器在 10s 内依次到期，按 1s 一次的节拍推进（时间轮另测一次延期后再到期的情形）
+// 到期时间在 [timeout, timeout + 60s) 内随机分布，模拟到达时刻不同的连接
+
+#include "MicroBench.h"
+#include "timer/Timer.h"
+#include "tools/Tools.h"
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    const size_t TIMER_COUNT = 1000000;
+
+    // 与原 TimerManager 相同的实现（时间单位改为毫秒，tick 的当前时刻由参数给出）
+    struct LegacyTimer
+    {
+        uint64_t expire;
+        std::function<void(client_data *)> cb_func;
+        client_data *user_data;
+    };
+
+    class LegacyTimerManager
+    {
+    public:
+        void add_timer(LegacyTimer *timer)
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex);
+            auto it = timers.insert({timer->expire, timer});
+            index[timer] = it;
+        }
+
+        void adjust_timer(LegacyTimer *timer, uint64_t new_expire)
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex);
+            auto it = index.find(timer);
+            if (it == index.end())
+                return;
+            timers.erase(it->second);
+            timer->expire = new_expire;
+            it->second = timers.insert({timer->expire, timer});
+        }
+
+        void del_timer(LegacyTimer *timer)
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex);
+            auto it = index.find(timer);
+            if (it == index.end())
+                return;
+            timers.erase(it->second);
+            index.erase(it);
+            delete timer;
+        }
+
+        void tick(uint64_t cur)
+        {
+            std::vector<LegacyTimer *> expired_timers;
+            {
+                std::lock_guard<std::mutex> lock(timer_mutex);
+                auto it = timers.begin();
+                while (it != timers.end() && it->first <= cur)
+                {
+                    expired_timers.push_back(it->second);
+                    index.erase(it->second);
+                    it = timers.erase(it);
+                }
+            }
+            for (LegacyTimer *timer : expired_timers)
+            {
+                if (timer->cb_func)
+                    timer->cb_func(timer->user_data);
+                delete timer;
+            }
+        }
+
+    private:
+        std::multimap<uint64_t, LegacyTimer *> timers;
+        std::unordered_map<LegacyTimer *, std::multimap<uint64_t, LegacyTimer *>::iterator> index;
+        std::mutex timer_mutex;
+    };
+}
+
+MICRO_BENCH(timer)
+{
+    const uint64_t timeout = 15000;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> offsets(TIMER_COUNT);
+    for (uint64_t &offset : offsets)
+        offset = timeout + rng() % 60000;
+
+    size_t fired = 0;
+    // 与 SubReactor 的超时回调一样只捕获一个指针，std::function 不分配
+    std::function<void(client_data *)> callback = [&fired](client_data *) { ++fired; };
+
+    // ---------- 原实现 ----------
+    {
+        std::vector<LegacyTimer *> handles(TIMER_COUNT);
+
+        microbench::measure("multimap add+del 1M", TIMER_COUNT, [&](size_t iters) {
+            LegacyTimerManager tm;
+            uint64_t now = 0;
+            for (size_t i = 0; i < iters; ++i)
+            {
+                LegacyTimer *timer = new LegacyTimer{now + offsets[i], callback, nullptr};
+                tm.add_timer(timer);
+                handles[i] = timer;
+            }
+            for (size_t i = 0; i < iters; ++i)
+                tm.del_timer(handles[i]);
+        });
+
+        LegacyTimerManager tm;
+        for (size_t i = 0; i < TIMER_COUNT; ++i)
+        {
+            handles[i] = new LegacyTimer{offsets[i], callback, nullptr};
+            tm.add_timer(handles[i]);
+        }
+        uint64_t now = 0;
+        microbench::measure("multimap adjust 1M", TIMER_COUNT, [&](size_t iters) {
+            for (size_t i = 0; i < iters; ++i)
+            {
+                size_t k = i % TIMER_COUNT;
+                tm.adjust_timer(handles[k], ++now + offsets[k]);
+            }
+        });
+        for (size_t i = 0; i < TIMER_COUNT; ++i)
+            tm.del_timer(handles[i]);
+
+        microbench::measure("multimap expire 1M (1s ticks)", TIMER_COUNT, [&](size_t iters) {
+            LegacyTimerManager tm;
+            for (size_t i = 0; i < iters; ++i)
+                tm.add_timer(new LegacyTimer{offsets[i] % 10000, callback, nullptr});
+            for (uint64_t t = 0; t <= 10000; t += 1000)
+                tm.tick(t);
+        });
+    }
+
+    // ---------- 时间轮 ----------
+    {
+        std::vector<client_data> clients(TIMER_COUNT);
+        for (client_data &client : clients)
+        {
+            client.timer.user_data = &client;
+            client.timer.cb_func = callback;
+        }
+
+        microbench::measure("wheel add+del 1M", TIMER_COUNT, [&](size_t iters) {
+            TimerManager tm;
+            uint64_t now = TimerManager::now_ms();
+            for (size_t i = 0; i < iters; ++i)
+                tm.add_timer(&clients[i].timer, now + offsets[i]);
+            for (size_t i = 0; i < iters; ++i)
+                tm.del_timer(&clients[i].timer);
+        });
+
+        TimerManager tm;
+        uint64_t base = TimerManager::now_ms();
+        for (size_t i = 0; i < TIMER_COUNT; ++i)
+            tm.add_timer(&clients[i].timer, base + offsets[i]);
+        uint64_t now = base;
+        microbench::measure("wheel adjust 1M (lazy)", TIMER_COUNT, [&](size_t iters) {
+            for (size_t i = 0; i < iters; ++i)
+            {
+                size_t k = i % TIMER_COUNT;
+                tm.adjust_timer(&clients[k].timer, ++now + offsets[k]);
+            }
+        });
+        for (size_t i = 0; i < TIMER_COUNT; ++i)
+            tm.del_timer(&clients[i].timer);
+
+        microbench::measure("wheel expire 1M (1s ticks)", TIMER_COUNT, [&](size_t iters) {
+            TimerManager tm;
+            uint64_t now = TimerManager::now_ms();
+            for (size_t i = 0; i < iters; ++i)
+                tm.add_timer(&clients[i].timer, now + offsets[i] % 10000);
+            for (uint64_t t = now; t <= now + 10000; t += 1000)
+                tm.advance(t);
+        });
+
+        // 每个定时器到期前都延期过一次：到达原槽位时按 deadline 重新挂入，再到期
+        microbench::measure("wheel adjust once + expire 1M", TIMER_COUNT, [&](size_t iters) {
+            TimerManager tm;
+            uint64_t now = TimerManager::now_ms();
+            for (size_t i = 0; i < iters; ++i)
+                tm.add_timer(&clients[i].timer, now + offsets[i] % 10000);
+            for (size_t i = 0; i < iters; ++i)
+                tm.adjust_timer(&clients[i].timer, now + offsets[i] % 10000 + 5000);
+            for (uint64_t t = now; t <= now + 15000; t += 1000)
+                tm.advance(t);
+        });
+    }
+    microbench::do_not_optimize(fired);
+}
@@ -0,0 +1,101 @@
+// websocket_bench.cpp
+// WebSocketConn 帧编解码开销（不经过 socket）：
+//   - parseFrames：客户端发来的带掩码文本帧，单帧与一次 recv 读到多帧两种情况，每帧回调一次
+//   - pack_text_frame：服务器发送的不掩码文本帧（聊天室广播时每个接收者打包一次）
+
+#include "MicroBench.h"
+#include "websocket/WebSocketConn.h"
+#include <string>
+
+// WebSocketConn 声明的友元，用于访问私有的帧处理函数
+struct WebSocketConnBench
+{
+    static bool feed(WebSocketConn &conn, const std::string &bytes)
+    {
+        conn.read_buf_.append(bytes);
+        return conn.parseFrames();
+    }
+
+    static std::string pack(const std::string &payload) { return WebSocketConn::pack_text_frame(payload); }
+};
+
+namespace
+{
+    // 与浏览器相同的客户端帧：FIN + text，带掩码
+    std::string masked_frame(const std::string &payload)
+    {
+        static const unsigned char mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+        std::string frame;
+        size_t n = payload.size();
+        frame += (char)0x81;
+        if (n < 126)
+        {
+            frame += (char)(0x80 | n);
+        }
+        else
+        {
+            frame += (char)(0x80 | 126);
+            frame += (char)(n >> 8);
+            frame += (char)(n & 0xff);
+        }
+        frame.append((const char *)mask, 4);
+        for (size_t i = 0; i < n; ++i)
+            frame += (char)(payload[i] ^ mask[i & 3]);
+        return frame;
+    }
+
+    std::string chat_message(size_t content_size)
+    {
+        return "{\"type\":\"chat\",\"subtype\":\"room_msg\",\"room\":\"lobby\",\"from\":\"alice\",\"content\":\"" +
+               std::string(content_size, 'x') + "\"}";
+    }
+}
+
+MICRO_BENCH(websocket)
+{
+    WebSocketConn conn(-1, nullptr, nullptr);
+    size_t delivered = 0;
+    conn.set_on_message_callback([&delivered](int, const std::string &msg) { delivered += msg.size(); });
+
+    std::string small = masked_frame(chat_message(32));
+    std::string large = masked_frame(chat_message(4000));
+    std::string batch;
+    for (int i = 0; i < 16; ++i)
+        batch += small;
+
+    microbench::measure("parseFrames 1 x 110B masked", 1000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+            WebSocketConnBench::feed(conn, small);
+        microbench::do_not_optimize(delivered);
+    });
+
+    microbench::measure("parseFrames 16 x 110B masked (per frame)", 1600000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; i += 16)
+            WebSocketConnBench::feed(conn, batch);
+        microbench::do_not_optimize(delivered);
+    });
+
+    microbench::measure("parseFrames 1 x 4KB masked", 200000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+            WebSocketConnBench::feed(conn, large);
+        microbench::do_not_optimize(delivered);
+    });
+
+    std::string small_payload = chat_message(32);
+    std::string large_payload = chat_message(4000);
+    microbench::measure("pack_text_frame 110B", 2000000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            std::string frame = WebSocketConnBench::pack(small_payload);
+            microbench::do_not_optimize(frame.data());
+        }
+    });
+
+    microbench::measure("pack_text_frame 4KB", 500000, [&](size_t iters) {
+        for (size_t i = 0; i < iters; ++i)
+        {
+            std::string frame = WebSocketConnBench::pack(large_payload);
+            microbench::do_not_optimize(frame.data());
+        }
+    });
+}
@@ -0,0 +1,104 @@
+#!/bin/bash
+# 基准套件：在本机启动 web_server_stub（进程内 MySQL 桩，无需数据库），用 web_bench 依次跑固定场景，
+# 结果按提交保存为 bench_results/<短提交号>.tsv，便于逐提交对比回归。
+#
+# 用法: bench/run_bench.sh            （先用 -DDEBUG=OFF 构建 web_server_stub 与 web_bench，输出在项目根目录）
+# 环境变量:
+#   PORT=9906               服务器端口
+#   DURATION=10 WARMUP=2    每个场景的测量/预热秒数
+#   THREADS=4               web_bench 线程数
+#   SERVER_ARGS="-t 8"      额外的服务器参数（默认关闭日志 -c 1）
+#   STUB_SQL_LATENCY_US=200 桩数据库每条查询的延迟
+#   OUT_DIR=bench_results   结果目录
+#   ALLOW_DEBUG=1           允许对 Debug 构建（-O0）跑基准，默认拒绝
+set -e
+
+PROJECT_ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+cd "$PROJECT_ROOT"
+
+PORT=${PORT:-9906}
+DURATION=${DURATION:-10}
+WARMUP=${WARMUP:-2}
+THREADS=${THREADS:-4}
+SERVER_ARGS=${SERVER_ARGS:-}
+OUT_DIR=${OUT_DIR:-bench_results}
+export STUB_SQL_LATENCY_US=${STUB_SQL_LATENCY_US:-200}
+
+for bin in web_server_stub web_bench; do
+    if [ ! -x "./$bin" ]; then
+        echo "缺少 ./$bin，请先构建：cmake -S . -B build -DDEBUG=OFF && cmake --build build --target $bin" >&2
+        exit 1
+    fi
+done
+
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+if [ -n "$(git status --porcelain --untracked-files=no 2>/dev/null)" ]; then
+    COMMIT="$COMMIT-dirty"
+fi
+mkdir -p "$OUT_DIR"
+RESULT_FILE="$OUT_DIR/$COMMIT.tsv"
+
+# 场景：名称 | web_bench 参数
+SCENARIOS=(
+    "api_keepalive|-s api -c 64"
+    "api_pipeline16|-s api -c 16 -P 16"
+    "api_close|-s api -c 16 -k 0"
+    "static_index|-s static -c 64 -u /index.html"
+    "login_sql|-s login -c 32"
+    "ws_fanout|-s ws -c 64 -r 4"
+)
+
+./web_server_stub -p "$PORT" -c 1 $SERVER_ARGS > /dev/null 2>&1 &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null; wait $SERVER_PID 2>/dev/null' EXIT
+
+# 服务器的构建类型（/metrics 中的 webserver_build_info），读不到时输出为空
+server_build() {
+    (exec 3<>"/dev/tcp/127.0.0.1/$PORT" &&
+        printf 'GET /metrics HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n' >&3 &&
+        timeout 2 sed -n 's/^webserver_build_info{build_type="\([^"]*\)"}.*/\1/p' <&3) 2>/dev/null || true
+}
+
+# 等待服务器就绪（能从 /metrics 读到构建类型）；服务器退出（如端口被占用）或 5 秒内未就绪则失败
+BUILD_TYPE=
+for _ in $(seq 50); do
+    if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+        echo "web_server_stub 启动失败（端口 $PORT 是否已被占用？）" >&2
+        exit 1
+    fi
+    BUILD_TYPE=$(server_build)
+    if [ -n "$BUILD_TYPE" ]; then
+        break
+    fi
+    sleep 0.1
+done
+if [ -z "$BUILD_TYPE" ]; then
+    echo "web_server_stub 未在 5 秒内就绪（端口 $PORT）" >&2
+    exit 1
+fi
+
+# Debug 构建（-O0）的结果没有对比意义
+if [ "$BUILD_TYPE" != "Release" ]; then
+    if [ "${ALLOW_DEBUG:-0}" != 1 ]; then
+        echo "web_server_stub 是 $BUILD_TYPE 构建，请用 cmake -DDEBUG=OFF 重新构建（或设置 ALLOW_DEBUG=1 强制运行）" >&2
+        exit 1
+    fi
+    echo "警告：web_server_stub 是 $BUILD_TYPE 构建，结果不能与 Release 构建对比" >&2
+fi
+
+printf "commit\tbuild\tscenario\trps\tp50_us\tp90_us\tp99_us\tp999_us\tmax_us\tdeliveries_per_s\terrors\n" > "$RESULT_FILE"
+for entry in "${SCENARIOS[@]}"; do
+    name=${entry%%|*}
+    args=${entry#*|}
+    echo "== $name"
+    line=$(./web_bench -p "$PORT" -t "$THREADS" -d "$DURATION" -w "$WARMUP" $args | tee /dev/stderr | grep '^RESULT') || true
+    # RESULT 行为 key=value 格式，按表头顺序取值
+    value() { echo "$line" | tr ' ' '\n' | sed -n "s/^$1=//p"; }
+    printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n" "$COMMIT" "$BUILD_TYPE" "$name" "$(value rps)" "$(value p50_us)" \
+        "$(value p90_us)" "$(value p99_us)" "$(value p999_us)" "$(value max_us)" \
+        "$(value deliveries_per_s)" "$(value errors)" >> "$RESULT_FILE"
+done
+
+echo
+column -t -s $'\t' "$RESULT_FILE" 2>/dev/null || cat "$RESULT_FILE"
+echo "结果已保存到 $RESULT_FILE"
@@ -0,0 +1,137 @@
+// StubMysql.cpp
+// 基准测试用的 MySQL 客户端桩：实现 WebServer 用到的 libmysqlclient 函数，用户表保存在进程内存中，
+// 不需要数据库服务器。web_server_stub 目标链接它来代替 mysqlclient，供 bench/run_bench.sh 使用。
+//   - INSERT INTO users(username, password, email) VALUES('u', 'p', 'e')：用户名已存在时失败（同 UNIQUE 约束）
+//   - SELECT ... WHERE username='u' AND password='p'：返回 0 或 1 行
+//   - 环境变量 STUB_SQL_LATENCY_US 为每条查询附加的延迟（微秒，默认 0），模拟数据库往返
+// 只识别 Handler 发出的这两类语句，其他语句一律失败。
+
+#include <mysql/mysql.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+struct StubResult
+{
+    MYSQL_RES res;      // 必须是第一个成员，MYSQL_RES* 与 StubResult* 可互相转换
+    my_ulonglong rows;
+};
+
+std::mutex g_users_mutex;
+std::unordered_map<std::string, std::string> g_users; // username -> password
+
+// 同一连接上 mysql_query 与 mysql_store_result/mysql_error 总在同一线程先后调用
+thread_local std::string t_error;
+thread_local long long t_last_rows = -1; // 上一条语句的结果行数，-1 表示没有结果集
+
+long query_latency_us()
+{
+    static const long latency = [] {
+        const char *env = getenv("STUB_SQL_LATENCY_US");
+        return env ? atol(env) : 0L;
+    }();
+    return latency;
+}
+
+// 按出现顺序取出语句中所有单引号括起的值
+std::vector<std::string> quoted_values(const char *sql)
+{
+    std::vector<std::string> values;
+    for (const char *p = sql; *p; ++p)
+    {
+        if (*p != '\'')
+            continue;
+        const char *end = p + 1;
+        while (*end && *end != '\'')
+            ++end;
+        values.emplace_back(p + 1, end);
+        if (!*end)
+            break;
+        p = end;
+    }
+    return values;
+}
+
+} // namespace
+
+extern "C" {
+
+MYSQL *mysql_init(MYSQL *mysql)
+{
+    // SqlConnectionPool 总是传入 NULL，由 mysql_close 释放
+    return mysql ? mysql : (MYSQL *)calloc(1, sizeof(MYSQL));
+}
+
+MYSQL *mysql_real_connect(MYSQL *mysql, const char *, const char *, const char *, const char *,
+                          unsigned int, const char *, unsigned long)
+{
+    return mysql;
+}
+
+int mysql_query(MYSQL *, const char *sql)
+{
+    long latency = query_latency_us();
+    if (latency > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(latency));
+
+    t_last_rows = -1;
+    std::vector<std::string> values = quoted_values(sql);
+    if (strncasecmp(sql, "INSERT", 6) == 0 && values.size() >= 2)
+    {
+        std::lock_guard<std::mutex> lock(g_users_mutex);
+        if (!g_users.emplace(values[0], values[1]).second)
+        {
+            t_error = "Duplicate entry '" + values[0] + "' for key 'users.username'";
+            return 1;
+        }
+        return 0;
+    }
+    if (strncasecmp(sql, "SELECT", 6) == 0 && values.size() >= 2)
+    {
+        std::lock_guard<std::mutex> lock(g_users_mutex);
+        auto it = g_users.find(values[0]);
+        t_last_rows = it != g_users.end() && it->second == values[1] ? 1 : 0;
+        return 0;
+    }
+    t_error = "stub mysql: unsupported statement";
+    return 1;
+}
+
+const char *mysql_error(MYSQL *)
+{
+    return t_error.c_str();
+}
+
+MYSQL_RES *mysql_store_result(MYSQL *)
+{
+    if (t_last_rows < 0)
+        return nullptr;
+    StubResult *result = (StubResult *)calloc(1, sizeof(StubResult));
+    result->rows = (my_ulonglong)t_last_rows;
+    return &result->res;
+}
+
+my_ulonglong mysql_num_rows(MYSQL_RES *res)
+{
+    return ((StubResult *)res)->rows;
+}
+
+void mysql_free_result(MYSQL_RES *res)
+{
+    free(res);
+}
+
+void mysql_close(MYSQL *mysql)
+{
+    free(mysql);
+}
+
+} // extern "C"
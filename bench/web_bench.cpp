@@ -0,0 +1,837 @@
+// web_bench.cpp
+// 多线程 epoll HTTP/WebSocket 负载生成器，输出吞吐与 HDR 延迟分位数
+//   - 每个线程一个 epoll，负责 -c/-t 个连接；连接使用非阻塞 socket、ET 模式
+//   - HTTP 场景：每个连接保持 -P 个在途请求（管线化），-k 0 时每个请求新建一条连接（含建连耗时）
+//   - WebSocket 场景：每个连接先注册、登录、升级、认证并加入房间（不计时），
+//     之后循环发送聊天消息，统计自己消息经房间广播回显的延迟，以及收到的全部帧数（扇出）
+//   - 延迟从请求写入发送缓冲区起算，到完整响应读完为止；只统计预热结束后发出、测试结束前完成的请求
+//   - 最后一行 RESULT 为 key=value 格式，供 bench/run_bench.sh 汇总
+//
+// 用法: ./web_bench [-h 主机IPv4] [-p 端口] [-s 场景] [-c 连接数] [-t 线程数] [-d 秒] [-w 预热秒]
+//                   [-P 管线深度] [-k 0|1] [-u 路径] [-r 房间数] [-m 消息字节数]
+//   场景: api     GET /api/test（默认）
+//         static  GET -u 指定的静态文件（默认 /index.html）
+//         login   POST 表单登录（Pool 路由 + 数据库），测试开始前先为每个连接注册用户
+//         ws      WebSocket 聊天室，连接按编号均分到 -r 个房间
+
+#include "metrics/Metrics.h"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class Scenario { Api, Static, Login, Ws };
+
+struct BenchConfig
+{
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    Scenario scenario = Scenario::Api;
+    const char *scenario_name = "api";
+    std::string path;       // 为空时按场景取默认路径
+    int connections = 64;
+    int threads = 4;
+    int duration = 10;
+    int warmup = 2;
+    int pipeline = 1;
+    int keep_alive = 1;
+    int rooms = 4;
+    int message_size = 64;
+};
+
+static BenchConfig g_cfg;
+static sockaddr_in g_addr;
+static std::atomic<int> g_ready{0};         // 完成准备阶段的线程数
+static std::atomic<bool> g_go{false};
+static uint64_t g_measure_start = 0;        // 统计窗口（CLOCK_MONOTONIC 纳秒）
+static uint64_t g_measure_end = 0;
+
+static const char BENCH_PASSWORD[] = "bench";
+static const size_t READ_CHUNK = 64 * 1024;
+
+struct Conn
+{
+    int fd = -1;
+    int id = 0;
+    bool connecting = false;
+    std::string out;            // 待发送的字节
+    size_t out_off = 0;
+    std::string in;             // 已接收、尚未解析的字节
+    size_t in_off = 0;
+    bool in_body = false;       // HTTP：正在跳过响应体
+    uint64_t body_left = 0;
+    int status = 0;
+    bool close_after = false;   // HTTP：响应带 Connection: close
+    std::deque<uint64_t> sent;  // 在途请求/消息的发送时刻，响应按顺序返回
+    std::string request;        // HTTP：预先拼好的请求
+    std::string username;       // login/ws：注册的用户名
+    std::string room;           // ws：所在房间
+    std::string marker;         // ws：自己消息内容的前缀，用于识别回显
+    uint64_t seq = 0;
+};
+
+struct Worker
+{
+    int id = 0;
+    int epfd = -1;
+    std::thread thread;
+    std::vector<std::unique_ptr<Conn>> conns;
+    Histogram latency;          // 纳秒
+    uint64_t max_ns = 0;
+    uint64_t completed = 0;     // 窗口内完成的请求（ws 为自己消息的回显）
+    uint64_t failed = 0;        // 窗口内状态码 >= 400 的响应
+    uint64_t sock_errors = 0;   // 连接出错或被对端意外关闭
+    uint64_t connects = 0;      // 建立的连接数（-k 0 时每个请求一条）
+    uint64_t bytes_in = 0;      // 窗口内接收的字节
+    uint64_t deliveries = 0;    // ws：窗口内收到的文本帧
+    bool setup_ok = true;
+};
+
+static uint64_t now_ns() { return Metrics::now_ns(); }
+
+static bool in_window(uint64_t sent, uint64_t done)
+{
+    return sent >= g_measure_start && done <= g_measure_end;
+}
+
+static void record(Worker &w, uint64_t sent, uint64_t done, int status)
+{
+    if (!in_window(sent, done))
+        return;
+    uint64_t ns = done - sent;
+    w.latency.record(ns);
+    w.max_ns = std::max(w.max_ns, ns);
+    ++w.completed;
+    if (status >= 400)
+        ++w.failed;
+}
+
+// ---------------------------------------------------------------------------
+// 准备阶段用的阻塞式 HTTP/WebSocket 辅助函数
+// ---------------------------------------------------------------------------
+
+static int connect_blocking()
+{
+    int fd = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    timeval tv{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (connect(fd, (sockaddr *)&g_addr, sizeof(g_addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const std::string &data)
+{
+    size_t off = 0;
+    while (off < data.size())
+    {
+        ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        off += n;
+    }
+    return true;
+}
+
+// 响应头中的 Content-Length 与 Connection: close
+static void parse_headers(const char *begin, const char *end, uint64_t &content_length, bool &close)
+{
+    content_length = 0;
+    close = false;
+    const char *line = (const char *)memchr(begin, '\n', end - begin);
+    while (line && line + 1 < end)
+    {
+        const char *p = line + 1;
+        line = (const char *)memchr(p, '\n', end - p);
+        size_t len = (line ? line : end) - p;
+        if (len > 15 && strncasecmp(p, "Content-Length:", 15) == 0)
+            content_length = strtoull(p + 15, nullptr, 10);
+        else if (len > 11 && strncasecmp(p, "Connection:", 11) == 0)
+            close = memmem(p + 11, len - 11, "close", 5) != nullptr;
+    }
+}
+
+// 发送请求并读取一个完整响应，剩余字节留在 rest 中（升级为 WebSocket 后服务器可能紧接着发帧）
+static bool roundtrip(int fd, const std::string &request, int &status, std::string &body, std::string &rest)
+{
+    if (!send_all(fd, request))
+        return false;
+    std::string in;
+    char buf[4096];
+    size_t header_end;
+    while ((header_end = in.find("\r\n\r\n")) == std::string::npos)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        in.append(buf, n);
+    }
+    status = in.size() > 12 ? atoi(in.c_str() + 9) : 0;
+    uint64_t content_length;
+    bool close;
+    parse_headers(in.data(), in.data() + header_end, content_length, close);
+    size_t body_begin = header_end + 4;
+    while (in.size() < body_begin + content_length)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        in.append(buf, n);
+    }
+    body = in.substr(body_begin, content_length);
+    rest = in.substr(body_begin + content_length);
+    return true;
+}
+
+static std::string form_post(const char *path, const std::string &body)
+{
+    return std::string("POST ") + path + " HTTP/1.1\r\nHost: " + g_cfg.host +
+           "\r\nContent-Type: application/x-www-form-urlencoded\r\nContent-Length: " +
+           std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+static std::string register_request(const Conn &c)
+{
+    return form_post("/api/register", "username=" + c.username + "&password=" + BENCH_PASSWORD +
+                                          "&email=" + c.username + "%40bench.local");
+}
+
+static std::string login_request(const Conn &c)
+{
+    return form_post("/api/auth/login", "username=" + c.username + "&password=" + BENCH_PASSWORD);
+}
+
+// 客户端帧必须加掩码（RFC 6455 5.3）
+static void append_ws_frame(std::string &out, const std::string &payload)
+{
+    static const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    size_t n = payload.size();
+    out += (char)0x81; // FIN + text
+    if (n < 126)
+    {
+        out += (char)(0x80 | n);
+    }
+    else if (n < 65536)
+    {
+        out += (char)(0x80 | 126);
+        out += (char)(n >> 8);
+        out += (char)(n & 0xff);
+    }
+    else
+    {
+        out += (char)(0x80 | 127);
+        for (int i = 7; i >= 0; --i)
+            out += (char)((n >> (8 * i)) & 0xff);
+    }
+    out.append((const char *)mask, 4);
+    for (size_t i = 0; i < n; ++i)
+        out += (char)(payload[i] ^ mask[i & 3]);
+}
+
+// 从 in[off:] 解析一个服务器帧：完整时返回 true 并推进 off；不完整返回 false
+static bool next_ws_frame(const std::string &in, size_t &off, int &opcode, std::string &payload)
+{
+    size_t avail = in.size() - off;
+    if (avail < 2)
+        return false;
+    const unsigned char *p = (const unsigned char *)in.data() + off;
+    opcode = p[0] & 0x0f;
+    bool masked = p[1] & 0x80;
+    uint64_t len = p[1] & 0x7f;
+    size_t header = 2;
+    if (len == 126)
+    {
+        if (avail < 4)
+            return false;
+        len = ((uint64_t)p[2] << 8) | p[3];
+        header = 4;
+    }
+    else if (len == 127)
+    {
+        if (avail < 10)
+            return false;
+        len = 0;
+        for (int i = 0; i < 8; ++i)
+            len = (len << 8) | p[2 + i];
+        header = 10;
+    }
+    size_t mask_at = header;
+    if (masked)
+        header += 4;
+    if (avail < header + len)
+        return false;
+    payload.assign((const char *)p + header, len);
+    if (masked)
+    {
+        for (size_t i = 0; i < len; ++i)
+            payload[i] ^= p[mask_at + (i & 3)];
+    }
+    off += header + len;
+    return true;
+}
+
+// ws 场景的准备：注册 -> 登录 -> 升级 -> 认证 -> 加入房间，完成后 fd 交给 epoll
+static bool setup_ws(Conn &c)
+{
+    int fd = connect_blocking();
+    if (fd < 0)
+        return false;
+
+    int status;
+    std::string body, rest;
+    // 用户已存在时注册失败，忽略
+    if (!roundtrip(fd, register_request(c), status, body, rest) ||
+        !roundtrip(fd, login_request(c), status, body, rest) || status != 200)
+    {
+        fprintf(stderr, "ws setup: login of %s failed (status %d)\n", c.username.c_str(), status);
+        close(fd);
+        return false;
+    }
+    size_t sid = body.find("\"sessionId\":\"");
+    if (sid == std::string::npos)
+    {
+        close(fd);
+        return false;
+    }
+    sid += 13;
+    std::string session = body.substr(sid, body.find('"', sid) - sid);
+
+    std::string upgrade = "GET /api/upgrade HTTP/1.1\r\nHost: " + g_cfg.host +
+                          "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    if (!roundtrip(fd, upgrade, status, body, rest) || status != 101)
+    {
+        fprintf(stderr, "ws setup: upgrade failed (status %d)\n", status);
+        close(fd);
+        return false;
+    }
+
+    std::string out;
+    append_ws_frame(out, "{\"type\":\"auth\",\"sessionid\":\"" + session + "\"}");
+    if (!send_all(fd, out))
+    {
+        close(fd);
+        return false;
+    }
+    // 等待认证结果，之后的帧留给事件循环
+    c.in = rest;
+    c.in_off = 0;
+    bool authed = false;
+    char buf[4096];
+    while (!authed)
+    {
+        int opcode;
+        std::string payload;
+        while (!authed && next_ws_frame(c.in, c.in_off, opcode, payload))
+            authed = payload.find("Authentication successful") != std::string::npos;
+        if (authed)
+            break;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+            fprintf(stderr, "ws setup: no auth reply for %s\n", c.username.c_str());
+            close(fd);
+            return false;
+        }
+        c.in.append(buf, n);
+    }
+    c.in.erase(0, c.in_off);
+    c.in_off = 0;
+
+    out.clear();
+    append_ws_frame(out, "{\"type\":\"room\",\"action\":\"join\",\"room\":\"" + c.room + "\"}");
+    if (!send_all(fd, out))
+    {
+        close(fd);
+        return false;
+    }
+    c.fd = fd;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// 事件循环
+// ---------------------------------------------------------------------------
+
+static void add_to_epoll(Worker &w, Conn &c)
+{
+    fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL) | O_NONBLOCK);
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+    ev.data.ptr = &c;
+    epoll_ctl(w.epfd, EPOLL_CTL_ADD, c.fd, &ev);
+}
+
+static void close_conn(Worker &w, Conn &c)
+{
+    if (c.fd < 0)
+        return;
+    epoll_ctl(w.epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    c.fd = -1;
+}
+
+// 排满在途请求（-k 0 时在建连之前就排好，延迟包含建连）
+static void fill(Conn &c)
+{
+    int depth = g_cfg.scenario == Scenario::Ws || g_cfg.keep_alive ? g_cfg.pipeline : 1;
+    while ((int)c.sent.size() < depth)
+    {
+        if (g_cfg.scenario == Scenario::Ws)
+        {
+            std::string content = c.marker + std::to_string(c.seq++);
+            if ((int)content.size() < g_cfg.message_size)
+                content.append(g_cfg.message_size - content.size(), 'x');
+            append_ws_frame(c.out, "{\"type\":\"chat\",\"subtype\":\"room_msg\",\"room\":\"" + c.room +
+                                       "\",\"from\":\"" + c.username + "\",\"content\":\"" + content + "\"}");
+        }
+        else
+        {
+            c.out += c.request;
+        }
+        c.sent.push_back(now_ns());
+    }
+}
+
+// 发送缓冲区中的数据：出错返回 false
+static bool flush(Conn &c)
+{
+    if (c.connecting)
+        return true;
+    while (c.out_off < c.out.size())
+    {
+        ssize_t n = send(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off, MSG_NOSIGNAL);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        c.out_off += n;
+    }
+    c.out.clear();
+    c.out_off = 0;
+    return true;
+}
+
+static bool open_conn(Worker &w, Conn &c)
+{
+    c.fd = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c.fd < 0)
+        return false;
+    int on = 1;
+    setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    c.out.clear();
+    c.out_off = 0;
+    c.in.clear();
+    c.in_off = 0;
+    c.in_body = false;
+    c.sent.clear();
+    fill(c);
+    int ret = connect(c.fd, (sockaddr *)&g_addr, sizeof(g_addr));
+    if (ret < 0 && errno != EINPROGRESS)
+    {
+        close(c.fd);
+        c.fd = -1;
+        return false;
+    }
+    c.connecting = ret < 0;
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+    ev.data.ptr = &c;
+    epoll_ctl(w.epfd, EPOLL_CTL_ADD, c.fd, &ev);
+    ++w.connects;
+    return flush(c);
+}
+
+static void reopen(Worker &w, Conn &c, bool error)
+{
+    close_conn(w, c);
+    if (error)
+        ++w.sock_errors;
+    if (!open_conn(w, c))
+    {
+        ++w.sock_errors;
+        close_conn(w, c);
+    }
+}
+
+// 解析已接收的 HTTP 响应；需要重新建连时返回 false
+static bool parse_http(Worker &w, Conn &c)
+{
+    while (true)
+    {
+        if (!c.in_body)
+        {
+            size_t end = c.in.find("\r\n\r\n", c.in_off);
+            if (end == std::string::npos)
+                break;
+            const char *head = c.in.data() + c.in_off;
+            c.status = end - c.in_off > 12 ? atoi(head + 9) : 0;
+            bool close;
+            parse_headers(head, c.in.data() + end, c.body_left, close);
+            c.close_after = close;
+            c.in_off = end + 4;
+            c.in_body = true;
+        }
+        // 响应体只跳过，不保存
+        uint64_t n = std::min<uint64_t>(c.body_left, c.in.size() - c.in_off);
+        c.in_off += n;
+        c.body_left -= n;
+        if (c.body_left > 0)
+            break;
+        c.in_body = false;
+
+        if (c.sent.empty())
+            return false; // 没有在途请求却收到响应
+        record(w, c.sent.front(), now_ns(), c.status);
+        c.sent.pop_front();
+        if (c.close_after || !g_cfg.keep_alive)
+            return false;
+    }
+    c.in.erase(0, c.in_off);
+    c.in_off = 0;
+    return true;
+}
+
+// 解析已接收的 WebSocket 帧；服务器关闭连接时返回 false
+static bool parse_ws(Worker &w, Conn &c)
+{
+    int opcode;
+    std::string payload;
+    uint64_t now = now_ns();
+    while (next_ws_frame(c.in, c.in_off, opcode, payload))
+    {
+        if (opcode == 0x8)
+            return false;
+        if (opcode != 0x1)
+            continue;
+        if (now >= g_measure_start && now <= g_measure_end)
+            ++w.deliveries;
+        if (!c.sent.empty() && payload.find(c.marker) != std::string::npos)
+        {
+            record(w, c.sent.front(), now, 200);
+            c.sent.pop_front();
+        }
+    }
+    c.in.erase(0, c.in_off);
+    c.in_off = 0;
+    return true;
+}
+
+static void handle_event(Worker &w, Conn &c, uint32_t events, char *buf)
+{
+    if (c.connecting && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0)
+        {
+            reopen(w, c, true);
+            return;
+        }
+        c.connecting = false;
+    }
+
+    if (events & EPOLLIN)
+    {
+        bool peer_closed = false;
+        while (true)
+        {
+            ssize_t n = recv(c.fd, buf, READ_CHUNK, 0);
+            if (n > 0)
+            {
+                uint64_t now = now_ns();
+                if (now >= g_measure_start && now <= g_measure_end)
+                    w.bytes_in += n;
+                c.in.append(buf, n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            peer_closed = true;
+            break;
+        }
+        bool ok = g_cfg.scenario == Scenario::Ws ? parse_ws(w, c) : parse_http(w, c);
+        if (!ok || peer_closed)
+        {
+            if (g_cfg.scenario == Scenario::Ws)
+            {
+                // WebSocket 连接断开后不再重建（需要重新登录）
+                ++w.sock_errors;
+                close_conn(w, c);
+                return;
+            }
+            // 响应完整且按约定关闭（-k 0 / Connection: close）不算错误
+            bool planned = c.sent.empty() || (!ok && (c.close_after || !g_cfg.keep_alive));
+            reopen(w, c, !planned);
+            return;
+        }
+    }
+    else if (events & (EPOLLERR | EPOLLHUP))
+    {
+        if (g_cfg.scenario == Scenario::Ws)
+        {
+            ++w.sock_errors;
+            close_conn(w, c);
+        }
+        else
+        {
+            reopen(w, c, true);
+        }
+        return;
+    }
+
+    fill(c);
+    if (!flush(c))
+    {
+        if (g_cfg.scenario == Scenario::Ws)
+        {
+            ++w.sock_errors;
+            close_conn(w, c);
+        }
+        else
+        {
+            reopen(w, c, true);
+        }
+    }
+}
+
+static void run_worker(Worker &w)
+{
+    w.epfd = epoll_create1(EPOLL_CLOEXEC);
+
+    // 1. 准备阶段（不计时）
+    for (auto &c : w.conns)
+    {
+        if (g_cfg.scenario == Scenario::Login)
+        {
+            int fd = connect_blocking();
+            int status;
+            std::string body, rest;
+            if (fd < 0 || !roundtrip(fd, register_request(*c), status, body, rest))
+                w.setup_ok = false;
+            if (fd >= 0)
+                close(fd);
+        }
+        else if (g_cfg.scenario == Scenario::Ws)
+        {
+            if (!setup_ws(*c))
+                w.setup_ok = false;
+        }
+    }
+    g_ready.fetch_add(1);
+    while (!g_go.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // 2. 开始施压
+    for (auto &c : w.conns)
+    {
+        if (g_cfg.scenario == Scenario::Ws)
+        {
+            if (c->fd < 0)
+                continue;
+            add_to_epoll(w, *c);
+            ++w.connects;
+            fill(*c);
+            if (!flush(*c))
+                close_conn(w, *c);
+        }
+        else if (!open_conn(w, *c))
+        {
+            ++w.sock_errors;
+            close_conn(w, *c);
+        }
+    }
+
+    std::vector<epoll_event> events(256);
+    std::unique_ptr<char[]> buf(new char[READ_CHUNK]);
+    while (now_ns() < g_measure_end)
+    {
+        int n = epoll_wait(w.epfd, events.data(), (int)events.size(), 10);
+        for (int i = 0; i < n; ++i)
+        {
+            Conn &c = *(Conn *)events[i].data.ptr;
+            if (c.fd >= 0)
+                handle_event(w, c, events[i].events, buf.get());
+        }
+    }
+
+    for (auto &c : w.conns)
+        close_conn(w, *c);
+    close(w.epfd);
+}
+
+// HDR 直方图的分位数（返回所在桶的上界，误差不超过 1/16，且不超过实际最大值）
+static uint64_t percentile(const HistogramSnapshot &h, uint64_t max, double q)
+{
+    if (h.count == 0)
+        return 0;
+    uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(q * h.count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; ++i)
+    {
+        seen += h.counts[i];
+        if (seen >= target)
+            return std::min(max, Histogram::bucket_upper(i) - 1);
+    }
+    return max;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-h host] [-p port] [-s api|static|login|ws] [-c connections] [-t threads]\n"
+            "          [-d seconds] [-w warmup_seconds] [-P pipeline] [-k 0|1] [-u path] [-r rooms] [-m msg_bytes]\n",
+            prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:s:c:t:d:w:P:k:u:r:m:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'h': g_cfg.host = optarg; break;
+        case 'p': g_cfg.port = atoi(optarg); break;
+        case 's':
+            g_cfg.scenario_name = optarg;
+            if (strcmp(optarg, "api") == 0) g_cfg.scenario = Scenario::Api;
+            else if (strcmp(optarg, "static") == 0) g_cfg.scenario = Scenario::Static;
+            else if (strcmp(optarg, "login") == 0) g_cfg.scenario = Scenario::Login;
+            else if (strcmp(optarg, "ws") == 0) g_cfg.scenario = Scenario::Ws;
+            else usage(argv[0]);
+            break;
+        case 'c': g_cfg.connections = atoi(optarg); break;
+        case 't': g_cfg.threads = atoi(optarg); break;
+        case 'd': g_cfg.duration = atoi(optarg); break;
+        case 'w': g_cfg.warmup = atoi(optarg); break;
+        case 'P': g_cfg.pipeline = atoi(optarg); break;
+        case 'k': g_cfg.keep_alive = atoi(optarg); break;
+        case 'u': g_cfg.path = optarg; break;
+        case 'r': g_cfg.rooms = atoi(optarg); break;
+        case 'm': g_cfg.message_size = atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+    if (g_cfg.connections <= 0 || g_cfg.threads <= 0 || g_cfg.duration <= 0 || g_cfg.pipeline <= 0 ||
+        g_cfg.rooms <= 0 || g_cfg.warmup < 0)
+        usage(argv[0]);
+    g_cfg.threads = std::min(g_cfg.threads, g_cfg.connections);
+
+    memset(&g_addr, 0, sizeof(g_addr));
+    g_addr.sin_family = AF_INET;
+    g_addr.sin_port = htons(g_cfg.port);
+    if (inet_pton(AF_INET, g_cfg.host.c_str(), &g_addr.sin_addr) != 1)
+    {
+        fprintf(stderr, "invalid IPv4 address: %s\n", g_cfg.host.c_str());
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (g_cfg.path.empty())
+        g_cfg.path = g_cfg.scenario == Scenario::Static ? "/index.html" : "/api/test";
+    std::string get = "GET " + g_cfg.path + " HTTP/1.1\r\nHost: " + g_cfg.host + "\r\n" +
+                      (g_cfg.keep_alive ? "" : "Connection: close\r\n") + "\r\n";
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < g_cfg.threads; ++t)
+    {
+        workers.emplace_back(new Worker());
+        workers.back()->id = t;
+    }
+    for (int i = 0; i < g_cfg.connections; ++i)
+    {
+        std::unique_ptr<Conn> c(new Conn());
+        c->id = i;
+        c->username = "bench" + std::to_string(i);
+        c->room = "bench" + std::to_string(i % g_cfg.rooms);
+        c->marker = "bench:" + std::to_string(i) + ":";
+        c->request = g_cfg.scenario == Scenario::Login ? login_request(*c) : get;
+        if (g_cfg.scenario == Scenario::Login && !g_cfg.keep_alive)
+            c->request.insert(c->request.find("\r\n\r\n") + 2, "Connection: close\r\n");
+        workers[i % g_cfg.threads]->conns.push_back(std::move(c));
+    }
+
+    printf("web_bench: %s %s:%d, %d connections, %d threads, pipeline %d, %s, %ds (warmup %ds)\n",
+           g_cfg.scenario_name, g_cfg.host.c_str(), g_cfg.port, g_cfg.connections, g_cfg.threads, g_cfg.pipeline,
+           g_cfg.keep_alive ? "keep-alive" : "connection per request", g_cfg.duration, g_cfg.warmup);
+    if (g_cfg.scenario == Scenario::Ws)
+        printf("  %d rooms, %d-byte messages\n", g_cfg.rooms, g_cfg.message_size);
+    fflush(stdout);
+
+    g_measure_end = UINT64_MAX;
+    for (auto &w : workers)
+        w->thread = std::thread(run_worker, std::ref(*w));
+    while (g_ready.load() < g_cfg.threads)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    g_measure_start = now_ns() + (uint64_t)g_cfg.warmup * 1000000000ull;
+    g_measure_end = g_measure_start + (uint64_t)g_cfg.duration * 1000000000ull;
+    g_go.store(true);
+    for (auto &w : workers)
+        w->thread.join();
+
+    // 汇总
+    HistogramSnapshot latency;
+    uint64_t max_ns = 0, completed = 0, failed = 0, sock_errors = 0, connects = 0, bytes_in = 0, deliveries = 0;
+    bool setup_ok = true;
+    for (auto &w : workers)
+    {
+        latency.add(w->latency);
+        max_ns = std::max(max_ns, w->max_ns);
+        completed += w->completed;
+        failed += w->failed;
+        sock_errors += w->sock_errors;
+        connects += w->connects;
+        bytes_in += w->bytes_in;
+        deliveries += w->deliveries;
+        setup_ok = setup_ok && w->setup_ok;
+    }
+    if (!setup_ok)
+        fprintf(stderr, "warning: setup failed for some connections\n");
+
+    double secs = g_cfg.duration;
+    double rps = completed / secs;
+    double p50 = percentile(latency, max_ns, 0.50) / 1000.0;
+    double p90 = percentile(latency, max_ns, 0.90) / 1000.0;
+    double p99 = percentile(latency, max_ns, 0.99) / 1000.0;
+    double p999 = percentile(latency, max_ns, 0.999) / 1000.0;
+    double mean = latency.count ? latency.sum / 1000.0 / latency.count : 0;
+
+    printf("  %-12s %12llu  %12.1f /s  %8.2f MB/s in\n", g_cfg.scenario == Scenario::Ws ? "messages" : "requests",
+           (unsigned long long)completed, rps, bytes_in / secs / (1024 * 1024));
+    if (g_cfg.scenario == Scenario::Ws)
+        printf("  %-12s %12llu  %12.1f /s\n", "deliveries", (unsigned long long)deliveries, deliveries / secs);
+    printf("  latency(us)  mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           mean, p50, p90, p99, p999, max_ns / 1000.0);
+    printf("  status>=400 %llu, socket errors %llu, connections %llu\n",
+           (unsigned long long)failed, (unsigned long long)sock_errors, (unsigned long long)connects);
+    printf("RESULT scenario=%s conns=%d pipeline=%d keepalive=%d rps=%.1f p50_us=%.1f p90_us=%.1f p99_us=%.1f "
+           "p999_us=%.1f max_us=%.1f deliveries_per_s=%.1f errors=%llu\n",
+           g_cfg.scenario_name, g_cfg.connections, g_cfg.pipeline, g_cfg.keep_alive, rps, p50, p90, p99, p999,
+           max_ns / 1000.0, deliveries / secs, (unsigned long long)(failed + sock_errors));
+    return failed + sock_errors == 0 && setup_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
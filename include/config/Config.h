@@ -22,6 +22,34 @@ public:
 
     //是否关闭日志
     int close_log;
+
+    //连接接收模式：0=主 Reactor 统一 accept，1=SO_REUSEPORT 多 acceptor，2=在 1 的基础上附加 CBPF 按 CPU 分发
+    int reuse_port;
+
+    //静态文件缓存容量（MB），0 表示关闭
+    int file_cache_mb;
+
+    //连接各阶段的超时（毫秒）与请求体最低速率（字节/秒）
+    int header_timeout_ms;
+    int body_timeout_ms;
+    int body_min_rate;
+    int idle_timeout_ms;
+    int write_timeout_ms;
+
+    //日志缓冲区写满时：0=丢弃并计数，1=阻塞等待写线程
+    int log_block;
+
+    //运行期最低日志级别：0=debug 1=info 2=warn 3=error
+    int log_level;
+
+    //请求追踪采样率：每 N 个请求采样一个，0 表示关闭
+    int trace_sample;
+
+    //BufferPool 的 arena 是否使用透明大页：0=否，1=是
+    int buffer_hugepages;
+
+    //管理接口 /admin/trace：0=关闭，1=仅允许本机（127.0.0.0/8）访问，2=允许任意地址访问
+    int admin_trace;
 };
 
 #endif
\ No newline at end of file
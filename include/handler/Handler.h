@@ -43,4 +43,21 @@ HttpResponse handle_simple_json_get(const HttpRequest& req, RequestContext& ctx)
  */
 HttpResponse handle_websocket_upgrade(const HttpRequest& req, RequestContext& ctx);
 
+/**
+ * @brief 以 Prometheus 文本格式导出运行时指标
+ */
+HttpResponse handle_metrics(const HttpRequest& req, RequestContext& ctx);
+
+/**
+ * @brief 导出采样请求的阶段耗时：默认为文本，?format=chrome 为 Chrome trace-event JSON，?limit=N 限制条数
+ */
+HttpResponse handle_trace(const HttpRequest& req, RequestContext& ctx);
+
+/**
+ * @brief 注册服务器的全部路由（WebServer::init 与 micro_bench 共用同一张路由表）
+ * @param router 目标路由
+ * @param admin_trace 是否注册管理接口 /admin/trace
+ */
+void register_routes(Router& router, bool admin_trace);
+
 #endif // HANDLER_H
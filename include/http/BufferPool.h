@@ -1,11 +1,52 @@
 #pragma once
 
-#include <vector>
-#include <stack>
-#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include "../thread_pool/IndexStack.h"
+
+// 缓冲区池：按尺寸等级分配的 slab 分配器，HttpConnection 的读写缓冲区通过 PoolAllocator 从这里取内存
+// - 每个等级预留一段连续虚拟地址（arena，MAP_NORESERVE），按块顺序切分；块归还后只在池内复用，不还给系统
+// - 每个线程为每个等级缓存两个弹匣（magazine）：分配/释放只操作本线程的弹匣，没有锁和原子操作
+// - 两个弹匣都满/都空时与全局仓库（depot）交换整个弹匣，仓库是带版本号的无锁栈（IndexStack），
+//   因此在一个线程释放、另一个线程分配的缓冲区也能在线程之间流动
+// - 超过最大等级的请求，以及 arena 用尽或预留失败时的请求，直接使用 operator new
+// - 可选用透明大页承载 arena（set_hugepages），减少 TLB 缺失
+
+const size_t BUFFER_CLASS_COUNT = 4;
+constexpr size_t BUFFER_CLASS_SIZES[BUFFER_CLASS_COUNT] = {4 * 1024, 16 * 1024, 64 * 1024, 128 * 1024};
+const size_t BUFFER_MAGAZINE_SIZE = 32;             // 每个弹匣的块数
+const size_t BUFFER_ARENA_BYTES = size_t(1) << 30;  // 每个等级预留的虚拟地址空间
+const size_t BUFFER_MAX_CACHES = 512;               // 拥有线程缓存的线程数上限，超出的线程走加锁的慢路径
+
+// 某个尺寸等级的统计
+struct BufferClassStats {
+    uint64_t allocs = 0;            // 分配次数（含 arena 用尽后的 operator new）
+    uint64_t frees = 0;             // 释放次数
+    uint64_t depot_gets = 0;        // 线程缓存从仓库取弹匣的次数
+    uint64_t depot_puts = 0;        // 线程缓存向仓库交满弹匣的次数
+    uint64_t arena_blocks = 0;      // 已从 arena 切出的块数
+    uint64_t depot_magazines = 0;   // 仓库中的弹匣数
+};
+
+struct BufferPoolStats {
+    BufferClassStats classes[BUFFER_CLASS_COUNT];
+    uint64_t oversize_allocs = 0;   // 超过最大等级的分配
+    uint64_t fallback_allocs = 0;   // arena 用尽或不可用时的分配
+    bool hugepages = false;
+};
+
+template <class T>
+struct PoolAllocator;
+
+// HttpConnection 读写缓冲区的类型
+using PoolBuffer = std::vector<char, PoolAllocator<char>>;
+
+struct BufferThreadCache;
 
-// 缓冲区池，用于复用缓冲区内存
 class BufferPool {
 public:
     static BufferPool& get_instance() {
@@ -13,54 +54,119 @@ public:
         return *instance;  // 永不析构，程序退出后由 OS 回收
     }
 
-    // 获取一个缓冲区
-    std::vector<char> acquire(size_t size = 4096) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        
-        if (!m_buffers.empty()) {
-            auto buffer = std::move(m_buffers.top());
-            m_buffers.pop();
-            buffer.clear();
-            if (buffer.capacity() < size) {
-                buffer.reserve(size);
+    /**
+     * @brief 分配至少 size 字节：不超过 128K 时取所属等级的一个块
+     * @param size 请求的字节数，释放时必须传入相同的值
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief 释放 allocate 得到的内存
+     * @param size 分配时传入的字节数
+     */
+    void deallocate(void* p, size_t size) noexcept;
+
+    // 获取一个容量至少为 size 的空缓冲区
+    PoolBuffer acquire(size_t size = 4096);
+
+    // 归还缓冲区：释放其内存回池中
+    void release(PoolBuffer&& buffer);
+
+    /**
+     * @brief 对 arena 启用/关闭透明大页（madvise MADV_HUGEPAGE），只影响之后才触及的页
+     * @return 是否设置成功（内核未开启 THP 时失败，保持普通页）
+     */
+    bool set_hugepages(bool enable);
+
+    // 把当前线程缓存的弹匣还给仓库，线程退出时自动调用
+    void flush_thread_cache();
+
+    // 汇总所有线程缓存与仓库的统计
+    BufferPoolStats stats();
+
+    // size 所属的尺寸等级，超过最大等级返回 -1
+    static int size_class(size_t size) {
+        for (size_t i = 0; i < BUFFER_CLASS_COUNT; ++i) {
+            if (size <= BUFFER_CLASS_SIZES[i]) {
+                return (int)i;
             }
-            return buffer;
         }
-        
-        std::vector<char> buffer;
-        buffer.reserve(size);
-        return buffer;
+        return -1;
     }
 
-    // 释放缓冲区回池中
-    void release(std::vector<char>&& buffer) {
-        if (buffer.capacity() < MIN_BUFFER_SIZE || buffer.capacity() > MAX_BUFFER_SIZE) {
-            // 缓冲区太小或太大，直接丢弃
-            return;
-        }
-        
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_buffers.size() < MAX_POOL_SIZE) {
-            buffer.clear();
-            m_buffers.push(std::move(buffer));
-        }
+private:
+    BufferPool();
+    ~BufferPool();
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    struct Magazine {
+        uint32_t count;
+        void* slots[BUFFER_MAGAZINE_SIZE];
+    };
+
+    struct SizeClass {
+        char* base = nullptr;                       // arena 起始地址，nullptr 表示预留失败
+        size_t block_count = 0;
+        std::atomic<size_t> next_block{0};          // 下一个未切分的块
+        std::unique_ptr<Magazine[]> magazines;
+        std::unique_ptr<IndexStack> depot;          // 仓库：有块的弹匣
+        std::unique_ptr<IndexStack> empty;          // 空弹匣
+        std::atomic<int64_t> depot_count{0};        // 先出栈后计数，可能短暂为负
+        std::atomic<uint64_t> slow_allocs{0};       // 没有线程缓存时的分配/释放
+        std::atomic<uint64_t> slow_frees{0};
+        Magazine spill;                             // 没有线程缓存时使用，受 m_spill_mutex 保护
+    };
+
+    BufferThreadCache* local_cache();
+    BufferThreadCache* create_cache();
+    Magazine& magazine(size_t cls, uint32_t idx) { return m_classes[cls].magazines[idx]; }
+    bool take_empty(size_t cls, uint32_t& idx);
+    void* carve(size_t cls);
+    void* allocate_slow(size_t cls);
+    void deallocate_slow(size_t cls, void* p);
+    bool in_arena(size_t cls, const void* p) const {
+        const SizeClass& sc = m_classes[cls];
+        return sc.base && (const char*)p >= sc.base && (const char*)p < sc.base + sc.block_count * BUFFER_CLASS_SIZES[cls];
     }
 
-    size_t pool_size() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_buffers.size();
+    SizeClass m_classes[BUFFER_CLASS_COUNT];
+    std::mutex m_mutex;         // 保护 m_caches（只在线程首次分配、抓取统计时加锁）
+    std::vector<std::unique_ptr<BufferThreadCache>> m_caches;
+    std::mutex m_spill_mutex;
+    std::atomic<uint64_t> m_oversize_allocs{0};
+    std::atomic<uint64_t> m_fallback_allocs{0};
+    std::atomic<bool> m_hugepages{false};
+};
+
+// 从 BufferPool 分配内存的分配器（无状态）
+template <class T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(BufferPool::get_instance().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        BufferPool::get_instance().deallocate(p, n * sizeof(T));
     }
 
-private:
-    BufferPool() = default;
-    ~BufferPool() = default;
-    BufferPool(const BufferPool&) = delete;
-    BufferPool& operator=(const BufferPool&) = delete;
+    template <class U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+inline PoolBuffer BufferPool::acquire(size_t size) {
+    PoolBuffer buffer;
+    buffer.reserve(size);
+    return buffer;
+}
 
-    mutable std::mutex m_mutex;
-    std::stack<std::vector<char>> m_buffers;
-    
-    static constexpr size_t MAX_POOL_SIZE = 2000;    // 最大池大小
-    static constexpr size_t MIN_BUFFER_SIZE = 4096; // 最小缓冲区大小
-    static constexpr size_t MAX_BUFFER_SIZE = 128 * 1024; // 最大缓冲区大小
-};
\ No newline at end of file
+inline void BufferPool::release(PoolBuffer&& buffer) {
+    PoolBuffer().swap(buffer);
+}
@@ -0,0 +1,60 @@
+// Compression.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+const size_t HTTP_COMPRESS_MIN_SIZE = 1024;                 // 小于该大小的响应体不压缩（收益抵不过编码头与 CPU）
+const size_t HTTP_COMPRESS_MAX_DYNAMIC = 8 * 1024 * 1024;   // 动态响应体超过该大小不压缩
+const size_t HTTP_COMPRESS_MAX_CODINGS = 2;                 // 支持的压缩编码数（br、gzip）
+
+// 内容编码（Content-Encoding）
+enum class ContentCoding : uint8_t { Identity, Gzip, Brotli };
+
+// 响应压缩
+// - Accept-Encoding 协商：按 q 值排序，q 值相同时优先 br
+// - 压缩级别：静态文件只压缩一次（结果进入 StaticFileCache 的压缩版本缓存），用较高级别；
+//   动态响应体每次都要压缩，级别随响应体大小递减，使单个响应的 CPU 开销有上限
+// - 编译时没有 brotli 编码库时（未定义 WEBSERVER_HAVE_BROTLI），br 只能来自预压缩的 .br 文件
+class Compression {
+public:
+    /**
+     * @brief 解析 Accept-Encoding，按优先级输出客户端可接受的压缩编码（不含 identity）
+     * @param accept_encoding 请求头的值
+     * @param out 输出数组，至少 HTTP_COMPRESS_MAX_CODINGS 个元素
+     * @return 可接受的编码个数，0 表示只能发送原始内容
+     */
+    static size_t negotiate(std::string_view accept_encoding, ContentCoding* out);
+
+    // 该 MIME 类型的内容是否值得压缩（文本类；图片、音视频、压缩包本身已压缩）
+    static bool compressible(std::string_view mime_type);
+
+    // 本进程能否在线压缩为该编码
+    static bool available(ContentCoding coding);
+
+    // Content-Encoding 的取值："gzip"/"br"
+    static const char* name(ContentCoding coding);
+    // 预压缩文件的扩展名：".gz"/".br"
+    static const char* suffix(ContentCoding coding);
+
+    // 静态文件（压缩一次后缓存）使用的级别
+    static int static_level(ContentCoding coding);
+    // 动态响应体使用的级别：越大的响应体级别越低
+    static int dynamic_level(ContentCoding coding, size_t size);
+
+    /**
+     * @brief 压缩整块数据
+     * @return 成功返回 true，out 为压缩结果（替换原内容）
+     */
+    static bool compress(ContentCoding coding, std::string_view input, int level, std::string& out);
+
+    /**
+     * @brief 按请求的 Accept-Encoding 压缩动态响应的 body
+     * 只处理状态码为 200、Content-Type 可压缩、没有 Content-Encoding 的内存响应体，
+     * 可压缩的响应一律带上 Vary: Accept-Encoding（无论本次是否压缩）
+     */
+    static void compress_response(const HttpRequest& req, HttpResponse& response);
+};
@@ -0,0 +1,104 @@
+// HeaderWriter.h
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 常见状态码预先拼好的完整状态行；原因短语与表中一致时返回该行，否则返回空
+inline std::string_view cached_status_line(int code, std::string_view text) {
+    std::string_view line;
+    switch (code) {
+        case 101: line = "HTTP/1.1 101 Switching Protocols\r\n"; break;
+        case 200: line = "HTTP/1.1 200 OK\r\n"; break;
+        case 204: line = "HTTP/1.1 204 No Content\r\n"; break;
+        case 206: line = "HTTP/1.1 206 Partial Content\r\n"; break;
+        case 301: line = "HTTP/1.1 301 Moved Permanently\r\n"; break;
+        case 302: line = "HTTP/1.1 302 Found\r\n"; break;
+        case 304: line = "HTTP/1.1 304 Not Modified\r\n"; break;
+        case 400: line = "HTTP/1.1 400 Bad Request\r\n"; break;
+        case 401: line = "HTTP/1.1 401 Unauthorized\r\n"; break;
+        case 403: line = "HTTP/1.1 403 Forbidden\r\n"; break;
+        case 404: line = "HTTP/1.1 404 Not Found\r\n"; break;
+        case 405: line = "HTTP/1.1 405 Method Not Allowed\r\n"; break;
+        case 413: line = "HTTP/1.1 413 Payload Too Large\r\n"; break;
+        case 416: line = "HTTP/1.1 416 Range Not Satisfiable\r\n"; break;
+        case 500: line = "HTTP/1.1 500 Internal Server Error\r\n"; break;
+        case 503: line = "HTTP/1.1 503 Service Unavailable\r\n"; break;
+        default: return {};
+    }
+    // "HTTP/1.1 xxx " 之后、结尾 "\r\n" 之前是原因短语
+    if (line.substr(13, line.size() - 15) != text) {
+        return {};
+    }
+    return line;
+}
+
+// 响应头序列化：直接追加到调用方的缓冲区（连接的写缓冲区或 std::string），
+// 数字用 to_chars 写入栈上的临时数组，常见状态行整行拷贝，整个过程没有临时字符串
+template <class Buffer>
+class HeaderWriter {
+public:
+    explicit HeaderWriter(Buffer& buffer) : m_buffer(buffer) {}
+
+    // 预留 extra 字节，避免一个响应的序列化过程中多次扩容
+    void reserve(size_t extra) {
+        if (m_buffer.capacity() - m_buffer.size() < extra) {
+            m_buffer.reserve(m_buffer.size() + extra);
+        }
+    }
+
+    void append(std::string_view data) {
+        m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+    }
+
+    void number(uint64_t value) {
+        char digits[20];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(std::string_view(digits, result.ptr - digits));
+    }
+
+    void status_line(int code, std::string_view text) {
+        std::string_view line = cached_status_line(code, text);
+        if (!line.empty()) {
+            append(line);
+            return;
+        }
+        append("HTTP/1.1 ");
+        number(code < 0 ? 0 : (uint64_t)code);
+        append(" ");
+        append(text);
+        append("\r\n");
+    }
+
+    void header(std::string_view key, std::string_view value) {
+        append(key);
+        append(": ");
+        append(value);
+        append("\r\n");
+    }
+
+    void header(std::string_view key, uint64_t value) {
+        append(key);
+        append(": ");
+        number(value);
+        append("\r\n");
+    }
+
+    // Content-Range: bytes first-last/total
+    void content_range(uint64_t first, uint64_t last, uint64_t total) {
+        append("Content-Range: bytes ");
+        number(first);
+        append("-");
+        number(last);
+        append("/");
+        number(total);
+        append("\r\n");
+    }
+
+    // 头部结束的空行
+    void end() { append("\r\n"); }
+
+private:
+    Buffer& m_buffer;
+};
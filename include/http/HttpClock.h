@@ -0,0 +1,42 @@
+// HttpClock.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+const size_t HTTP_CLOCK_PREFIX_MAX = 64;   // 缓存的响应头前缀的最大长度（一条缓存行）
+#define HTTP_SERVER_NAME "WebServer"       // Server 响应头的值
+
+// 每秒更新一次的响应头前缀："Date: <IMF-fixdate>\r\nServer: WebServer\r\n"
+// - 主 Reactor 的时钟 timerfd 在每个整秒触发时调用 update() 重新格式化
+// - 所有线程在序列化响应时用 copy_prefix() 拷贝前缀，每个响应没有 time()/strftime
+// - 用顺序锁（seqlock）同步：写者更新前后各递增一次序号，读者拷贝后序号未变且为偶数才有效，
+//   读者不加锁也不写共享内存，不会在多个 Reactor 之间来回争抢缓存行
+class HttpClock {
+public:
+    // 按当前时间重新生成前缀（写者之间用互斥锁串行化，每秒只调用一次）
+    static void update();
+    static void update(time_t now);
+
+    /**
+     * @brief 拷贝当前的前缀
+     * @param dst 至少 HTTP_CLOCK_PREFIX_MAX 字节
+     * @return 前缀长度；尚未调用过 update 时先按当前时间生成
+     */
+    static size_t copy_prefix(char* dst);
+
+    // 最近一次 update 的时间（秒）
+    static time_t now() { return (time_t)s_now.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t WORDS = HTTP_CLOCK_PREFIX_MAX / sizeof(uint64_t);
+
+    // 前缀按 8 字节一组存放在原子变量中，读写都是 relaxed 访问，顺序由序号与栅栏保证
+    alignas(64) static std::atomic<uint64_t> s_words[WORDS];
+    static std::atomic<uint32_t> s_seq;
+    static std::atomic<uint32_t> s_length;
+    static std::atomic<int64_t> s_now;
+    static std::mutex s_writer;
+};
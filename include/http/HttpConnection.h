@@ -2,12 +2,20 @@
 #include "HttpParser.h"
 #include "Router.h"
 #include "../tools/Tools.h" // 包含 Action
+#include "../metrics/Metrics.h"
+#include "../metrics/Trace.h"
 #include <vector>
 #include <sys/uio.h>
 #include <netinet/in.h>   // sockaddr_in, htons, htonl, INADDR_ANY 等
 #include <arpa/inet.h>    // inet_pton, inet_ntop 等地址转换函数
 #include <sys/socket.h>   // socket(), bind(), listen(), accept(), send(), recv() 等
 
+// HTTP/1.1 管线化：一次读到的多个完整请求依次处理，响应按顺序排队后用 writev 批量发送
+const size_t HTTP_PIPELINE_DEPTH = 32;          // 每批最多排队的响应数
+const size_t HTTP_PIPELINE_BUFFER = 64 * 1024;  // 每批响应头/文本响应的字节数上限（超过后先发送再继续解析）
+const int HTTP_WRITE_IOV_MAX = 64;              // 单次 writev 最多合并的片段数
+const size_t HTTP_INLINE_BODY_MAX = 1024;       // 不超过该大小的内存响应体拷贝进写缓冲区，更大的移交给发送队列作为独立 iovec
+
 class HttpConnection {
 public:
 
@@ -15,13 +23,21 @@ public:
     HttpConnection(int sockfd, const sockaddr_in& addr, Router* router, RequestContext* context);
     ~HttpConnection();
 
-    // 从 socket 读取并处理数据
+    // 从 socket 读取数据并处理读缓冲区中所有完整的请求（管线化）：
+    // ExecPolicy::Inline 的路由直接执行，响应排队后返回 Write；
+    // 遇到 ExecPolicy::Pool 的路由则返回 Process，由调用方在工作线程中调用 process_request()
     Action handle_read();
+
+    // 执行已匹配路由的 handler，响应加入发送队列
+    Action process_request();
+
+    // 工作线程池过载时不执行 handler，直接排队 503 响应并在发送后关闭连接
+    Action reject_overloaded();
     
-    // 向 socket 写入数据
+    // 批量发送队列中的响应；全部发送完毕后继续处理读缓冲区中剩余的管线化请求
     Action handle_write();
 
-    // 用于在 Keep-Alive 模式下重置连接状态，准备处理下一个请求
+    // 当前请求处理完毕：丢弃其在读缓冲区中的字节，重置解析器，准备解析下一个请求
     void reset_for_keep_alive();
 
     // 用于重置全部状态
@@ -32,8 +48,67 @@ public:
 
     int get_fd() const { return m_sockfd; }
 
+    // 连接当前所处的阶段（SubReactor 据此选择超时），在 Reactor 线程中且没有派发到线程池时调用
+    ConnPhase phase() const;
+
+    // 连接累计读取/发送的字节数（请求体速率与发送进展的判断依据）
+    uint64_t bytes_read() const { return m_bytes_read; }
+    uint64_t bytes_sent() const { return m_bytes_sent; }
+
+    // 已处理完（响应已入队）的请求数，用于区分前后两个请求的同一阶段
+    uint64_t requests() const { return m_requests; }
+
+    // Pool 路由的响应经 addTask 回到 SubReactor 线程时调用，记录采样请求的 TracePoint::Reactor
+    void trace_returned();
+
 private:
-    void prepare_response(const HttpResponse& response);
+    // 待发送的响应片段：m_write_buffer 中的一段（响应头或完整的文本响应），
+    // 可选再跟一个不经拷贝的内存响应体或一个 sendfile 发送的文件体
+    struct OutSegment {
+        size_t buf_offset;
+        size_t buf_len;
+        const char* body;   // HttpResponse::shared_body，由 pin 保持有效
+        size_t body_len;
+        int file_fd;        // 无文件体时为 -1，文件由 pin 持有并在最后一个引用释放时关闭
+        off_t file_offset;
+        size_t file_len;
+        std::shared_ptr<const void> pin;
+    };
+
+    // 响应体来源：文件（sendfile）或内存
+    struct BodySource {
+        int fd = -1;
+        const char* data = nullptr;
+        uint64_t size = 0;
+        std::shared_ptr<const void> pin;
+    };
+
+    // 依次解析并处理读缓冲区中的完整请求，直到数据不完整、需要派发到线程池或本批响应已满
+    Action process_buffered();
+
+    // 请求处理完毕：响应入队，并决定之后是否继续处理同一连接上的请求
+    void finish_request(HttpResponse&& response);
+
+    // 把响应序列化后追加到发送队列（较大的 body 被移走，不拷贝）
+    void prepare_response(HttpResponse&& response);
+    void prepare_range_response(const HttpResponse& response, const BodySource& source);
+    void append_status_and_headers(const HttpResponse& response, bool skip_content_type);
+
+    // 发送队列中的数据：全部发送完返回 true，EAGAIN 返回 false 且 action 为 Write，出错时 action 为 Close
+    bool flush(Action& action);
+
+    // 丢弃发送队列（关闭其中尚未发送的文件）
+    void clear_output();
+
+    // 新请求开始：决定是否采样，采样时记录 Accept/Read
+    void trace_begin();
+    void trace_mark(TracePoint point) {
+        if (m_trace_sampled) {
+            m_trace.t[(size_t)point] = Metrics::now_ns();
+        }
+    }
+    // 响应已入队：补全请求信息，转为等待发送完毕的记录
+    void trace_end(int status);
 
     int m_sockfd;
     sockaddr_in m_address;
@@ -44,23 +119,30 @@ private:
 
     // 内部状态
     HttpParser m_parser;
-    bool m_is_writing = false;
+    bool m_close_after_write = false;   // 队列发送完后关闭连接（Connection: close、解析错误、过载降级）
+    bool m_upgrade_after_write = false; // 队列发送完后升级为 WebSocket
+    const RouteRule* m_route = nullptr; // 当前请求匹配到的路由
     
     // 使用现代 C++ 的缓冲区
-    std::vector<char> m_read_buffer;
-    std::vector<char> m_write_buffer; // 用于存放响应头
-    
-    // 文件发送相关
-    int m_file_fd = -1;
-    off_t m_file_offset = 0;
-    size_t m_file_bytes_to_send = 0;
+    PoolBuffer m_read_buffer;
+    PoolBuffer m_write_buffer; // 本批所有响应头/文本响应，按顺序连续存放
     
-    // 用于 writev
-    struct iovec m_iov[2];
-    int m_iov_count = 0;
-    size_t m_bytes_to_send = 0;
-    size_t m_bytes_have_sent = 0;
+    // 发送队列：[m_out_head, m_out.size()) 尚未发送完
+    std::vector<OutSegment> m_out;
+    size_t m_out_head = 0;
 
     // websocket协议升级相关
     bool m_is_websocket = false;
+
+    uint64_t m_bytes_read = 0;
+    uint64_t m_bytes_sent = 0;
+    uint64_t m_requests = 0;
+
+    // 采样追踪：m_trace 为正在处理的请求，m_trace_done 为响应已入队、等待发送完毕的请求（同一时刻至多一个）
+    uint64_t m_accept_ns = 0;
+    bool m_trace_begun = false;     // 当前请求已做过采样判断
+    bool m_trace_sampled = false;
+    bool m_trace_pending = false;
+    TraceRecord m_trace;
+    TraceRecord m_trace_done;
 };
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 #include "HttpRequest.h"
+#include "HttpScanner.h"
+#include "BufferPool.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <optional>
@@ -10,19 +13,27 @@ public:
     enum class ParseResult {
         Complete,      // 成功解析一个完整请求
         Incomplete,    // 数据不完整，需要更多数据
-        Error          // 解析出错
+        Error,         // 解析出错
+        TooManyHeaders // 请求头数量超过 HTTP_MAX_HEADERS
     };
     // 文件存在temp_upload_dir文件夹
     explicit HttpParser(std::string temp_upload_dir = "/tmp");
 
-    ParseResult parse(std::vector<char>& buffer);
+    ParseResult parse(PoolBuffer& buffer);
     void reset();
+
+    // 解析完成后 buffer 开头仍属于当前请求的字节数（零拷贝的请求行与请求头），
+    // 调用方在请求处理完毕后将其从 buffer 中删除，再调用 reset()
+    size_t consumed() const { return m_consumed; }
     const HttpRequest& get_request() const { return m_request; }
+    HttpRequest& get_request() { return m_request; }
+
+    // 请求头已解析完、请求体尚未收完
+    bool in_body() const { return m_state != ParseState::REQUEST_LINE && m_state != ParseState::DONE; }
 
 private:
     enum class ParseState {
-        REQUEST_LINE,
-        HEADERS,
+        REQUEST_LINE, // 等待完整的请求行与请求头
         BODY, // 普通 application/json 或 x-www-form-urlencoded
         MULTIPART_BOUNDARY_SEARCH,
         MULTIPART_PART_HEADERS,
@@ -32,6 +43,9 @@ private:
 
     ParseState m_state = ParseState::REQUEST_LINE;
     HttpRequest m_request;
+    size_t m_content_length = 0; // BODY 状态下的请求体长度
+    size_t m_consumed = 0;       // 见 consumed()
+    HttpTokens m_tokens;         // 头部块的分词结果（可跨多次 parse 继续扫描）
 
     std::string m_temp_upload_dir;
     std::string m_boundary;
@@ -42,8 +56,8 @@ private:
     std::ofstream m_file_stream;
 
     // 内部工具函数
-    bool parse_request_line(const std::string& line);
-    bool parse_header_line(const std::string& line);
+    bool parse_request_line(std::string_view line);
+    bool parse_header_block(std::string_view data);
     bool extract_boundary(const std::string& content_type);
     void handle_form_urlencoded(const std::string& body);
     ParseResult handle_multipart(std::string_view& body_chunk);
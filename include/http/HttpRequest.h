@@ -1,8 +1,9 @@
-// HttpRequest.h (修改后)
+// HttpRequest.h
 #pragma once
 #include <string>
 #include <string_view>
 #include <cstring>
+#include <cstdint>
 #include <unordered_map>
 #include <optional>
 
@@ -16,16 +17,104 @@ struct UploadedFile {
 
 enum class HttpMethod { GET, POST, HEAD, UNKNOWN };
 
+// 路由参数（":id"、"*path" 捕获的值），由 Router 匹配时填入，值以偏移量记录在 path 中，不分配内存
+const size_t ROUTE_MAX_PARAMS = 8;
+
+struct RouteParam {
+    std::string_view name;   // 参数名，指向路由表中保存的名字
+    uint32_t offset = 0;     // 参数值在 path 中的起始位置
+    uint32_t length = 0;     // 参数值长度
+};
+
+struct RouteParams {
+    RouteParam items[ROUTE_MAX_PARAMS];
+    size_t count = 0;
+
+    void clear() { count = 0; }
+};
+
+// 单个请求头，name/value 指向连接读缓冲区（或请求自己保存的头部副本）
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
+// 请求头的最大数量，超出时返回 431（带 Cookie 与代理、追踪头的浏览器请求通常在 30 个左右）
+const size_t HTTP_MAX_HEADERS = 100;
+
+// 扁平的请求头数组：按到达顺序保存，不分配内存
+// 追加时预先计算小写名字的哈希并登记到一个小的开放寻址索引中，按名字查找为 O(1)
+class HttpHeaders {
+public:
+    // 小写 FNV-1a 哈希（只折叠 ASCII 字母），字面量参数可在编译期求值
+    static constexpr uint32_t hash_name(std::string_view name) {
+        uint32_t h = 2166136261u;
+        for (char c : name) {
+            unsigned char u = static_cast<unsigned char>(c);
+            if (u >= 'A' && u <= 'Z') u += 'a' - 'A';
+            h = (h ^ u) * 16777619u;
+        }
+        return h;
+    }
+
+    // 追加一个请求头，数组已满返回 false；同名请求头以最后一个为准
+    bool add(std::string_view name, std::string_view value);
+
+    // 按名字查找（不区分大小写）
+    std::optional<std::string_view> get(std::string_view name) const {
+        return get(name, hash_name(name));
+    }
+    std::optional<std::string_view> get(std::string_view name, uint32_t hash) const;
+
+    bool contains(std::string_view name) const { return get(name).has_value(); }
+
+    const HttpHeader* begin() const { return m_items; }
+    const HttpHeader* end() const { return m_items + m_count; }
+    HttpHeader* begin() { return m_items; }
+    HttpHeader* end() { return m_items + m_count; }
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    void clear() {
+        if (m_count) {
+            memset(m_index, 0, sizeof(m_index));
+            m_count = 0;
+        }
+    }
+
+private:
+    static const size_t INDEX_SIZE = 256; // 2 的幂，且不小于 2 * HTTP_MAX_HEADERS，探测链很短
+    static_assert(INDEX_SIZE >= 2 * HTTP_MAX_HEADERS, "header index too small");
+    static_assert(HTTP_MAX_HEADERS < 256, "m_index stores header index + 1 in a uint8_t");
+
+    HttpHeader m_items[HTTP_MAX_HEADERS];
+    uint32_t m_hashes[HTTP_MAX_HEADERS];  // 每个请求头名字的小写哈希
+    uint8_t m_index[INDEX_SIZE] = {};     // 哈希槽 -> 下标 + 1，0 表示空槽
+    size_t m_count = 0;
+};
+
+// HTTP 请求
+// method/path/version/headers 都是指向连接读缓冲区的 string_view（零拷贝），
+// 在请求处理完毕、连接调用 reset_for_keep_alive 之前有效；
+// 带请求体的请求会先把头部复制到 m_header_storage 中，再由解析器逐段消费请求体
 class HttpRequest {
 public:
-    // --- 以下部分保持不变 ---
     HttpMethod method = HttpMethod::UNKNOWN;
-    std::string path;
-    std::string version;
-    std::unordered_map<std::string, std::string> headers;
+    std::string_view path;    // 请求目标中 "?" 之前的部分
+    std::string_view query;   // "?" 之后的查询串（不含 "?"），没有时为空
+    std::string_view version;
+    HttpHeaders headers;
+
+    // 对端 IPv4 地址（网络字节序），由连接在路由前填入
+    uint32_t remote_addr = 0;
 
     std::optional<std::string_view> get_header(std::string_view key) const;
 
+    // 路由匹配得到的路径参数
+    RouteParams params;
+
+    // 获取路径参数，例如路由 "/api/user/:id" 匹配 "/api/user/42" 时 get_param("id") 为 "42"
+    std::optional<std::string_view> get_param(std::string_view name) const;
+
     // 用于存储 application/json 等类型的原始请求体
     std::string raw_body; 
     // --- 修改部分：用两个 map 替换原来的 std::string body ---
@@ -46,4 +135,24 @@ public:
 
     // 工具方法：判断是否为 WebSocket 升级请求
     bool is_websocket_upgrade() const;
+
+    // 工具方法：响应后是否保持连接
+    // Connection 头含 close 则关闭，含 keep-alive 则保持，否则 HTTP/1.1 默认保持、HTTP/1.0 默认关闭
+    bool keep_alive() const;
+
+    // 工具方法：请求是否来自本机回环地址（127.0.0.0/8）
+    bool from_loopback() const;
+
+    // 按第一个 "?" 把请求目标拆成 path 与 query
+    void set_target(std::string_view target);
+
+    // 清空请求，保留各容器已分配的容量，供 keep-alive 的下一个请求复用
+    void clear();
+
+    // 把 block 内的请求行和请求头复制到请求自己的存储中，并让所有 string_view 指向副本；
+    // 解析器在需要移动/丢弃读缓冲区中的头部字节之前调用
+    void detach_from(std::string_view block);
+
+private:
+    std::string m_header_storage; // detach_from 之后请求行与请求头所在的存储
 };
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 static std::string ok_200_title       = "OK";
 static std::string error_400_title    = "Bad Request";
@@ -10,8 +13,18 @@ static std::string error_403_title    = "Forbidden";
 static std::string error_403_form     = "You do not have permission to get file from this server.\n";
 static std::string error_404_title    = "Not Found";
 static std::string error_404_form     = "The requested file was not found on this server.\n";
+static std::string error_431_title    = "Request Header Fields Too Large";
+static std::string error_431_form     = "The request has too many header fields.\n";
 static std::string error_500_title    = "Internal Error";
 static std::string error_500_form     = "There was an unusual problem serving the requested file.\n";
+static std::string error_503_title    = "Service Unavailable";
+static std::string error_503_form     = "The server is temporarily overloaded, please retry later.\n";
+
+// 字节区间 [first, last]（闭区间，与 Content-Range 的写法一致）
+struct ByteRange {
+    uint64_t first;
+    uint64_t last;
+};
 
 // HttpResponse.h
 class HttpResponse {
@@ -25,6 +38,18 @@ public:
     std::string file_path;
     size_t file_size = 0;
 
+    // 预先序列化好的响应头行（"Key: Value\r\n"...，须含 Content-Length），原样追加在 headers 之后
+    std::string_view raw_headers;
+    // 不经拷贝直接发送的响应体，非空时代替 body
+    std::string_view shared_body;
+    // 保证 raw_headers / shared_body 指向的内存在响应发送完之前有效（如缓存的静态文件）
+    std::shared_ptr<const void> pin;
+
+    // Range 请求：只发送响应体（file_path 或 shared_body）中的这些区间；
+    // Content-Range、Content-Length 以及多区间时的 multipart/byteranges 分段由 HttpConnection 生成，
+    // 此时 Content-Type 须放在 headers 中（作为分段类型），raw_headers 中不应含 Content-Type/Content-Length
+    std::vector<ByteRange> ranges;
+
     void set_header(const std::string& key, const std::string& value);
     // 构建标准错误响应
     static HttpResponse make_error(int code);
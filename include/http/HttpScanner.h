@@ -0,0 +1,71 @@
+// HttpScanner.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "HttpRequest.h"
+
+// 头部块的分词结果：每一行（请求行 + 各请求头）的起止位置和第一个 ':' 的位置
+// 扫描可以分多次进行（数据不完整时），状态保存在结构体中，下次从 pos 继续
+struct HttpTokens {
+    static const uint32_t NO_COLON = UINT32_MAX;
+    static const size_t MAX_LINES = HTTP_MAX_HEADERS + 1; // 请求行 + 请求头
+
+    struct Line {
+        uint32_t begin;  // 行首
+        uint32_t end;    // 行尾 '\r' 的位置
+        uint32_t colon;  // 第一个 ':' 的位置，没有则为 NO_COLON
+    };
+
+    Line lines[MAX_LINES];
+    size_t count = 0;            // 已完成的行数
+    size_t pos = 0;              // 下一个待扫描的字节
+    size_t line_begin = 0;       // 当前行的行首
+    uint32_t colon = NO_COLON;   // 当前行已发现的第一个 ':'
+    size_t header_end = 0;       // 头部结束位置（空行 "\r\n" 之后），0 表示尚未找到
+
+    void clear() {
+        count = 0;
+        pos = 0;
+        line_begin = 0;
+        colon = NO_COLON;
+        header_end = 0;
+    }
+};
+
+// HTTP 头部分词器
+// 一次遍历找出所有 "\r\n" 和每行第一个 ':'，按 CPU 能力在运行时选择实现：
+//   AVX2（一次比较 32 字节）> SSE2（16 字节，x86-64 必有）> 标量逐字节
+class HttpScanner {
+public:
+    enum class Impl { Scalar, SSE2, AVX2 };
+
+    enum class Result {
+        Complete,   // 找到空行，tokens.header_end 有效
+        Incomplete, // 需要更多数据，下次从 tokens.pos 继续
+        TooMany     // 行数超过 HttpTokens::MAX_LINES
+    };
+
+    /**
+     * @brief 从 tokens.pos 开始扫描 data[0, len)
+     * @param data 头部块起始地址（即请求起始地址），多次调用之间只能在末尾追加数据
+     */
+    static Result scan(const char* data, size_t len, HttpTokens& tokens) {
+        return s_scan(data, len, tokens);
+    }
+
+    // 当前使用的实现
+    static Impl impl() { return s_impl; }
+
+    // 强制使用某个实现（用于基准测试），CPU 不支持时返回 false 且不做修改
+    static bool set_impl(Impl impl);
+
+    // CPU 是否支持某个实现
+    static bool supported(Impl impl);
+
+    static const char* impl_name(Impl impl);
+
+private:
+    using ScanFn = Result (*)(const char*, size_t, HttpTokens&);
+    static ScanFn s_scan;
+    static Impl s_impl;
+};
@@ -5,15 +5,21 @@
 #include "HttpResponse.h"
 #include <map>
 #include <vector>
+#include <deque>
+#include <memory>
 #include <regex>
+#include <string_view>
 #include "../sql/SqlConnectionPool.h"
 #include "../thread_pool/ThreadPool.h"
+#include "StaticFileCache.h"
 
 // 请求上下文，可以传递数据库连接池、配置等资源
 class RequestContext {
 public:
     SqlConnectionPool* db_pool;
     const char* doc_root;
+    StaticFileCache* file_cache = nullptr; // 静态文件缓存，为空时每次都读文件
+    bool admin_remote = false;             // 管理接口（/admin/*）是否允许非本机地址访问
 
     // sessionId -> username映射表，用于websocket认证用户名
     std::unordered_map<std::string, std::string> sessions;
@@ -23,25 +29,82 @@ public:
 // 定义一个处理请求的函数类型
 using HttpHandler = std::function<HttpResponse(const HttpRequest&, RequestContext&)>;
 
+// 路由的执行策略
+enum class ExecPolicy {
+    Inline,     // 在 SubReactor 线程内直接执行（廉价、非阻塞的 handler）
+    Pool        // 交给工作线程池执行（会阻塞的 handler，如访问 MySQL）
+};
+
 // 路由规则结构体
 struct RouteRule {
     std::string pattern;        // 原始路径模式
-    std::regex regex_pattern;   // 编译后的正则表达式
+    std::regex regex_pattern;   // 编译后的正则表达式（仅 is_regex 时有效）
     HttpHandler handler;        // 处理函数
     bool is_regex;             // 是否为正则表达式路径
+    ExecPolicy policy;          // 执行策略
+    uint32_t metrics_id = 0;    // 请求计数使用的路由编号（见 Metrics::register_route）
     
-    RouteRule(const std::string& path, HttpHandler h);
+    RouteRule(const std::string& path, HttpHandler h, ExecPolicy p = ExecPolicy::Inline);
 };
 
+// 基数树节点：边上是压缩后的字面量，":name" 匹配一个路径段，"*name" 匹配剩余全部路径
+struct RouteNode {
+    // 末尾通配段 "*name" 及其扩展名约束
+    struct CatchAll {
+        std::string name;
+        std::vector<std::string> exts; // 允许的扩展名（不含点）
+        bool any_ext = true;           // 未指定扩展名约束
+        const RouteRule* rule = nullptr;
+
+        bool accepts(std::string_view rest) const;
+    };
+
+    std::string prefix;                               // 压缩后的字面量边
+    std::vector<std::unique_ptr<RouteNode>> children; // 字面量子节点，首字符互不相同
+    std::string param_name;                           // ":name" 子节点的参数名
+    std::unique_ptr<RouteNode> param_child;           // ":name" 子节点
+    std::vector<CatchAll> catch_alls;                 // 按注册顺序尝试
+    const RouteRule* rule = nullptr;                  // 恰好在此结束的路由
+};
+
+// 路由表
+// 路径模式语法：
+//   /api/test                     字面量
+//   /api/user/:id                 ":id" 捕获一个路径段（不含 '/'）
+//   /static/*path                 "*path" 捕获剩余全部路径（可含 '/'），必须是最后一段
+//   /*path.{html,css,js}          末尾通配并要求扩展名在列表中
+//   /*path.{}                     末尾通配并要求不带扩展名（路径中没有 '.'）
+// 匹配优先级：字面量 > 参数段 > 通配段；查找只比较请求路径（不含查询串），不分配内存。
+// 含 ^ $ ( ) [ ] | \ ? + 的模式按 ECMAScript 正则处理，在基数树未命中后逐条尝试（兼容旧路由）。
 class Router {
 public:
-    void add_route(HttpMethod method, const std::string& path, HttpHandler handler);
-    HttpResponse route_request(const HttpRequest& req, RequestContext& context);
+    void add_route(HttpMethod method, const std::string& path, HttpHandler handler,
+                   ExecPolicy policy = ExecPolicy::Inline);
+    HttpResponse route_request(HttpRequest& req, RequestContext& context);
+
+    // 查找与请求匹配的路由规则并把路径参数写入 req.params，未找到返回 nullptr
+    const RouteRule* find_route(HttpRequest& req) const;
+
+    // 按方法和路径查找路由规则，路径参数写入 params
+    const RouteRule* match(HttpMethod method, std::string_view path, RouteParams& params) const;
 
 private:
-    // 使用 map，key 是 HttpMethod，值是该方法对应的路由规则列表
-    std::map<HttpMethod, std::vector<RouteRule>> m_routes;
-    
-    // 检查路径是否包含正则表达式特殊字符
-    bool is_regex_pattern(const std::string& path);
+    struct MethodRoutes {
+        std::deque<RouteRule> rules;                 // 规则本体，deque 保证指针稳定
+        RouteNode root;                              // 基数树
+        std::vector<const RouteRule*> regex_rules;   // 正则规则，按注册顺序
+    };
+
+    // 按 HttpMethod 下标索引的路由表
+    MethodRoutes m_routes[static_cast<size_t>(HttpMethod::UNKNOWN) + 1];
+
+    // 将一条路由模式插入基数树
+    static void insert(RouteNode* root, const std::string& pattern, const RouteRule* rule);
+
+    // 插入一段字面量，必要时拆分已有的边，返回字面量结束处的节点
+    static RouteNode* insert_literal(RouteNode* node, std::string_view literal);
+
+    // 从 node 开始匹配 path[pos:]，失败时回溯
+    static const RouteRule* match_node(const RouteNode* node, std::string_view path, size_t pos,
+                                       RouteParams& params);
 };
\ No newline at end of file
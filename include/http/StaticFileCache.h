@@ -0,0 +1,144 @@
+// StaticFileCache.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <sys/types.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+const size_t STATIC_CACHE_SHARDS = 16;                  // 分片数（2 的幂），降低多个 SubReactor 之间的锁竞争
+const size_t STATIC_CACHE_MAX_FILE = 1024 * 1024;       // 单个文件超过该大小不缓存，仍走 sendfile
+const size_t STATIC_CACHE_VARIANT_SHARE = 4;            // 压缩版本缓存占总容量的 1/4（另计，不挤占原始文件）
+
+// 缓存的静态文件：内容与预先序列化好的响应头都在内存中，命中时不再访问文件系统
+struct StaticFile {
+    std::string path;          // 规范化后的绝对路径（用于 inotify 失效）
+    std::string mime_type;
+    std::string etag;          // 由 inode、mtime 和文件大小生成的强校验值，带引号
+    time_t mtime = 0;
+    std::string last_modified; // mtime 的 HTTP 日期
+    std::string content;       // 文件内容
+    std::string header_block;  // 预先序列化的 200 响应头行（"Key: Value\r\n"...，含 Content-Length）
+    std::string not_modified_block; // 预先序列化的 304 响应头行（校验器与缓存策略，无 Content-Length）
+    std::string encoding;      // 压缩版本的 Content-Encoding（"gzip"/"br"），原始文件为空
+    bool negotiable = false;   // 原始文件：是否按 Accept-Encoding 协商压缩版本（响应带 Vary）
+};
+
+// 静态文件缓存
+// - 以请求路径为键，分片 LRU，按内容 + 响应头字节数限制总容量
+// - 后台线程用 inotify 监听 doc_root（含子目录），文件被修改/删除/移动时使对应条目失效，
+//   因此命中路径上没有 stat/open/read
+// - 另有一组独立限额的分片保存压缩版本（gzip/br），键为 "文件路径 + 编码 + ETag"，
+//   ETag 含 mtime，文件修改后旧版本不会再被命中，随 LRU 淘汰或被 inotify 失效
+class StaticFileCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t invalidations;
+        size_t entries;
+        size_t bytes;
+        uint64_t variant_hits;
+        uint64_t variant_misses;
+        size_t variant_entries;
+        size_t variant_bytes;
+    };
+
+    StaticFileCache() = default;
+    ~StaticFileCache();
+    StaticFileCache(const StaticFileCache&) = delete;
+    StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+    /**
+     * @brief 初始化缓存并启动 inotify 监听线程
+     * @param doc_root 静态文件根目录
+     * @param capacity_bytes 总容量（字节），为 0 时禁用缓存
+     * @return inotify 初始化失败时返回 false，此时缓存不启用（无法保证一致性）
+     */
+    bool init(const std::string& doc_root, size_t capacity_bytes);
+
+    bool enabled() const { return m_capacity > 0; }
+
+    // 规范化后的 doc_root
+    const std::string& doc_root() const { return m_doc_root; }
+
+    // 查找请求路径对应的条目，命中时移到 LRU 头部
+    std::shared_ptr<const StaticFile> lookup(std::string_view key);
+
+    // 当前失效代数：调用方在读取文件之前记录，insert 时传回，
+    // 期间若发生过失效则放弃插入，避免把读到的旧内容留在缓存中
+    uint64_t generation() const { return m_generation.load(std::memory_order_acquire); }
+
+    // 插入条目（文件过大或期间发生过失效时忽略）
+    void insert(std::string_view key, std::shared_ptr<const StaticFile> file, uint64_t generation);
+
+    // 查找/插入压缩版本，键由 variant_key 生成
+    std::shared_ptr<const StaticFile> lookup_variant(std::string_view key);
+    void insert_variant(std::string_view key, std::shared_ptr<const StaticFile> file, uint64_t generation);
+
+    // 压缩版本的键：原始文件的路径、编码与 ETag，结果写入 key（复用其内存）
+    static void variant_key(const StaticFile& file, std::string_view encoding, std::string& key);
+
+    // 使路径等于 path 或位于 path 目录下的所有条目（含压缩版本）失效
+    void invalidate(std::string_view path);
+
+    void clear();
+
+    Stats stats() const;
+
+    // 生成强 ETag："inode-mtime-size" 的十六进制，文件被替换（inode 变化）或修改时都会改变
+    static std::string make_etag(ino_t inode, time_t mtime, size_t size);
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const StaticFile> file;
+        size_t charge; // 计入容量的字节数
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // 头部最近使用
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index; // 键指向 Entry::key
+        size_t bytes = 0;
+    };
+
+    static Shard& shard_for(Shard* shards, std::string_view key);
+    std::shared_ptr<const StaticFile> lookup_in(Shard* shards, std::string_view key,
+                                                std::atomic<uint64_t>& hits, std::atomic<uint64_t>& misses);
+    void insert_in(Shard* shards, size_t shard_capacity, std::string_view key,
+                   std::shared_ptr<const StaticFile> file, uint64_t generation);
+    void evict_locked(Shard& shard, size_t capacity);
+    void invalidate_in(Shard* shards, std::string_view path);
+
+    // inotify 监听线程
+    void watch_loop();
+    void add_watch_recursive(const std::string& dir);
+
+    std::string m_doc_root;
+    size_t m_capacity = 0;        // 总容量，0 表示未启用
+    size_t m_shard_capacity = 0;  // 每个分片的容量
+    size_t m_variant_shard_capacity = 0; // 压缩版本每个分片的容量
+    Shard m_shards[STATIC_CACHE_SHARDS];
+    Shard m_variant_shards[STATIC_CACHE_SHARDS];
+
+    std::atomic<uint64_t> m_generation{0};
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::atomic<uint64_t> m_invalidations{0};
+    std::atomic<uint64_t> m_variant_hits{0};
+    std::atomic<uint64_t> m_variant_misses{0};
+
+    int m_inotify_fd = -1;
+    int m_stop_fd = -1; // eventfd，析构时唤醒监听线程退出
+    std::unordered_map<int, std::string> m_watch_dirs; // wd -> 目录（仅监听线程访问）
+    std::thread m_watcher;
+};
@@ -5,8 +5,37 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
-#include "BlockQueue.h"
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <ctime>
+#include <cstdarg>
+#include <sys/uio.h>
+#include "LogRing.h"
+#include "LogFormat.h"
+
+// 编译期最低日志级别（0=debug 1=info 2=warn 3=error），由 CMake 的 LOG_MIN_LEVEL 设置；
+// 低于该级别的 LOG_* 连同参数求值一起被编译器删除
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+const int LOG_RING_DEFAULT_KB = 256;    // 每个线程的日志环形缓冲区默认大小（KB）
+const int LOG_FLUSH_INTERVAL_MS = 10;   // 写线程没被唤醒时的轮询间隔，即日志落盘的最大延迟
+
+// 线程的环形缓冲区写满时的处理方式
+enum class LogFullPolicy {
+    Drop,   // 丢弃这条日志并计数（默认，Reactor 线程不会因磁盘慢而阻塞）
+    Block   // 等待写线程腾出空间，不丢日志
+};
 
+// 异步日志：
+// - 每个写日志的线程有自己的 SPSC 环形缓冲区，不加锁、不分配
+// - LOG_* 宏只把格式串指针、调用时刻与原始参数存入缓冲区，snprintf 由写线程完成（见 LogFormat.h）；
+//   write_log 则在调用线程格式化好整行再存入
+// - 时间戳的 "YYYY-MM-DD HH:MM:SS" 部分按线程缓存，同一秒内不再调用 localtime
+// - 写线程定期（或缓冲区过半时被唤醒）取走所有缓冲区的数据，每批一次 writev
+// - ring_kb 为 0 时同步写入：在调用线程格式化，加锁后直接 write
 class Log
 {
 public:
@@ -18,28 +47,69 @@ public:
         return &instance;
     }
 
-    static void *flush_log_thread(void *args)
-    {
-        return Log::get_instance()->async_write_log();
-    }
-
+    /**
+     * @brief 初始化日志
+     * @param file_name 日志文件路径，实际文件名前加 YYYY_MM_DD_
+     * @param close_log 是否关闭日志
+     * @param log_buf_size 单条日志的最大长度
+     * @param split_lines 单个文件的最大行数，超过后切换到 .1 .2 ...
+     * @param ring_kb 每个线程的环形缓冲区大小（KB），0 表示同步写入
+     */
     bool init(const char* file_name, int close_log,
               int log_buf_size = 8192,
               int split_lines = 5000000,
-              int max_queue_size = 0);
+              int ring_kb = 0);
 
     void write_log(int level, const char* format, ...);
 
+    /**
+     * @brief 延迟格式化写入（LOG_* 宏使用）：异步模式下只保存 format 指针与参数
+     * @param format 字符串字面量，写线程格式化时仍需有效
+     * @param args 字符串、算术类型、枚举或指针（见 LogFormat.h）
+     */
+    template <class... Args>
+    void write_deferred(int level, const char* format, const Args&... args);
+
+    // 运行期最低日志级别（默认 0，即不过滤）
+    void set_level(int level) { m_level.store(level, std::memory_order_relaxed); }
+    int level() const { return m_level.load(std::memory_order_relaxed); }
+
+    // 该级别的日志是否需要记录（LOG_* 宏在求值参数之前检查）
+    bool enabled(int level) const {
+        return m_close_log == 0 && level >= m_level.load(std::memory_order_relaxed);
+    }
+
+    // 等待写线程把调用之前的日志全部写入文件（同步模式下直接返回）
     void flush();
 
+    // 缓冲区写满时丢弃还是阻塞（可在 init 之前设置）
+    void set_full_policy(LogFullPolicy policy) { m_policy.store(policy, std::memory_order_relaxed); }
+
+    // 因缓冲区已满而丢弃的日志条数
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
 private:
     Log();
     ~Log();
 
-    void* async_write_log();
     void thread_func();
-    void switch_log(const tm& my_tm);//日期更新时创建新log
-    void write_single_log(const std::string& msg);
+    // 写入 lines 行之前检查是否需要切换文件：跨天，或行数越过 m_split_lines 的整数倍
+    void switch_log(const tm& my_tm, long long lines);
+    // 当前线程的环形缓冲区，首次调用时创建并登记
+    LogRing* local_ring();
+    // 为一条记录预留空间：异步模式下在本线程的缓冲区中（写满时按策略丢弃或等待，丢弃返回 nullptr），
+    // 同步模式或记录过大时在线程局部的临时区中
+    LogRecord* reserve_record(size_t len, bool* in_ring);
+    // 发布 reserve_record 得到的记录：在缓冲区中则提交，否则在调用线程格式化后写入
+    void commit_record(LogRecord* record, bool in_ring);
+    // 同步写入一整行
+    void write_line(const char* line, size_t len, const tm& my_tm);
+    // 唤醒写线程
+    void wake();
+    // 取走所有缓冲区中的数据并写入文件，返回取走的字节数
+    size_t drain();
+    // 把已收集的 iovec 写入文件（写线程）
+    void write_batch();
 
 private:
     std::string m_dir_name;
@@ -48,37 +118,92 @@ private:
     int m_log_buf_size;
     long long m_count;//日志行数
     int m_today;
-    FILE* m_fp;
-    
-    int m_flush_interval = 1;   // 每写多少条日志就 flush 一次，默认 10
-    int m_unflushed = 0;         // 已经写入但未 flush 的日志条数
+    int m_fd;
+    std::mutex m_mutex;   // 保护文件（切换与写入）
+
+    // 异步模式
+    bool m_is_async;
+    size_t m_ring_size;
+    size_t m_record_limit;                // 可放入缓冲区的最大记录
+    std::atomic<LogFullPolicy> m_policy;
+    std::atomic<uint64_t> m_dropped;
+    uint64_t m_reported_dropped;          // 已写入"丢弃"提示的条数（仅写线程访问）
+    std::mutex m_rings_mutex;             // 保护 m_rings 的登记与回收
+    std::vector<std::unique_ptr<LogRing>> m_rings;
+    std::vector<LogRing*> m_drain_rings;  // 以下几项仅写线程使用，跨批复用
+    std::vector<uint64_t> m_drain_end;
+    std::vector<iovec> m_drain_iov;
+    std::vector<char> m_format_buf;       // 写线程格式化延迟记录的输出区
+    size_t m_format_used;
+    long long m_batch_lines;
+    std::atomic<int> m_level;
     std::thread m_thread;
-    BlockQueue<std::string>* m_log_queue;
-    std::mutex m_mutex;
+    std::mutex m_cond_mutex;
+    std::condition_variable m_cond;       // 唤醒写线程
+    std::condition_variable m_flushed;    // flush() 等待写线程完成一轮
+    bool m_wake;
+    uint64_t m_flush_request;
+    uint64_t m_flush_done;
     std::atomic<bool> m_exit;
-    bool m_is_async;
 };
 
-// 宏定义
+template <class... Args>
+void Log::write_deferred(int level, const char* format, const Args&... args)
+{
+    size_t limit = (size_t)m_log_buf_size;
+    size_t len = sizeof(LogDeferred) + (size_t(0) + ... + log_detail::arg_size(args, limit));
+    bool in_ring;
+    LogRecord* record = reserve_record(len, &in_ring);
+    if (!record) {
+        return; // 缓冲区已满，按策略丢弃
+    }
+    record->kind = LogRecord::Deferred;
+    record->level = (uint16_t)level;
+
+    LogDeferred head;
+    head.fmt = format;
+    head.format = &log_detail::format_args<Args...>;
+    clock_gettime(CLOCK_REALTIME, &head.time);
+    char* p = reinterpret_cast<char*>(record + 1);
+    memcpy(p, &head, sizeof(head));
+    p += sizeof(head);
+    (log_detail::encode(p, args, limit), ...);
+    (void)p;
+    (void)limit;
+
+    commit_record(record, in_ring);
+}
+
+// 宏定义：先按编译期、运行期级别过滤，通过后才对参数求值
+
+#define LOG_ENABLED(level) ((level) >= LOG_MIN_LEVEL && Log::get_instance()->enabled(level))
 
 #define LOG_DEBUG(format, ...) \
-    if(Log::get_instance()->m_close_log == 0) { \
-        Log::get_instance()->write_log(0, format, ##__VA_ARGS__); \
-    }
+    do { \
+        if (LOG_ENABLED(0)) { \
+            Log::get_instance()->write_deferred(0, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 #define LOG_INFO(format, ...) \
-    if(Log::get_instance()->m_close_log == 0) { \
-        Log::get_instance()->write_log(1, format, ##__VA_ARGS__); \
-    }
+    do { \
+        if (LOG_ENABLED(1)) { \
+            Log::get_instance()->write_deferred(1, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 #define LOG_WARN(format, ...) \
-    if(Log::get_instance()->m_close_log == 0) { \
-        Log::get_instance()->write_log(2, format, ##__VA_ARGS__); \
-    }
+    do { \
+        if (LOG_ENABLED(2)) { \
+            Log::get_instance()->write_deferred(2, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 #define LOG_ERROR(format, ...) \
-    if(Log::get_instance()->m_close_log == 0) { \
-        Log::get_instance()->write_log(3, format, ##__VA_ARGS__); \
-    }
+    do { \
+        if (LOG_ENABLED(3)) { \
+            Log::get_instance()->write_deferred(3, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 #endif
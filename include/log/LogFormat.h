@@ -0,0 +1,104 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+// 延迟格式化：调用方只保存格式串指针与原始参数，由日志写线程调用 snprintf
+// - 格式串必须是字符串字面量（LOG_* 宏保证），写线程格式化时它仍然有效
+// - 字符串参数（char*、std::string、std::string_view）按值拷贝进记录，其余参数
+//   （整数、浮点、枚举、void* 等指针）原样保存；解码时还原为原类型再交给 snprintf
+// - %.*s 配合非 '\0' 结尾的缓冲区时请改传 std::string_view
+
+// 格式化函数：把 args 处的参数解码后按 fmt 写入 buf，返回值同 snprintf
+using LogFormatFn = int (*)(char* buf, size_t size, const char* fmt, const char* args);
+
+// 延迟记录在 LogRecord 头部之后的固定部分，参数紧随其后
+struct LogDeferred {
+    const char* fmt;
+    LogFormatFn format;
+    timespec time;      // 调用时刻，时间戳前缀由写线程生成
+};
+
+namespace log_detail {
+
+    template <class T>
+    struct is_text : std::integral_constant<bool,
+        std::is_same<T, char*>::value || std::is_same<T, const char*>::value ||
+        std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value> {};
+
+    // 记录中保存的类型：字符串解码为 const char*，其余为参数本身的类型
+    template <class T>
+    using stored_t = typename std::conditional<is_text<std::decay_t<T>>::value,
+                                               const char*, std::decay_t<T>>::type;
+
+    inline std::string_view as_text(const char* s) { return s ? std::string_view(s) : std::string_view("(null)"); }
+    inline std::string_view as_text(const std::string& s) { return s; }
+    inline std::string_view as_text(std::string_view s) { return s; }
+
+    // 字符串：uint32 长度 + 内容 + '\0'，最多保存 limit 字节（超出部分反正会被单行长度截断）
+    template <class T>
+    size_t arg_size(const T& value, size_t limit) {
+        if constexpr (is_text<std::decay_t<T>>::value) {
+            return sizeof(uint32_t) + std::min(as_text(value).size(), limit) + 1;
+        } else {
+            static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value ||
+                          std::is_null_pointer<T>::value,
+                          "LOG_* arguments must be strings, arithmetic types, enums or pointers");
+            return sizeof(T);
+        }
+    }
+
+    template <class T>
+    void encode(char*& p, const T& value, size_t limit) {
+        if constexpr (is_text<std::decay_t<T>>::value) {
+            std::string_view text = as_text(value);
+            uint32_t len = (uint32_t)std::min(text.size(), limit);
+            memcpy(p, &len, sizeof(len));
+            memcpy(p + sizeof(len), text.data(), len);
+            p[sizeof(len) + len] = '\0';
+            p += sizeof(len) + len + 1;
+        } else {
+            memcpy(p, &value, sizeof(T));
+            p += sizeof(T);
+        }
+    }
+
+    template <class T>
+    stored_t<T> decode(const char*& p) {
+        if constexpr (is_text<std::decay_t<T>>::value) {
+            uint32_t len;
+            memcpy(&len, p, sizeof(len));
+            const char* text = p + sizeof(len);
+            p += sizeof(len) + len + 1;
+            return text;
+        } else {
+            stored_t<T> value;
+            memcpy(&value, p, sizeof(value));
+            p += sizeof(value);
+            return value;
+        }
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+    template <class... Args>
+    int format_args(char* buf, size_t size, const char* fmt, const char* args) {
+        // 花括号初始化保证按参数顺序依次解码
+        std::tuple<stored_t<Args>...> values{decode<Args>(args)...};
+        (void)args;
+        return std::apply([&](auto... v) { return snprintf(buf, size, fmt, v...); }, values);
+    }
+#pragma GCC diagnostic pop
+
+} // namespace log_detail
+
+#endif // LOG_FORMAT_H
@@ -0,0 +1,116 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// 环形缓冲区中每条记录的头部
+struct LogRecord {
+    enum Kind : uint16_t {
+        Pad,        // 填充到缓冲区末尾，消费者跳过
+        Text,       // 已格式化好的整行，length 为字节数（含换行）
+        Deferred    // 格式串指针 + 原始参数，由写线程格式化（见 LogFormat.h）
+    };
+    uint32_t size;     // 整条记录占用的字节数（含头部，按 LOG_RECORD_ALIGN 对齐）
+    uint32_t length;   // 头部之后的有效字节数
+    uint16_t kind;
+    uint16_t level;
+    uint32_t reserved;
+};
+
+const size_t LOG_RECORD_ALIGN = sizeof(LogRecord);
+
+// 单生产者单消费者记录环形缓冲区（每个写日志的线程一个）
+// - 每条记录在缓冲区中连续存放，剩余空间放不下时先写一条 Pad 记录绕回开头
+// - 生产者 reserve 后原地填写记录，commit 才发布 tail，消费者看到的总是完整记录
+// - 消费者（日志写线程）遍历 [head, tail) 内的记录，写完后再推进 head
+// - head/tail 为单调递增的字节序号，下标取低位；两者分处不同缓存行，生产者另缓存一份 head 减少跨核读取
+class LogRing {
+public:
+    // capacity 向上取整为 2 的幂
+    explicit LogRing(size_t capacity) {
+        size_t size = 4096;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_data.reset(new char[size]);
+        m_mask = size - 1;
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief 生产者：预留一条记录的连续空间并填好 size
+     * @param len 头部之后的有效字节数
+     * @return 记录头部；空间不足时返回 nullptr（不改变缓冲区）
+     */
+    LogRecord* reserve(size_t len) {
+        size_t size = (sizeof(LogRecord) + len + LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1);
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t offset = tail & m_mask;
+        size_t pad = (capacity() - offset < size) ? capacity() - offset : 0;
+        if (tail + pad + size - m_cached_head > capacity()) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            if (tail + pad + size - m_cached_head > capacity()) {
+                return nullptr;
+            }
+        }
+        if (pad) {
+            LogRecord* filler = reinterpret_cast<LogRecord*>(m_data.get() + offset);
+            filler->size = (uint32_t)pad;
+            filler->kind = LogRecord::Pad;
+            tail += pad;
+            offset = 0;
+        }
+        m_reserved = tail + size;
+        LogRecord* record = reinterpret_cast<LogRecord*>(m_data.get() + offset);
+        record->size = (uint32_t)size;
+        record->length = (uint32_t)len;
+        return record;
+    }
+
+    // 生产者：发布最近一次 reserve 的记录
+    void commit() {
+        m_tail.store(m_reserved, std::memory_order_release);
+    }
+
+    // 生产者：已用字节数（用于判断是否需要提前唤醒写线程）
+    size_t used() const {
+        return m_tail.load(std::memory_order_relaxed) - m_cached_head;
+    }
+
+    // 消费者：可读区间 [begin(), end())，用 at() 取得记录，按 size 前进
+    uint64_t begin() const { return m_head.load(std::memory_order_relaxed); }
+    uint64_t end() const { return m_tail.load(std::memory_order_acquire); }
+    const LogRecord* at(uint64_t pos) const {
+        return reinterpret_cast<const LogRecord*>(m_data.get() + (pos & m_mask));
+    }
+
+    // 消费者：释放 pos 之前的所有记录
+    void consume(uint64_t pos) {
+        m_head.store(pos, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    // 所属线程已退出：写线程取完剩余数据后释放本缓冲区
+    std::atomic<bool> orphaned{false};
+
+private:
+    alignas(64) std::atomic<uint64_t> m_head{0};  // 消费者推进
+    alignas(64) std::atomic<uint64_t> m_tail{0};  // 生产者推进
+    uint64_t m_cached_head = 0;                   // 生产者看到的 head
+    uint64_t m_reserved = 0;                      // reserve 后待发布的 tail
+    std::unique_ptr<char[]> m_data;
+    size_t m_mask = 0;
+};
+
+#endif // LOG_RING_H
@@ -0,0 +1,204 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 运行时指标（Prometheus 文本格式，由 /metrics 路由导出）
+// - 每个线程一个 MetricsShard，热路径只更新本线程的计数器：单写者，relaxed 读后写，没有原子读改写与锁
+// - 抓取时才遍历所有分片求和；线程退出后分片保留，计数保持单调
+// - 各组件自己持有的状态（连接池、超时计数等）通过 add_collector 在抓取时读取
+
+const size_t METRICS_MAX_ROUTES = 64;     // 路由编号上限，0 号表示未匹配路由，超出的路由计入最后一个
+const size_t METRICS_MAX_REACTORS = 64;   // SubReactor 编号上限
+
+// 单写者计数器
+class MetricCounter {
+public:
+    void add(uint64_t n = 1) {
+        m_value.store(m_value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+// HDR 风格直方图（单写者）：小于 16 的值各占一个桶，之后每个 2 倍区间再分 16 个线性子桶，
+// 相对误差不超过 1/16；超过 2^41 的值计入最后一个桶
+const int HIST_SUB_BITS = 4;
+const size_t HIST_SUB_COUNT = size_t(1) << HIST_SUB_BITS;
+const int HIST_MAX_EXP = 40;
+const size_t HIST_BUCKETS = (HIST_MAX_EXP - HIST_SUB_BITS + 2) * HIST_SUB_COUNT;
+
+class Histogram {
+public:
+    void record(uint64_t value) {
+        size_t i = bucket_of(value);
+        m_counts[i].store(m_counts[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < HIST_SUB_COUNT) {
+            return (size_t)value;
+        }
+        int exp = 63 - __builtin_clzll(value);
+        if (exp > HIST_MAX_EXP) {
+            return HIST_BUCKETS - 1;
+        }
+        size_t sub = (size_t)(value >> (exp - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1);
+        return (size_t)(exp - HIST_SUB_BITS + 1) * HIST_SUB_COUNT + sub;
+    }
+
+    // 桶 i 覆盖 [lower, upper)
+    static uint64_t bucket_upper(size_t i) {
+        if (i < HIST_SUB_COUNT) {
+            return i + 1;
+        }
+        int shift = (int)(i / HIST_SUB_COUNT) - 1;
+        return (uint64_t)(HIST_SUB_COUNT + i % HIST_SUB_COUNT + 1) << shift;
+    }
+
+    uint64_t count(size_t i) const { return m_counts[i].load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_counts[HIST_BUCKETS] = {};
+    std::atomic<uint64_t> m_sum{0};
+};
+
+// 抓取时合并多个 Histogram 的结果
+struct HistogramSnapshot {
+    uint64_t counts[HIST_BUCKETS] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    void add(const Histogram& h);
+};
+
+// 每个线程的指标分片
+struct MetricsShard {
+    MetricCounter accepts;                          // 建立的连接
+    MetricCounter parse_errors;                     // HTTP 解析错误
+    MetricCounter bytes_in;                         // HTTP 读取字节
+    MetricCounter bytes_out;                        // HTTP 发送字节
+    MetricCounter requests[METRICS_MAX_ROUTES][32]; // [路由][状态码槽位]，槽位见 Metrics.cpp
+    MetricCounter reactor_posted[METRICS_MAX_REACTORS]; // 投递到各 SubReactor 的任务
+    MetricCounter reactor_run[METRICS_MAX_REACTORS];    // 各 SubReactor 已执行的任务
+    MetricCounter ws_frames_in;
+    MetricCounter ws_frames_out;
+    MetricCounter ws_overload_closes;   // 线程池过载时以 1013 关闭的 WebSocket 连接
+    Histogram task_wait_ns;     // ThreadPool 任务从入队到开始执行
+    Histogram sql_wait_ns;      // 等待数据库连接
+    Histogram ws_fanout;        // 每次房间广播的接收者数
+};
+
+// 抓取时输出 Prometheus 文本格式
+class MetricsWriter {
+public:
+    explicit MetricsWriter(std::string& out) : m_out(out) {}
+
+    // 指标族的 HELP / TYPE 行
+    void family(const char* name, const char* help, const char* type);
+
+    // 一个样本，labels 形如 reactor="0"，可为空
+    void sample(const char* name, const std::string& labels, uint64_t value);
+    void sample(const char* name, const std::string& labels, double value);
+
+    /**
+     * @brief 直方图样本：_bucket（累计）、_sum、_count
+     * @param bounds 导出的 le 上界（导出单位），升序
+     * @param scale 记录值换算为导出单位的系数（纳秒 -> 秒为 1e-9）
+     */
+    void histogram(const char* name, const std::string& labels, const HistogramSnapshot& h,
+                   const double* bounds, size_t bound_count, double scale);
+
+private:
+    std::string& m_out;
+};
+
+// 导出的 le 上界：耗时（秒）与个数
+extern const double METRICS_LATENCY_BOUNDS[];
+extern const size_t METRICS_LATENCY_BOUND_COUNT;
+extern const double METRICS_COUNT_BOUNDS[];
+extern const size_t METRICS_COUNT_BOUND_COUNT;
+
+class Metrics {
+public:
+    static Metrics& get_instance() {
+        static Metrics* instance = new Metrics();
+        return *instance;  // 永不析构，退出过程中仍在运行的线程可以继续计数
+    }
+
+    // 当前线程的分片，首次调用时创建并登记
+    static MetricsShard& local() {
+        thread_local MetricsShard* shard = nullptr;
+        if (!shard) {
+            shard = get_instance().create_shard();
+        }
+        return *shard;
+    }
+
+    static uint64_t now_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    /**
+     * @brief 登记一条路由，返回其指标编号（1 起，超出上限后都返回最后一个编号）
+     * @param label 导出时的 route 标签，如 "GET /api/test"
+     */
+    uint32_t register_route(const std::string& label);
+
+    // 路由编号对应的 route 标签
+    std::string route_label(uint32_t route_id);
+
+    // 记录一个请求的结果
+    static void record_request(uint32_t route_id, int status) {
+        local().requests[route_id][status_slot(status)].add();
+    }
+
+    // SubReactor 任务队列：投递一次 / 执行 n 个
+    static void reactor_posted(int reactor) {
+        local().reactor_posted[reactor_slot(reactor)].add();
+    }
+    static void reactor_run(int reactor, uint64_t n) {
+        local().reactor_run[reactor_slot(reactor)].add(n);
+    }
+
+    // 各分片之和：SubReactor reactor 的任务队列中尚未执行的任务数
+    uint64_t reactor_queue_depth(int reactor);
+
+    // 抓取时调用的收集函数，用于导出各组件自己持有的状态；返回编号用于移除
+    size_t add_collector(std::function<void(MetricsWriter&)> collector);
+    void remove_collector(size_t id);
+
+    // 生成完整的 Prometheus 文本
+    std::string render();
+
+private:
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    MetricsShard* create_shard();
+    static size_t status_slot(int status);
+    static size_t reactor_slot(int reactor) {
+        return reactor >= 0 && (size_t)reactor < METRICS_MAX_REACTORS ? (size_t)reactor : METRICS_MAX_REACTORS - 1;
+    }
+
+    std::mutex m_mutex;   // 保护以下所有成员（热路径不加锁）
+    std::vector<std::unique_ptr<MetricsShard>> m_shards;
+    std::vector<std::string> m_routes{"none"};
+    std::vector<std::function<void(MetricsWriter&)>> m_collectors;
+};
+
+#endif // METRICS_H
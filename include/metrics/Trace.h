@@ -0,0 +1,98 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 按请求的阶段耗时追踪（采样）
+// - 每 N 个请求（按 Reactor 线程计数）采样一个，未采样的请求在各阶段只多一次判断
+// - 采样请求在各阶段记录 CLOCK_MONOTONIC 纳秒时间戳，响应发送完毕后写入全局环形缓冲区
+// - 环形缓冲区每个槽位是一个顺序锁：写者把序号改为奇数、写入、再改为偶数，读者拷贝前后序号一致才有效；
+//   写者抢不到槽位（另一个写者正在写同一个槽位）时直接丢弃该记录
+// - /admin/trace 导出最近的记录与各阶段的分位数，?format=chrome 导出 Chrome trace-event JSON
+
+// 请求经过的时间点（按先后顺序）
+enum class TracePoint : uint8_t {
+    Accept,         // 连接交给 SubReactor（只有连接上的第一个请求记录）
+    Read,           // 读到请求的第一批字节
+    Parsed,         // 请求头解析完成（带请求体的请求为整个请求接收完成）
+    Routed,         // 路由匹配完成
+    HandlerStart,   // handler 开始执行（Pool 路由在工作线程中）
+    HandlerEnd,     // handler 与响应压缩完成
+    Queued,         // 响应序列化进发送队列
+    Reactor,        // Pool 路由的结果经 addTask 回到 SubReactor 线程
+    Flushed,        // 响应全部写入 socket
+    Count
+};
+
+const size_t TRACE_RING_SIZE = 4096;    // 保留最近的采样记录数（2 的幂）
+const size_t TRACE_PATH_MAX = 56;       // 记录中保存的请求路径长度上限（含 '\0'）
+
+// 一个采样请求，时间戳为 0 表示未经过该点
+struct TraceRecord {
+    uint64_t t[(size_t)TracePoint::Count];
+    uint32_t reactor_tid;   // 读取/解析请求的线程
+    uint32_t worker_tid;    // 执行 handler 的线程
+    uint32_t route_id;      // Metrics::register_route 返回的编号，0 表示未匹配路由
+    int32_t fd;
+    uint16_t status;
+    uint8_t method;         // HttpMethod
+    uint8_t reserved;
+    char path[TRACE_PATH_MAX];
+};
+
+class Trace {
+public:
+    static Trace& get_instance() {
+        static Trace* instance = new Trace();
+        return *instance;  // 永不析构，与 Metrics 一致
+    }
+
+    /**
+     * @brief 设置采样率
+     * @param every 每 every 个请求采样一个，0 表示关闭
+     */
+    void set_sample_rate(uint32_t every) { m_every.store(every, std::memory_order_relaxed); }
+    uint32_t sample_rate() const { return m_every.load(std::memory_order_relaxed); }
+    bool enabled() const { return sample_rate() != 0; }
+
+    // 当前线程处理的下一个请求是否采样
+    bool sample();
+
+    // 当前线程的内核线程号（缓存）
+    static uint32_t thread_id();
+
+    // 把一条完成的记录写入环形缓冲区（任意线程）
+    void commit(const TraceRecord& record);
+
+    // 按从新到旧的顺序拷贝至多 limit 条记录
+    void snapshot(std::vector<TraceRecord>& out, size_t limit) const;
+
+    // 文本格式：各阶段耗时的分位数 + 最近 limit 条记录的阶段明细
+    std::string render_text(size_t limit) const;
+
+    // Chrome trace-event JSON（chrome://tracing、Perfetto 可直接打开）
+    std::string render_chrome(size_t limit) const;
+
+private:
+    Trace() = default;
+    Trace(const Trace&) = delete;
+    Trace& operator=(const Trace&) = delete;
+
+    static const size_t WORDS = (sizeof(TraceRecord) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // 记录按 8 字节一组存放在原子变量中，读写都是 relaxed 访问，顺序由序号与栅栏保证（同 HttpClock）
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> words[WORDS] = {};
+    };
+
+    std::atomic<uint32_t> m_every{0};
+    std::atomic<uint64_t> m_next{0};   // 下一条记录的编号
+    Slot m_slots[TRACE_RING_SIZE];
+};
+
+#endif // TRACE_H
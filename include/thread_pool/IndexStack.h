@@ -0,0 +1,66 @@
+#ifndef INDEX_STACK_H
+#define INDEX_STACK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+// 带版本号的无锁下标栈（Treiber 栈），用于管理预分配数组中的空闲槽位
+// 栈顶为 64 位：高 32 位是版本号，低 32 位是下标 + 1（0 表示空栈），版本号避免 ABA
+class IndexStack {
+public:
+    // 构造后 [0, capacity) 全部处于空闲状态；all_free 为 false 时构造为空栈
+    explicit IndexStack(size_t capacity, bool all_free = true)
+        : m_next(new std::atomic<uint32_t>[capacity]), m_capacity(capacity), m_top(0) {
+        if (capacity >= UINT32_MAX) {
+            throw std::invalid_argument("IndexStack capacity too large");
+        }
+        for (size_t i = capacity; i > 0; --i) {
+            m_next[i - 1].store(0, std::memory_order_relaxed);
+            if (all_free) {
+                push(static_cast<uint32_t>(i - 1));
+            }
+        }
+    }
+
+    // 禁止拷贝和赋值
+    IndexStack(const IndexStack&) = delete;
+    IndexStack& operator=(const IndexStack&) = delete;
+
+    // 取出一个空闲下标，栈空返回 false
+    bool pop(uint32_t& idx) {
+        uint64_t old = m_top.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t cur = static_cast<uint32_t>(old);
+            if (cur == 0) return false;
+            uint64_t next = (((old >> 32) + 1) << 32) | m_next[cur - 1].load(std::memory_order_relaxed);
+            if (m_top.compare_exchange_weak(old, next, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                idx = cur - 1;
+                return true;
+            }
+        }
+    }
+
+    // 归还一个下标
+    void push(uint32_t idx) {
+        uint64_t old = m_top.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            m_next[idx].store(static_cast<uint32_t>(old), std::memory_order_relaxed);
+            next = (((old >> 32) + 1) << 32) | (static_cast<uint64_t>(idx) + 1);
+        } while (!m_top.compare_exchange_weak(old, next, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next; // 每个下标在栈中的后继（下标 + 1）
+    size_t m_capacity;
+    alignas(64) std::atomic<uint64_t> m_top;
+};
+
+#endif // INDEX_STACK_H
@@ -0,0 +1,122 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include "IndexStack.h"
+
+// 多生产者单消费者无锁侵入式队列（Vyukov MPSC）
+// - push 可由任意线程并发调用，只需一次原子 exchange
+// - pop 只能由唯一的消费者线程调用，不加锁
+// - 节点从预分配数组中取得，空闲节点用 IndexStack 管理，
+//   预分配节点耗尽时退化为堆分配，由消费者释放
+template <class T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t prealloc = 4096)
+        : m_nodes(prealloc > 0 ? new Node[prealloc] : nullptr), m_node_count(prealloc),
+          m_free(prealloc) {
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+        m_head.store(&m_stub, std::memory_order_relaxed);
+        m_tail = &m_stub;
+    }
+
+    ~MpscQueue() {
+        T item;
+        while (pop(item)) {
+        }
+        delete[] m_nodes;
+    }
+
+    // 禁止拷贝和赋值
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // 入队（多生产者，线程安全）
+    void push(T&& item) {
+        Node* n = acquire_node();
+        n->value = std::move(item);
+        push_node(n);
+    }
+
+    // 出队（仅消费者线程调用）
+    // 队列为空，或某个生产者已占位但尚未完成链接时返回 false
+    bool pop(T& item) {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+
+        // 跳过哨兵节点
+        if (tail == &m_stub) {
+            if (next == nullptr) return false;
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr) {
+            m_tail = next;
+            take(tail, item);
+            return true;
+        }
+
+        // tail 是最后一个已链接的节点；若 head 已前移，说明有生产者正在链接
+        if (tail != m_head.load(std::memory_order_acquire)) return false;
+
+        // 重新插入哨兵，使 tail 可以被安全取出
+        push_node(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            m_tail = next;
+            take(tail, item);
+            return true;
+        }
+        return false;
+    }
+
+    // 判断队列是否为空（仅消费者线程调用）；有生产者正在链接时视为非空
+    bool empty() const {
+        return m_tail == &m_stub && m_head.load(std::memory_order_acquire) == &m_stub;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    void push_node(Node* n) {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = m_head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    void take(Node* n, T& item) {
+        item = std::move(n->value);
+        n->value = T(); // 及时释放闭包捕获的资源
+        if (n >= m_nodes && n < m_nodes + m_node_count) {
+            m_free.push(static_cast<uint32_t>(n - m_nodes));
+        } else {
+            delete n;
+        }
+    }
+
+    Node* acquire_node() {
+        uint32_t idx;
+        if (m_free.pop(idx)) {
+            return &m_nodes[idx];
+        }
+        return new Node(); // 预分配节点耗尽，退化为堆分配
+    }
+
+    alignas(64) std::atomic<Node*> m_head; // 生产者端
+    alignas(64) Node* m_tail;              // 消费者端
+    Node m_stub;                           // 哨兵节点
+
+    Node* m_nodes;                         // 预分配节点数组
+    size_t m_node_count;
+    IndexStack m_free;                     // 空闲节点下标
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,152 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 任务对象内联存储的字节数：足以放下 [shared_ptr, this, fd, Action] 这类热路径闭包
+const size_t TASK_INLINE_SIZE = 48;
+
+template <class Sig, size_t N = TASK_INLINE_SIZE>
+class InlineFunction;
+
+// 只可移动的小缓冲区可调用对象（std::function 的替代）
+// - 闭包不超过 N 字节且可无异常移动时直接存放在对象内部，构造/移动/调用都不分配堆内存
+// - 更大的闭包退化为堆分配（行为与 std::function 一致，只是多一次分配）
+// - 不可拷贝：任务只会被投递一次、执行一次，省去 std::function 的拷贝开销
+template <class R, class... Args, size_t N>
+class InlineFunction<R(Args...), N>
+{
+public:
+    InlineFunction() noexcept : m_ops(nullptr) {}
+    InlineFunction(std::nullptr_t) noexcept : m_ops(nullptr) {}
+
+    template <class F, class D = typename std::decay<F>::type,
+              class = typename std::enable_if<!std::is_same<D, InlineFunction>::value>::type>
+    InlineFunction(F &&f) : m_ops(nullptr)
+    {
+        if constexpr (stored_inline<D>())
+            ::new (static_cast<void *>(m_storage)) D(std::forward<F>(f));
+        else
+            *reinterpret_cast<D **>(m_storage) = new D(std::forward<F>(f));
+        m_ops = &ops_for<D>::value;
+    }
+
+    InlineFunction(InlineFunction &&other) noexcept : m_ops(nullptr)
+    {
+        move_from(other);
+    }
+
+    InlineFunction &operator=(InlineFunction &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    InlineFunction &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    // 禁止拷贝
+    InlineFunction(const InlineFunction &) = delete;
+    InlineFunction &operator=(const InlineFunction &) = delete;
+
+    ~InlineFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    R operator()(Args... args) const
+    {
+        return m_ops->invoke(const_cast<unsigned char *>(m_storage), std::forward<Args>(args)...);
+    }
+
+    // 闭包类型 F 是否会存放在内联缓冲区中（可用于 static_assert 检查热路径闭包的大小）
+    template <class F>
+    static constexpr bool stored_inline()
+    {
+        return sizeof(F) <= N && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+private:
+    struct Ops
+    {
+        R (*invoke)(void *, Args &&...);
+        void (*move)(void *dst, void *src) noexcept; // 移动到 dst 并销毁 src
+        void (*destroy)(void *) noexcept;
+    };
+
+    template <class D, bool Inline = stored_inline<D>()>
+    struct ops_for;
+
+    // 内联存储：闭包对象直接构造在缓冲区中
+    template <class D>
+    struct ops_for<D, true>
+    {
+        static R invoke(void *p, Args &&...args)
+        {
+            return (*static_cast<D *>(p))(std::forward<Args>(args)...);
+        }
+        static void move(void *dst, void *src) noexcept
+        {
+            ::new (dst) D(std::move(*static_cast<D *>(src)));
+            static_cast<D *>(src)->~D();
+        }
+        static void destroy(void *p) noexcept { static_cast<D *>(p)->~D(); }
+        static constexpr Ops value{&invoke, &move, &destroy};
+    };
+
+    // 堆存储：缓冲区中只保存指针，移动时转移指针
+    template <class D>
+    struct ops_for<D, false>
+    {
+        static R invoke(void *p, Args &&...args)
+        {
+            return (**static_cast<D **>(p))(std::forward<Args>(args)...);
+        }
+        static void move(void *dst, void *src) noexcept
+        {
+            std::memcpy(dst, src, sizeof(D *));
+        }
+        static void destroy(void *p) noexcept { delete *static_cast<D **>(p); }
+        static constexpr Ops value{&invoke, &move, &destroy};
+    };
+
+    void move_from(InlineFunction &other) noexcept
+    {
+        if (other.m_ops)
+        {
+            other.m_ops->move(m_storage, other.m_storage);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (m_ops)
+        {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    static_assert(N >= sizeof(void *), "InlineFunction buffer must hold at least a pointer");
+
+    alignas(std::max_align_t) unsigned char m_storage[N];
+    const Ops *m_ops;
+};
+
+// 线程池与 SubReactor 使用的任务类型
+using Task = InlineFunction<void()>;
+
+#endif // TASK_H
@@ -1,25 +1,34 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
-#include <list>
-#include <functional>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <vector>
+#include <memory>
+#include <atomic>
 #include <iostream>
 #include <exception>
 #include <chrono>
+#include "Task.h"
+#include "MpscQueue.h"
+#include "IndexStack.h"
+#include "WorkStealingDeque.h"
 
+// 工作窃取线程池
+// - 任务存放在预分配的任务槽中，槽位数即 max_requests，槽位耗尽时 append 返回 false（过载信号）
+// - 每个工作线程有一个无锁收件箱（外部线程投递）和一个 Chase-Lev 双端队列（自己执行、他人窃取）
+// - 同一提交线程默认总是投递给同一个工作线程（亲和性）；目标线程忙时叫醒一个空闲线程，
+//   空闲线程既能窃取其他线程的双端队列，也能接管其他线程收件箱中尚未取走的任务
 class ThreadPool
 {
 public:
-    using Task = std::function<void()>;
+    using Task = ::Task; // 只可移动的小缓冲区任务，热路径闭包不分配堆内存
 
     /**
      * @brief 构造函数，初始化线程池
      * @param thread_number 线程池中的线程数量
-     * @param max_requests 任务队列的最大请求数
+     * @param max_requests 排队任务的最大数量
      * @param shutdown_timeout 析构时等待线程结束的超时时间（秒）
      */
     ThreadPool(int thread_number = 8, int max_requests = 10000, int shutdown_timeout = 2);
@@ -29,25 +38,69 @@ public:
     /**
      * @brief 向线程池添加任务
      * @param task 需要添加的任务
-     * @return 成功返回 true，失败返回 false
+     * @param hint 亲和性提示，>=0 时投递给第 hint % 线程数 个工作线程；
+     *             -1 时按提交线程固定分配一个工作线程
+     * @return 成功返回 true；排队任务已达 max_requests（过载）或线程池已停止时返回 false，
+     *         调用方应据此降级处理（例如返回 503），任务不会被执行
      */
-    bool append(Task task);
+    bool append(Task task, int hint = -1);
+
+    // 当前排队（尚未开始执行）的任务数
+    size_t queue_size() const { return m_queued.load(std::memory_order_relaxed); }
+
+    // 排队任务是否已达上限
+    bool overloaded() const { return queue_size() >= (size_t)m_max_requests; }
 
 private:
-    /** 
+    struct Worker
+    {
+        explicit Worker(size_t capacity) : inbox(capacity), deque(capacity) {}
+
+        MpscQueue<uint32_t> inbox;          // 外部线程投递的任务槽下标
+        std::atomic<bool> inbox_busy{false}; // 收件箱消费端的锁，同一时刻只有一个线程（本线程或窃取者）取收件箱
+        std::atomic<size_t> inbox_pending{0}; // 收件箱中的任务数，休眠判断使用
+        WorkStealingDeque<uint32_t> deque;  // 本线程待执行的任务槽下标，可被窃取
+        std::mutex mtx;                     // 仅用于休眠/唤醒
+        std::condition_variable cv;
+        std::atomic<bool> sleeping{false};
+        std::atomic<bool> notified{false};  // 被其他线程叫醒去窃取任务
+        std::thread thread;
+    };
+
+    /**
      * @brief 线程运行的函数
+     * @param id 工作线程编号
     */
-    void run();
+    void run(int id);
+
+    // 依次尝试：自己的队列、收件箱、窃取其他线程的队列或收件箱
+    bool next_task(int id, uint32_t &slot);
+
+    /**
+     * @brief 把工作线程 owner 收件箱中的任务全部转入工作线程 id 的双端队列
+     * @return 转入的任务数；收件箱正被其他线程消费时返回 0
+     */
+    int drain_inbox(int owner, int id);
+
+    // 取出任务槽中的任务、归还槽位并执行
+    void execute(uint32_t slot);
+
+    // 唤醒工作线程 id（如果它正在休眠）
+    void wake(int id);
+
+    // 唤醒除 self 外的一个休眠线程来窃取任务
+    void wake_thief(int self);
 
 private:
     int m_thread_number;                 // 线程数
     int m_max_requests;                  // 最大任务数
-    std::vector<std::thread> m_threads;  // 线程数组
-    std::list<Task> m_workqueue;         // 任务队列
-    std::mutex m_queuelocker;            // 任务队列锁
-    std::condition_variable m_queuestat; // 条件变量，用于线程同步
-    bool m_stop;                         // 是否停止线程池
+    std::unique_ptr<Task[]> m_slots;     // 预分配的任务槽
+    std::unique_ptr<uint64_t[]> m_enqueued_ns; // 各任务槽的入队时刻（CLOCK_MONOTONIC 纳秒），用于统计排队耗时
+    IndexStack m_free_slots;             // 空闲任务槽
+    std::vector<std::unique_ptr<Worker>> m_workers; // 工作线程
+    std::atomic<size_t> m_queued;        // 排队中的任务数
+    std::atomic<bool> m_stop;            // 是否停止线程池
     int m_shutdown_timeout;              // 析构等待的超时时间（秒）
 };
 
-#endif // THREAD_POOL_H
\ No newline at end of file
+#endif // THREAD_POOL_H
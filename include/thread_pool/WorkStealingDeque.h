@@ -0,0 +1,91 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Chase-Lev 工作窃取双端队列（固定容量版本）
+// - push/pop 只能由所属工作线程调用，在底部进行，通常无竞争
+// - steal 可由任意其他线程调用，从顶部窃取，与 pop 竞争最后一个元素时用 CAS 仲裁
+// - 元素必须可平凡拷贝（这里存放任务槽下标），容量由调用方保证不会超出
+template <class T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque element must be trivially copyable");
+
+public:
+    explicit WorkStealingDeque(size_t capacity)
+        : m_top(0), m_bottom(0) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        m_mask = static_cast<int64_t>(cap - 1);
+        m_buffer.reset(new std::atomic<T>[cap]);
+    }
+
+    // 禁止拷贝和赋值
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // 所属线程：压入底部，队列已满返回 false
+    bool push(T item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        if (b - t > m_mask) return false;
+        m_buffer[b & m_mask].store(item, std::memory_order_relaxed);
+        m_bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 所属线程：从底部弹出
+    bool pop(T& item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // 队列为空
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = m_buffer[b & m_mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // 最后一个元素，与窃取者竞争
+            bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // 其他线程：从顶部窃取，失败（为空或竞争失败）返回 false
+    bool steal(T& item) {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+
+        item = m_buffer[t & m_mask].load(std::memory_order_relaxed);
+        return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed);
+    }
+
+    // 近似长度（仅用于统计）
+    size_t size() const {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    std::unique_ptr<std::atomic<T>[]> m_buffer;
+    int64_t m_mask;
+};
+
+#endif // WORK_STEALING_DEQUE_H
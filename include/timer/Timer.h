@@ -1,43 +1,71 @@
 #ifndef TIMER_H
 #define TIMER_H
 
-#include <netinet/in.h>
-#include <time.h>
-#include <map>
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <mutex>
-#include "../tools/Tools.h"
 
 // 前向声明，避免循环依赖
 struct client_data;
 
-// 定时器对象
-struct util_timer {
-    time_t expire;                               // 定时器的绝对过期时间
+// 时间轮层级参数：第 0 层 256 个槽位（每槽 1ms），其上 4 层各 64 个槽位，
+// 各层跨度依次为 256ms、16.4s、17.5min、18.6h、49.7 天，超出最大跨度的定时器放在最高层末端
+const int TIMER_ROOT_BITS = 8;
+const int TIMER_LEVEL_BITS = 6;
+const int TIMER_LEVELS = 4;  // 第 0 层之上的层数
+const size_t TIMER_ROOT_SIZE = (size_t)1 << TIMER_ROOT_BITS;
+const size_t TIMER_LEVEL_SIZE = (size_t)1 << TIMER_LEVEL_BITS;
+const uint64_t TIMER_MAX_SPAN = ((uint64_t)1 << (TIMER_ROOT_BITS + TIMER_LEVEL_BITS * TIMER_LEVELS)) - 1;
+
+// 槽位双向循环链表的链接（槽位头是不带数据的哨兵）
+struct TimerLink {
+    TimerLink* prev = nullptr;
+    TimerLink* next = nullptr;
+};
+
+// 定时器对象：侵入式节点，直接嵌入 client_data，添加/删除不分配内存
+struct util_timer : TimerLink {
+    uint64_t expire = 0;                         // 所在槽位对应的到期时刻（毫秒，单调时钟）
+    uint64_t deadline = 0;                       // 实际到期时刻；连接活跃时只推后它，不移动节点
     std::function<void(client_data*)> cb_func;   // 回调函数（超时后执行的操作）
-    client_data* user_data;                      // 客户端数据指针
+    client_data* user_data = nullptr;            // 客户端数据指针
+
+    // 是否挂在时间轮上
+    bool active() const { return next != nullptr; }
 };
 
-// 基于 multimap 的定时器管理器
-class TimerManager 
+// 分层时间轮定时器管理器（毫秒精度）
+// - 添加、删除 O(1)：按到期时刻与当前时刻的差值选层、按到期时刻的对应位选槽位
+// - 推进时处理第 0 层的非空槽位（中间的空槽位直接跳过），第 0 层转完一圈时把上一层对应槽位的定时器重新分配到下层
+// - 延期是惰性的：adjust_timer 只改 deadline，定时器到达原槽位时若 deadline 仍在未来，再按 deadline 重新挂入
+// 只在所属 SubReactor 线程中使用，不加锁
+class TimerManager
 {
 public:
+    TimerManager();
+
+    TimerManager(const TimerManager&) = delete;
+    TimerManager& operator=(const TimerManager&) = delete;
+
+    // 单调时钟的当前毫秒数（CLOCK_MONOTONIC，经 vDSO 读取，不进内核）
+    static uint64_t now_ms();
+
     /**
      * @brief 添加定时器
-     * @param timer 需要添加的定时器指针
+     * @param timer 需要添加的定时器指针（已在本时间轮上时先摘下，不能挂在其他 TimerManager 上）
+     * @param deadline 到期时刻（毫秒，单调时钟）
      */
-    void add_timer(util_timer* timer);
+    void add_timer(util_timer* timer, uint64_t deadline);
 
     /**
-     * @brief 调整定时器的过期时间
+     * @brief 调整定时器的过期时间；推后时只记录新的 deadline，提前时重新挂入对应槽位
      * @param timer 需要调整的定时器指针
-     * @param new_expire 新的过期时间
+     * @param deadline 新的到期时刻（毫秒，单调时钟）
      */
-    void adjust_timer(util_timer* timer, time_t new_expire);
+    void adjust_timer(util_timer* timer, uint64_t deadline);
 
     /**
-     * @brief 删除定时器
+     * @brief 删除定时器（只从时间轮上摘下，节点内存归调用方）
      * @param timer 需要删除的定时器指针
      */
     void del_timer(util_timer* timer);
@@ -47,10 +75,32 @@ public:
      */
     void tick();
 
+    /**
+     * @brief 推进到指定时刻，依次执行到期定时器的回调
+     * @param now 当前时刻（毫秒，单调时钟）
+     */
+    void advance(uint64_t now);
+
+    /**
+     * @brief 下一次需要推进的时刻：第 0 层最近的非空槽位，或上层最近一个需要下放的非空槽位
+     * @return 毫秒（单调时钟），不早于当前时刻；没有定时器时返回 UINT64_MAX
+     */
+    uint64_t next_expire() const;
+
+    // 时间轮上的定时器个数
+    size_t size() const { return m_size; }
+
 private:
-    std::multimap<time_t, util_timer*> timers;
-    std::unordered_map<util_timer*, std::multimap<time_t, util_timer*>::iterator> index;
-    std::mutex timer_mutex; // 保护定时器操作的互斥锁
+    void link(util_timer* timer);
+    void cascade(TimerLink* head);
+
+    static void push_back(TimerLink* head, TimerLink* node);
+    static void unlink(TimerLink* node);
+
+    uint64_t m_current;   // 下一个待处理的毫秒
+    size_t m_size = 0;
+    TimerLink m_root[TIMER_ROOT_SIZE];
+    TimerLink m_levels[TIMER_LEVELS][TIMER_LEVEL_SIZE];
 };
 
 #endif // TIMER_H
@@ -13,6 +13,8 @@
 #include <random>
 #include <sstream>
 #include <algorithm>
+#include <string_view>
+#include <ctime>
 
 // 定义一个 Action 枚举，告知事件循环（WebServer）下一步该做什么
 enum class Action {
@@ -20,21 +22,40 @@ enum class Action {
     Write,      // 请为我注册 WRITE 事件
     Close,      // 请关闭这个连接
     Wait,        // Keep-alive 状态，等待下一个请求（注册 READ 事件）
-    Upgrade     // WebSocket 协议升级
+    Upgrade,    // WebSocket 协议升级
+    Process     // 请求已解析，路由要求交给工作线程池执行 handler
 };
 
-// 前向声明
-struct util_timer;
-class TimerManager;
+// HTTP 连接当前所处的阶段，决定适用哪一种超时
+enum class ConnPhase {
+    Idle,       // keep-alive 空闲：没有未处理完的请求字节，也没有待发送的响应
+    Header,     // 新连接或已收到请求的首字节，请求行与请求头尚未收完
+    Body,       // 请求头已收完，正在接收请求体
+    Write,      // 响应未能一次发完，等待套接字可写
+    Busy,       // handler 在工作线程池中执行，不计超时
+    Count
+};
+
+// 各阶段的超时设置（毫秒），防御慢速客户端（slowloris）长期占用连接
+struct ConnTimeouts {
+    int header_ms = 10000;      // 请求头必须在进入 Header 阶段后的该时间内收完，期间收到数据不延期
+    int body_ms = 10000;        // 请求体的基础时限
+    int body_min_rate = 1024;   // 请求体最低速率（字节/秒）：每收到这么多字节时限延长 1 秒；0 表示每次收到数据重新计时
+    int idle_ms = 3000;         // keep-alive 空闲时限
+    int write_ms = 10000;       // 发送响应时连续没有进展的时限
+};
 
 // 客户端信息结构体
 struct client_data {
     sockaddr_in address; // 客户端地址
     int sockfd;          // 套接字
-    util_timer* timer;   // 对应的定时器
-    bool timer_deleted;  // 标记定时器是否已被删除
+    util_timer timer;    // 对应的定时器（侵入式节点，是否在时间轮上见 timer.active()）
+    ConnPhase phase;     // 定时器按哪个阶段的超时设置
+    uint64_t phase_start;  // 进入该阶段（Write 阶段为最近一次有进展）的时刻（毫秒）
+    uint64_t phase_bytes;  // 进入该阶段时连接累计读取（Write 阶段为发送）的字节数
+    uint64_t phase_request; // 进入该阶段时连接已处理完的请求数（一次读取可能跨过多个请求）
     
-    client_data() : sockfd(-1), timer(nullptr), timer_deleted(false) {}
+    client_data() : sockfd(-1), phase(ConnPhase::Idle), phase_start(0), phase_bytes(0), phase_request(0) {}
 };
 
 class Tools {
@@ -70,6 +91,14 @@ public:
      */
     static void addsig(int sig, void(handler)(int), bool restart = true);
 
+    /**
+     * @brief 为 SO_REUSEPORT 监听组附加 CBPF 程序，按当前 CPU 编号选择组内套接字
+     * @param listenfd 组内任意一个监听套接字（程序作用于整个组）
+     * @param group_size 组内监听套接字数量
+     * @return 成功返回 true，内核不支持时返回 false（退化为内核默认的四元组哈希分发）
+     */
+    static bool attach_reuseport_cbpf(int listenfd, int group_size);
+
     // 根据给定路径递归创建父目录
     static void create_parent_dirs(const char *path);
 
@@ -91,23 +120,23 @@ public:
      * @param cd 指向要初始化的 client_data
      * @param sockfd 客户端文件描述符
      * @param client_addr 客户端地址
-     * @param timeout_sec 超时秒数
+     * @param timeout_ms 超时毫秒数
      * @param callback 超时回调函数
      */
-    static void init_timer(TimerManager &tm, client_data *cd, int sockfd, const sockaddr_in &client_addr, int timeout_sec, std::function<void(client_data *)> callback);
+    static void init_timer(TimerManager &tm, client_data *cd, int sockfd, const sockaddr_in &client_addr, int timeout_ms, std::function<void(client_data *)> callback);
 
     /**
-     * @brief 调整（延长）一个现有定时器的超时时间
+     * @brief 设置定时器的到期时刻（推后或提前），定时器不在时间轮上时重新加入
      * @param tm 定时器管理器
-     * @param cd 指向关联的客户端数据 (cd->timer 必须有效)
-     * @param timeout_sec 新的超时秒数
+     * @param cd 指向关联的客户端数据
+     * @param deadline 到期时刻（毫秒，TimerManager::now_ms 的时钟）
      */
-    static void adjust_timer(TimerManager &tm, client_data *cd, int timeout_sec);
+    static void adjust_timer(TimerManager &tm, client_data *cd, uint64_t deadline);
 
     /**
      * @brief 从管理器中删除一个定时器（用于非超时的主动关闭）
      * @param tm 定时器管理器
-     * @param cd 指向关联的客户端数据 (cd->timer 必须有效)
+     * @param cd 指向关联的客户端数据（cd->timer 不在时间轮上时不做任何事）
      */
     static void del_timer(TimerManager &tm, client_data *cd);
 
@@ -122,6 +151,19 @@ public:
 
     static std::string parse_cookie(const std::string& cookie, const std::string& key);
 
+    // 格式化 HTTP 日期（IMF-fixdate，例如 "Sun, 06 Nov 1994 08:49:37 GMT"）
+    static std::string http_date(time_t t);
+
+    // 解析 HTTP 日期（IMF-fixdate / RFC 850 / asctime 三种格式），失败返回 false
+    static bool parse_http_date(std::string_view s, time_t& t);
+
+    /**
+     * @brief 判断 If-None-Match 这类实体标签列表是否匹配 etag（弱比较：忽略 W/ 前缀）
+     * @param list 请求头的值，例如 `"a", W/"b"` 或 `*`
+     * @param etag 带引号的实体标签
+     */
+    static bool etag_list_matches(std::string_view list, std::string_view etag);
+
     static int *u_pipefd;   // 管道，用于信号通知,保存socket两端的两个文件描述符fd
 };
 
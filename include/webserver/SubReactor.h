@@ -7,12 +7,14 @@
 #include <atomic>
 #include <memory>
 #include <functional>
-#include <queue>          // for std::queue
 #include <sys/eventfd.h>  // for eventfd
+#include <sys/timerfd.h>  // for timerfd
 #include <unistd.h> // for pipe, close
 #include <netinet/in.h> // for sockaddr_in
 
 #include "../thread_pool/ThreadPool.h"
+#include "../thread_pool/MpscQueue.h"
+#include "../thread_pool/Task.h"
 #include "../http/HttpConnection.h"
 #include "../http/HttpConnectionPool.h"
 #include "../log/Log.h"
@@ -22,8 +24,10 @@
 #include "../tools/Tools.h" // 包含 Tools
 #include "../websocket/WebSocketServer.h" // 新增：包含 WebSocketServer
 #include "../websocket/WebSocketConn.h"   // 新增：包含 WebSocketConn
+#include "../metrics/Metrics.h"
 
 const int SUB_MAX_EVENT_NUMBER = 10000;
+const int SUB_TASK_NODE_NUMBER = 4096; // 每个 Reactor 任务收件箱预分配的节点数
 
 class SubReactor
 {
@@ -37,11 +41,12 @@ public:
      * @param connPool 共享的数据库连接池
      * @param router 共享的路由
      * @param context 共享的请求上下文
-     * @param timeout_sec 超时时间
+     * @param timeouts 连接各阶段的超时设置
      * @param stop_flag 共享的服务器停止标志
+     * @param id 本 Reactor 的编号，用作指标的 reactor 标签
      */
     void init(ThreadPool *pool, SqlConnectionPool *connPool, Router *router, 
-              RequestContext *context, int timeout_sec, std::atomic<bool> *stop_flag);
+              RequestContext *context, const ConnTimeouts &timeouts, std::atomic<bool> *stop_flag, int id);
 
     /**
      * @brief 从 Reactor 的事件循环，在单独的线程中运行
@@ -54,8 +59,29 @@ public:
      */
     int getPipeFd() const;
 
-    // 用于工作线程向此 Reactor 提交任务
-    void addTask(std::function<void()> task);
+    /**
+     * @brief SO_REUSEPORT 模式下创建本 Reactor 独占的监听套接字，并加入自己的 epoll；
+     *        必须在 eventLoop 线程启动之前调用
+     * @param port 监听端口（同组所有 Reactor 绑定同一端口，由内核分发连接）
+     * @return 成功返回 true
+     */
+    bool listenReusePort(int port);
+
+    /**
+     * @brief 获取本 Reactor 的监听套接字（未启用 SO_REUSEPORT 时为 -1）
+     */
+    int getListenFd() const;
+
+    // 用于工作线程向此 Reactor 提交任务（无锁，任意线程可调用）
+    void addTask(Task task);
+
+    // 因 phase 阶段超时而关闭的连接数（任意线程可读）
+    uint64_t getTimeoutCloses(ConnPhase phase) const;
+
+    int getId() const { return m_id; }
+
+    // 每轮事件处理耗时（epoll_wait 返回到本批事件处理完，纳秒），本线程写、抓取时读
+    const Histogram &getLoopHistogram() const { return m_loop_hist; }
 
 private:
     /**
@@ -64,18 +90,66 @@ private:
     void handle_action(int connfd, Action action);
 
     /**
-     * @brief 处理主 Reactor 分配的新连接
+     * @brief 处理新连接（来自主 Reactor 分配或本 Reactor 自行 accept）
      * @param connfd 新的连接套接字
+     * @param client_addr 客户端地址
      */
-    void handle_new_connection(int connfd);
+    void handle_new_connection(int connfd, const sockaddr_in &client_addr);
+
+    /**
+     * @brief SO_REUSEPORT 模式下在本线程内直接 accept4 新连接
+     */
+    void handle_accept();
 
     /**
      * @brief 处理工作线程提交的唤醒事件
      */
     void handle_wakeup();
 
+    /**
+     * @brief timerfd 到期：推进时间轮，执行到期定时器的回调，再按下一个到期时刻重新设置
+     */
+    void handle_timer();
+
+    /**
+     * @brief 把 timerfd 设置为时间轮下一次需要推进的时刻（没有定时器时停止）
+     */
+    void rearm_timer();
+
+    /**
+     * @brief 按 HTTP 连接当前所处的阶段设置其定时器：
+     *        Header 从进入阶段起计时且不因收到数据延期；Body 按最低速率随已收字节延期；
+     *        Write 在有发送进展时重新计时；Idle 从空闲开始计时；Busy 期间不计时
+     * @param action 本次处理的结果，Close/Upgrade 由 handle_action 删除定时器
+     */
+    void update_timeout(int sockfd, HttpConnection *conn, Action action);
+
+    /**
+     * @brief 定时器到期：按连接所处的阶段计数并关闭连接
+     */
+    void handle_timeout(client_data *cd);
+
+    /**
+     * @brief 在本 Reactor 线程内读取并解析 HTTP 请求（run-to-completion），
+     *        只有 ExecPolicy::Pool 的路由才派发到工作线程池
+     */
+    void handle_http_read(int sockfd, const std::shared_ptr<ManagedConnection> &conn);
+
+    /**
+     * @brief 根据 HttpConnection 返回的动作继续处理：Process 派发到工作线程池，
+     *        Write 直接尝试发送，其余交给 handle_action
+     */
+    void handle_http_action(int sockfd, const std::shared_ptr<ManagedConnection> &conn, Action action);
+
+    /**
+     * @brief 在本 Reactor 线程内发送 HTTP 响应，并根据结果注册下一步事件
+     */
+    void handle_http_write(int sockfd, const std::shared_ptr<ManagedConnection> &conn);
+
+    int m_id;
     int m_epollfd;
     int m_pipefd[2]; // 用于与主 Reactor 通信 [0]=读, [1]=写
+    int m_listenfd;  // SO_REUSEPORT 模式下本 Reactor 独占的监听套接字
     epoll_event events[SUB_MAX_EVENT_NUMBER];
 
     // 本 Reactor 负责的连接
@@ -87,7 +161,11 @@ private:
     // 定时器相关
     TimerManager m_timer_manager;
     std::vector<client_data> m_client_data;
-    int m_timeout_sec;
+    ConnTimeouts m_timeouts;
+    std::atomic<uint64_t> m_timeout_closes[(size_t)ConnPhase::Count];
+    int m_timerfd;            // 驱动本 Reactor 时间轮的 timerfd（CLOCK_MONOTONIC，绝对时间）
+    uint64_t m_timer_armed;   // timerfd 当前设置的到期时刻（毫秒），UINT64_MAX 表示未设置
+    Histogram m_loop_hist;
 
     // 共享资源（来自 WebServer）
     ThreadPool *m_pool;
@@ -98,8 +176,8 @@ private:
 
     // 用于本Reactor的线程间通信的成员
     int m_wakeup_fd;                     // 用于唤醒 epoll_wait 的 eventfd
-    std::queue<std::function<void()>> m_task_queue; // 任务队列
-    std::mutex m_task_mutex;             // 保护任务队列的互斥锁
+    MpscQueue<Task> m_task_queue; // 无锁任务收件箱（多生产者，本线程消费）
+    std::atomic<bool> m_wakeup_pending;  // 已写 eventfd 且尚未被消费，用于合并唤醒
 };
 
 #endif // SUB_REACTOR_H
\ No newline at end of file
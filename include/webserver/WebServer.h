@@ -28,6 +28,7 @@
 #include "../sql/SqlConnectionPool.h"
 #include "../handler/Handler.h"
 #include "SubReactor.h"                 // 包含从 Reactor
+#include "../metrics/Metrics.h"
 
 const int MAX_FD = 65536;           // 最大文件描述符
 const int MAX_EVENT_NUMBER = 10000; // 最大事件数
@@ -47,10 +48,14 @@ public:
      * @param sql_num 数据库连接池大小
      * @param thread_num 工作线程池线程数
      * @param close_log 日志开关
-     * @param timeout_sec 连接超时时间（秒）
+     * @param reuse_port 连接接收模式（0=主 Reactor accept，1=SO_REUSEPORT 多 acceptor，2=再附加 CBPF）
+     * @param file_cache_mb 静态文件缓存容量（MB），0 表示关闭
+     * @param timeouts 连接各阶段的超时设置（请求头、请求体、keep-alive 空闲、发送）
+     * @param admin_trace /admin/trace 的开放范围（0=不注册，1=仅本机，2=任意地址）
      */
     void init(int port, string databaseURL, string user, string passWord, string databaseName,
-              int sql_num,int thread_num, int close_log, int timeout_sec = 3);
+              int sql_num,int thread_num, int close_log, int reuse_port = 0, int file_cache_mb = 64,
+              const ConnTimeouts &timeouts = ConnTimeouts(), int admin_trace = 1);
     /**
      * @brief 开始监听事件
      */
@@ -60,6 +65,16 @@ public:
      */
     void eventLoop();
 
+private:
+    // 主/从模式下创建主 Reactor 的监听套接字
+    void eventListenMain();
+    // 启动各从 Reactor 的事件循环线程（监听套接字就绪之后调用）
+    void startSubReactors();
+    // 创建信号管道并注册信号处理函数，创建驱动 Date 响应头的时钟 timerfd
+    void eventListenSignal();
+    // 导出 SubReactor、线程池、连接池等组件自身持有的指标
+    void collect_metrics(MetricsWriter &w);
+
 public:
     // 基础配置
     int m_port;
@@ -69,16 +84,19 @@ public:
     int m_listenfd;
     epoll_event events[MAX_EVENT_NUMBER];
     int m_pipefd[2];  // 主 Reactor 的信号管道
+    int m_clockfd;    // 每个整秒触发一次的 timerfd（CLOCK_REALTIME），用于更新 Date 响应头
     std::atomic<bool> stop_server;
     Router m_router;
     RequestContext m_context;
-    int m_timeout_sec; // 超时时间（秒）
+    StaticFileCache m_file_cache; // 静态文件缓存（所有 SubReactor 共享）
+    ConnTimeouts m_timeouts; // 连接各阶段的超时设置
 
     // 从 Reactor 相关
     int m_sub_reactor_num; // 从 Reactor 的数量
     std::vector<SubReactor*> m_sub_reactors; // 从 Reactor 实例
     std::vector<std::thread> m_sub_threads; // 从 Reactor 运行的线程
     int m_round_robin_counter; // 用于轮询分发连接
+    int m_reuse_port; // 非 0 时每个从 Reactor 持有自己的 SO_REUSEPORT 监听套接字，主 Reactor 只处理信号
 
     // 数据库相关 (共享资源)
     SqlConnectionPool *m_connPool;
@@ -92,5 +110,7 @@ public:
     ThreadPool *m_pool;
     int m_thread_num; // 工作线程池的线程数
 
+    size_t m_metrics_collector; // Metrics::add_collector 返回的编号，(size_t)-1 表示未注册
+
 };
 #endif // WEBSERVER_H
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "../http/Router.h"
 
 class WebSocketServer;
+struct WebSocketConnBench;
 
 // 在发来的首条消息认证sessionid
 class WebSocketConn : public std::enable_shared_from_this<WebSocketConn> {
@@ -28,6 +29,10 @@ public:
     // 一般返回 Action::Close,除非没写完
     Action handle_write();
 
+    // 工作线程池过载时由 Reactor 线程调用：尽力发送状态码 1013（Try Again Later）的关闭帧，
+    // 连接随后关闭，返回 Action::Close
+    Action reject_overloaded();
+
     // 将文本消息放入发送队列（线程安全）
     void send_text(const std::string& text);
 
@@ -41,6 +46,8 @@ public:
     void set_on_message_callback(std::function<void(int fd, const std::string& msg)> cb);
 
 private:
+    friend struct WebSocketConnBench; // micro_bench 直接测量帧的解析与打包
+
     int fd_;
     WebSocketServer* server_;
     std::string username_;
@@ -1,6 +1,7 @@
 #pragma once
 #include "../tools/Tools.h" // 包含 Action
 #include "../http/Router.h"
+#include "../thread_pool/Task.h"
 #include <nlohmann/json.hpp>
 #include <unordered_map>
 #include <unordered_set>
@@ -17,8 +18,8 @@ class WebSocketConn; // 前向声明
 
 class WebSocketServer {
 public:
-    // 事件注册回调
-    using ActionCallback = std::function<void(int fd, Action)>;
+    // 事件注册回调（只可移动，闭包内联存储）
+    using ActionCallback = InlineFunction<void(int fd, Action)>;
 
     // 获取单例实例（永不析构）
     static WebSocketServer& getInstance();
@@ -1,5 +1,6 @@
 #include "webserver/WebServer.h"
 #include "config/Config.h"
+#include "http/BufferPool.h"
 
 #include <openssl/sha.h>
 #include <iostream>
@@ -19,10 +20,31 @@ int main(int argc, char *argv[])
     Config config;
     config.parse_arg(argc, argv);
 
+    // 连接各阶段的超时设置
+    ConnTimeouts timeouts;
+    timeouts.header_ms = config.header_timeout_ms;
+    timeouts.body_ms = config.body_timeout_ms;
+    timeouts.body_min_rate = config.body_min_rate;
+    timeouts.idle_ms = config.idle_timeout_ms;
+    timeouts.write_ms = config.write_timeout_ms;
+
+    // 日志级别与缓冲区写满时的处理方式
+    Log::get_instance()->set_level(config.log_level);
+    Log::get_instance()->set_full_policy(config.log_block ? LogFullPolicy::Block : LogFullPolicy::Drop);
+
+    // 请求追踪采样率（/admin/trace）
+    Trace::get_instance().set_sample_rate(config.trace_sample > 0 ? (uint32_t)config.trace_sample : 0);
+
+    // 连接缓冲区 arena 使用透明大页（内核未开启 THP 时保持普通页）
+    if (config.buffer_hugepages && !BufferPool::get_instance().set_hugepages(true)) {
+        std::cout << "BufferPool: 透明大页不可用，使用普通页" << std::endl;
+    }
+
     // 创建服务器对象并初始化
     WebServer server;
     server.init(config.PORT, databaseURL, user, passwd, databasename,
-                 config.sql_num, config.thread_num, config.close_log); // 初始化服务器
+                 config.sql_num, config.thread_num, config.close_log, config.reuse_port, config.file_cache_mb,
+                 timeouts, config.admin_trace); // 初始化服务器
     server.eventListen(); // 监听事件
     server.eventLoop(); // 事件循环
     return 0;
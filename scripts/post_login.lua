@@ -1,3 +1,4 @@
+-- wrk -s scripts/post_login.lua：handle_login 解析的是表单，而不是 JSON
 wrk.method = "POST"
-wrk.body   = '{"username":"alice","password":"123456"}'
-wrk.headers["Content-Type"] = "application/json"
+wrk.body   = "username=alice&password=123456"
+wrk.headers["Content-Type"] = "application/x-www-form-urlencoded"
@@ -14,12 +14,40 @@ Config::Config(){
 
     //关闭日志,默认不关闭
     close_log = 0;
+
+    //连接接收模式,默认由主 Reactor 统一 accept
+    reuse_port = 0;
+
+    //静态文件缓存,默认64MB
+    file_cache_mb = 64;
+
+    //超时,默认请求头 10s、请求体 10s 且不低于 1KB/s、keep-alive 空闲 3s、发送无进展 10s
+    header_timeout_ms = 10000;
+    body_timeout_ms = 10000;
+    body_min_rate = 1024;
+    idle_timeout_ms = 3000;
+    write_timeout_ms = 10000;
+
+    //日志缓冲区写满时默认丢弃
+    log_block = 0;
+
+    //运行期日志级别,默认不过滤（编译期级别见 CMake 的 LOG_MIN_LEVEL）
+    log_level = 0;
+
+    //请求追踪,默认关闭
+    trace_sample = 0;
+
+    //BufferPool 默认使用普通页
+    buffer_hugepages = 0;
+
+    //管理接口默认只对本机开放
+    admin_trace = 1;
 }
 
 void Config::parse_arg(int argc, char*argv[])
 {
     int opt;
-    const char *str = "p:s:t:c:";
+    const char *str = "p:s:t:c:r:f:H:B:R:k:W:b:L:T:g:A:";
     // getopt 会根据 str = "p:l:m:o:s:t:c:a:" 来匹配参数。
     // 含 : 的选项表示必须跟一个值比如 -p 8080，opt = 'p'，optarg = "8080"
     while ((opt = getopt(argc, argv, str)) != -1)
@@ -46,6 +74,66 @@ void Config::parse_arg(int argc, char*argv[])
             close_log = atoi(optarg);
             break;
         }
+        case 'r':
+        {
+            reuse_port = atoi(optarg);
+            break;
+        }
+        case 'f':
+        {
+            file_cache_mb = atoi(optarg);
+            break;
+        }
+        case 'H':
+        {
+            header_timeout_ms = atoi(optarg);
+            break;
+        }
+        case 'B':
+        {
+            body_timeout_ms = atoi(optarg);
+            break;
+        }
+        case 'R':
+        {
+            body_min_rate = atoi(optarg);
+            break;
+        }
+        case 'k':
+        {
+            idle_timeout_ms = atoi(optarg);
+            break;
+        }
+        case 'W':
+        {
+            write_timeout_ms = atoi(optarg);
+            break;
+        }
+        case 'b':
+        {
+            log_block = atoi(optarg);
+            break;
+        }
+        case 'L':
+        {
+            log_level = atoi(optarg);
+            break;
+        }
+        case 'T':
+        {
+            trace_sample = atoi(optarg);
+            break;
+        }
+        case 'g':
+        {
+            buffer_hugepages = atoi(optarg);
+            break;
+        }
+        case 'A':
+        {
+            admin_trace = atoi(optarg);
+            break;
+        }
         default:
             break;
         }
@@ -2,20 +2,347 @@
 #include "tools/Tools.h"
 #include "log/Log.h"
 #include "sql/SqlConnectionPool.h"
+#include "http/Compression.h"
+#include "metrics/Metrics.h"
+#include "metrics/Trace.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 #include <sstream>
 #include <mysql/mysql.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <charconv>
+#include <strings.h>
+
+// 按文件类型决定浏览器缓存时间
+static const char* cache_control_for(const std::string& mime_type) {
+    if (mime_type.find("image/") == 0 || mime_type.find("font/") == 0 || 
+        mime_type == "text/css" || mime_type == "application/javascript") {
+        // 静态资源可以缓存较长时间
+        return "public, max-age=3600"; // 1小时
+    }
+    // 其他文件缓存时间较短
+    return "public, max-age=300"; // 5分钟
+}
+
+// 条件请求：客户端缓存的副本仍然有效时返回 true
+// If-None-Match 优先，存在时忽略 If-Modified-Since（RFC 7232 第 6 节）
+// 每次命中缓存都要查这两个头，名字的哈希在编译期算好
+static bool is_not_modified(const HttpRequest& req, std::string_view etag, time_t mtime) {
+    static constexpr uint32_t IF_NONE_MATCH = HttpHeaders::hash_name("If-None-Match");
+    static constexpr uint32_t IF_MODIFIED_SINCE = HttpHeaders::hash_name("If-Modified-Since");
+    if (auto if_none_match = req.headers.get("If-None-Match", IF_NONE_MATCH)) {
+        return Tools::etag_list_matches(*if_none_match, etag);
+    }
+    if (auto if_modified_since = req.headers.get("If-Modified-Since", IF_MODIFIED_SINCE)) {
+        time_t since;
+        return Tools::parse_http_date(*if_modified_since, since) && mtime <= since;
+    }
+    return false;
+}
+
+// Range 请求的处理结果
+enum class RangeResult {
+    Full,           // 没有 Range、If-Range 不匹配或 Range 无法识别：发送完整响应
+    Partial,        // 206，ranges 中是规范化后的区间
+    Unsatisfiable   // 416，没有一个区间落在文件内
+};
+
+// 单个请求最多接受的区间数，超过时忽略 Range 发送完整响应（防止用大量小区间放大开销）
+static const size_t HTTP_MAX_RANGES = 16;
+
+static bool parse_uint(std::string_view s, uint64_t& value) {
+    if (s.empty()) return false;
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && ptr == s.data() + s.size();
+}
+
+// 解析 Range / If-Range（RFC 7233），size 为完整响应体的长度
+static RangeResult evaluate_range(const HttpRequest& req, std::string_view etag, time_t mtime,
+                                  uint64_t size, std::vector<ByteRange>& ranges) {
+    static constexpr uint32_t RANGE = HttpHeaders::hash_name("Range");
+    static constexpr uint32_t IF_RANGE = HttpHeaders::hash_name("If-Range");
+    auto range = req.headers.get("Range", RANGE);
+    if (!range || req.method != HttpMethod::GET) {
+        return RangeResult::Full;
+    }
+
+    // If-Range：校验器与当前文件一致才按区间发送，否则发送完整的新版本
+    if (auto if_range = req.headers.get("If-Range", IF_RANGE)) {
+        if (!if_range->empty() && (if_range->front() == '"' || if_range->substr(0, 2) == "W/")) {
+            if (*if_range != etag) return RangeResult::Full; // 强比较，弱校验器永不匹配
+        } else {
+            time_t date;
+            if (!Tools::parse_http_date(*if_range, date) || date != mtime) return RangeResult::Full;
+        }
+    }
+
+    std::string_view spec = *range;
+    if (spec.size() < 6 || strncasecmp(spec.data(), "bytes=", 6) != 0) {
+        return RangeResult::Full;
+    }
+    spec.remove_prefix(6);
+
+    ranges.clear();
+    size_t count = 0;
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view item = spec.substr(0, comma);
+        spec.remove_prefix(comma == std::string_view::npos ? spec.size() : comma + 1);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (item.empty()) continue;
+        if (++count > HTTP_MAX_RANGES) return RangeResult::Full;
+
+        size_t dash = item.find('-');
+        if (dash == std::string_view::npos) return RangeResult::Full;
+        std::string_view first_str = item.substr(0, dash);
+        std::string_view last_str = item.substr(dash + 1);
+        uint64_t first, last;
+        if (first_str.empty()) {
+            // 后缀区间 "-N"：最后 N 个字节
+            if (!parse_uint(last_str, last)) return RangeResult::Full;
+            if (last == 0 || size == 0) continue;
+            ranges.push_back(ByteRange{size > last ? size - last : 0, size - 1});
+            continue;
+        }
+        if (!parse_uint(first_str, first)) return RangeResult::Full;
+        if (last_str.empty()) {
+            last = UINT64_MAX;
+        } else if (!parse_uint(last_str, last) || last < first) {
+            return RangeResult::Full;
+        }
+        if (first >= size) continue; // 不可满足的区间
+        ranges.push_back(ByteRange{first, std::min(last, size - 1)});
+    }
+
+    if (count == 0) return RangeResult::Full;
+    return ranges.empty() ? RangeResult::Unsatisfiable : RangeResult::Partial;
+}
+
+// 根据 Range 处理结果设置 206/416 响应的状态与头部，返回 false 表示发送完整响应
+static bool apply_range(const HttpRequest& req, std::string_view etag, time_t mtime, uint64_t size,
+                        const std::string& mime_type, HttpResponse& response) {
+    switch (evaluate_range(req, etag, mtime, size, response.ranges)) {
+        case RangeResult::Partial:
+            response.with_status(206, "Partial Content");
+            response.set_header("Content-Type", mime_type);
+            return true;
+        case RangeResult::Unsatisfiable:
+            response.ranges.clear();
+            response.with_status(416, "Range Not Satisfiable");
+            response.set_header("Content-Range", "bytes */" + std::to_string(size));
+            return true;
+        default:
+            response.ranges.clear();
+            return false;
+    }
+}
+
+// 静态文件是否按 Accept-Encoding 协商：类型可压缩且足够大，这类响应一律带 Vary: Accept-Encoding
+static bool negotiable(const std::string& mime_type, uint64_t size) {
+    return size >= HTTP_COMPRESS_MIN_SIZE && Compression::compressible(mime_type);
+}
+
+// 304/206 也要带上的响应头：缓存策略、Vary 与校验器
+static std::string validator_block(const std::string& mime_type, bool vary, const std::string& etag,
+                                   const std::string& last_modified) {
+    std::string block = std::string("Cache-Control: ") + cache_control_for(mime_type) + "\r\n";
+    if (vary) {
+        block += "Vary: Accept-Encoding\r\n";
+    }
+    block += "ETag: " + etag + "\r\n" + "Last-Modified: " + last_modified + "\r\n";
+    return block;
+}
+
+// 压缩版本的 ETag：在结尾引号前加上编码名，强校验值与具体的字节序列一一对应
+static std::string variant_etag(const std::string& etag, ContentCoding coding) {
+    return etag.substr(0, etag.size() - 1) + "-" + Compression::name(coding) + "\"";
+}
+
+// 打开预压缩的兄弟文件（如 app.js.gz），须是常规文件且不早于原文件（否则内容可能已过时），失败返回 -1
+static int open_precompressed(const std::string& path, ContentCoding coding, time_t mtime, struct stat& st) {
+    std::string sibling = path + Compression::suffix(coding);
+    int fd = open(sibling.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd == -1) {
+        return -1;
+    }
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_mtime < mtime) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 读取整个文件
+static bool read_whole_file(int fd, size_t size, std::string& content) {
+    content.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, &content[done], size - done, done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+// 生成压缩版本：优先读取预压缩文件，否则在线压缩；
+// 无法生成或压缩没有收益时返回 encoding 为空的条目，放入缓存后同一版本的文件不再重复尝试
+static std::shared_ptr<const StaticFile> load_variant(const StaticFile& file, ContentCoding coding, int level) {
+    auto variant = std::make_shared<StaticFile>();
+    variant->path = file.path;
+    variant->mime_type = file.mime_type;
+    variant->mtime = file.mtime;
+    variant->last_modified = file.last_modified;
+
+    struct stat st;
+    int fd = open_precompressed(file.path, coding, file.mtime, st);
+    if (fd != -1) {
+        if ((size_t)st.st_size < file.content.size() && read_whole_file(fd, st.st_size, variant->content)) {
+            variant->path += Compression::suffix(coding); // 预压缩文件被修改时由 inotify 使其失效
+            variant->etag = variant_etag(StaticFileCache::make_etag(st.st_ino, st.st_mtime, st.st_size), coding);
+        } else {
+            variant->content.clear();
+        }
+        close(fd);
+    }
+    if (variant->etag.empty()) {
+        if (!Compression::available(coding) ||
+            !Compression::compress(coding, file.content, level, variant->content) ||
+            variant->content.size() >= file.content.size()) {
+            variant->content.clear();
+            return variant;
+        }
+        variant->etag = variant_etag(file.etag, coding);
+    }
+
+    variant->encoding = Compression::name(coding);
+    variant->not_modified_block = validator_block(variant->mime_type, true, variant->etag, variant->last_modified);
+    variant->header_block = "Content-Type: " + variant->mime_type + "\r\n" +
+                            "Content-Encoding: " + variant->encoding + "\r\n" +
+                            "Content-Length: " + std::to_string(variant->content.size()) + "\r\n" +
+                            variant->not_modified_block;
+    return variant;
+}
+
+// 按 Accept-Encoding 选择压缩版本，没有可用的版本时返回 nullptr（发送原始内容）
+// 启用缓存时每个版本只生成一次；Range 请求总是针对原始内容
+static std::shared_ptr<const StaticFile> select_variant(const HttpRequest& req, const StaticFile& file,
+                                                        StaticFileCache* cache) {
+    static constexpr uint32_t ACCEPT_ENCODING = HttpHeaders::hash_name("Accept-Encoding");
+    static constexpr uint32_t RANGE = HttpHeaders::hash_name("Range");
+    auto accept_encoding = req.headers.get("Accept-Encoding", ACCEPT_ENCODING);
+    if (!accept_encoding || req.headers.get("Range", RANGE)) {
+        return nullptr;
+    }
+    ContentCoding codings[HTTP_COMPRESS_MAX_CODINGS];
+    size_t count = Compression::negotiate(*accept_encoding, codings);
+
+    static thread_local std::string key;
+    for (size_t i = 0; i < count; ++i) {
+        ContentCoding coding = codings[i];
+        std::shared_ptr<const StaticFile> variant;
+        if (cache && cache->enabled()) {
+            StaticFileCache::variant_key(file, Compression::name(coding), key);
+            variant = cache->lookup_variant(key);
+            if (!variant) {
+                uint64_t generation = cache->generation();
+                variant = load_variant(file, coding, Compression::static_level(coding));
+                cache->insert_variant(key, variant, generation);
+            }
+        } else {
+            // 没有缓存时每次都要压缩，按动态响应的级别控制开销
+            variant = load_variant(file, coding, Compression::dynamic_level(coding, file.content.size()));
+        }
+        if (!variant->encoding.empty()) {
+            return variant;
+        }
+    }
+    return nullptr;
+}
+
+// 大文件不在线压缩：客户端接受时改为 sendfile 预压缩文件，没有可用的预压缩文件时返回 false
+static bool select_precompressed(const HttpRequest& req, const std::string& path, const std::string& mime_type,
+                                 time_t mtime, HttpResponse& response) {
+    static constexpr uint32_t ACCEPT_ENCODING = HttpHeaders::hash_name("Accept-Encoding");
+    static constexpr uint32_t RANGE = HttpHeaders::hash_name("Range");
+    auto accept_encoding = req.headers.get("Accept-Encoding", ACCEPT_ENCODING);
+    if (!accept_encoding || req.headers.get("Range", RANGE)) {
+        return false;
+    }
+    ContentCoding codings[HTTP_COMPRESS_MAX_CODINGS];
+    size_t count = Compression::negotiate(*accept_encoding, codings);
+    for (size_t i = 0; i < count; ++i) {
+        struct stat st;
+        int fd = open_precompressed(path, codings[i], mtime, st);
+        if (fd == -1) {
+            continue;
+        }
+        close(fd);
+        std::string etag = variant_etag(StaticFileCache::make_etag(st.st_ino, st.st_mtime, st.st_size), codings[i]);
+        response.set_header("ETag", etag);
+        if (is_not_modified(req, etag, mtime)) {
+            response.with_status(304, "Not Modified");
+            return true;
+        }
+        // Content-Length 由 HttpConnection 按打开后的文件大小补充
+        response.set_header("Content-Type", mime_type);
+        response.set_header("Content-Encoding", Compression::name(codings[i]));
+        response.file_path = path + Compression::suffix(codings[i]);
+        return true;
+    }
+    return false;
+}
+
+// 由静态文件条目生成响应：响应头与响应体都直接引用条目内存，发送时只需一次 writev；
+// 客户端接受压缩时换成压缩版本；条件请求命中时返回只有响应头的 304，Range 请求返回 206/416
+static HttpResponse make_static_response(const HttpRequest& req, std::shared_ptr<const StaticFile> file,
+                                         StaticFileCache* cache) {
+    if (file->negotiable) {
+        if (auto variant = select_variant(req, *file, cache)) {
+            file = std::move(variant);
+        }
+    }
+    HttpResponse response;
+    if (is_not_modified(req, file->etag, file->mtime)) {
+        response.with_status(304, "Not Modified");
+        response.raw_headers = file->not_modified_block;
+    } else if (apply_range(req, file->etag, file->mtime, file->content.size(), file->mime_type, response)) {
+        // 206 带上校验器与缓存策略；416 没有 raw_headers，由发送端补 Content-Length: 0
+        if (!response.ranges.empty()) {
+            response.raw_headers = file->not_modified_block;
+            response.shared_body = file->content;
+        }
+    } else {
+        response.raw_headers = file->header_block;
+        response.shared_body = file->content;
+    }
+    response.pin = std::move(file);
+    return response;
+}
 
 /**
  * @brief 处理静态文件请求的handler
  * 支持pdf、jpg、png、css、js、html等常用文件格式
+ * 小文件连同预先序列化的响应头一起放入 StaticFileCache，命中时不访问文件系统；
+ * 文件查找与缓存键只用 req.path，查询串（如 /app.js?v=3 中的 v=3）不影响结果
  */
 HttpResponse handle_static_file(const HttpRequest& req, RequestContext& ctx) {
-    LOG_DEBUG("--- Handler: handle_static_file called for path: %s ---", req.path.c_str());
-    
-    std::string request_path = req.path;
+    StaticFileCache* cache = ctx.file_cache;
+    if (cache) {
+        if (auto file = cache->lookup(req.path)) {
+            return make_static_response(req, std::move(file), cache);
+        }
+    }
+    // 在访问文件之前记录失效代数，期间文件若被修改则不插入缓存
+    uint64_t generation = cache ? cache->generation() : 0;
+
+    std::string request_path(req.path);
+    LOG_DEBUG("--- Handler: handle_static_file called for path: %s ---", request_path.c_str());
+
     
     // 特殊处理：根目录重定向到index.html
     if (request_path == "/" || request_path.empty()) {
@@ -41,12 +368,13 @@ HttpResponse handle_static_file(const HttpRequest& req, RequestContext& ctx) {
     std::string canonical_file_path;
     
     try {
-        canonical_doc_root = std::filesystem::canonical(ctx.doc_root);
+        canonical_doc_root = (cache && !cache->doc_root().empty()) ? cache->doc_root()
+                                                                   : std::filesystem::canonical(ctx.doc_root).string();
         canonical_file_path = std::filesystem::canonical(file_path);
         
         // 检查请求的文件是否在文档根目录下
-        if (canonical_file_path.substr(0, canonical_doc_root.length()) != canonical_doc_root) {
-            LOG_WARN("[SECURITY] Path traversal attempt detected: %s", req.path.c_str());
+        if (canonical_file_path.compare(0, canonical_doc_root.length(), canonical_doc_root) != 0) {
+            LOG_WARN("[SECURITY] Path traversal attempt detected: %s", request_path.c_str());
             return HttpResponse::make_error(403); // Forbidden
         }
     } catch (const std::filesystem::filesystem_error& e) {
@@ -55,62 +383,85 @@ HttpResponse handle_static_file(const HttpRequest& req, RequestContext& ctx) {
         return HttpResponse::make_error(404);
     }
     
-    // 检查文件是否存在且是常规文件
-    if (!std::filesystem::exists(canonical_file_path) || 
-        !std::filesystem::is_regular_file(canonical_file_path)) {
-        LOG_ERROR("[ERROR] File not found or not a regular file: %s", canonical_file_path.c_str());
-        return HttpResponse::make_error(404);
-    }
-    
-    // 检查文件权限（可读）
-    std::ifstream file(canonical_file_path, std::ios::binary);
-    if (!file.is_open()) {
+    // 打开文件（同时检查权限）
+    int fd = open(canonical_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
         LOG_ERROR("[ERROR] Cannot open file: %s", canonical_file_path.c_str());
-        return HttpResponse::make_error(403); // Forbidden
+        return HttpResponse::make_error(errno == EACCES ? 403 : 404);
     }
     
-    // 获取文件大小
-    std::error_code ec;
-    auto file_size = std::filesystem::file_size(canonical_file_path, ec);
-    if (ec) {
-        LOG_ERROR("[ERROR] Cannot get file size: %s", ec.message().c_str());
-        return HttpResponse::make_error(500);
+    // 检查是否为常规文件并获取大小
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode)) {
+        LOG_ERROR("[ERROR] File not found or not a regular file: %s", canonical_file_path.c_str());
+        close(fd);
+        return HttpResponse::make_error(404);
     }
+    size_t file_size = file_stat.st_size;
     
     // 获取MIME类型
     std::string mime_type = Tools::get_mime_type(canonical_file_path);
     
-    // 创建响应
-    HttpResponse response;
-    response.status_code = 200;
-    response.status_text = "OK";
-    response.set_header("Content-Type", mime_type);
-    response.set_header("Content-Length", std::to_string(file_size));
+    std::string etag = StaticFileCache::make_etag(file_stat.st_ino, file_stat.st_mtime, file_size);
     
-    // 添加缓存控制头
-    if (mime_type.find("image/") == 0 || mime_type.find("font/") == 0 || 
-        mime_type == "text/css" || mime_type == "application/javascript") {
-        // 静态资源可以缓存较长时间
-        response.set_header("Cache-Control", "public, max-age=3600"); // 1小时
-    } else {
-        // 其他文件缓存时间较短
-        response.set_header("Cache-Control", "public, max-age=300"); // 5分钟
-    }
-    
-    // 对于较小的文件（小于1MB），直接读取到内存
-    if (file_size < 1024 * 1024) {
-        std::string content((std::istreambuf_iterator<char>(file)),
-                           std::istreambuf_iterator<char>());
-        response.body = std::move(content);
-        LOG_DEBUG("[SUCCESS] Small file loaded to memory: %llu bytes", (unsigned long long)file_size);
-    } else {
+    if (file_size >= STATIC_CACHE_MAX_FILE) {
         // 对于大文件，使用文件路径，让HttpConnection使用sendfile发送
+        close(fd);
+        HttpResponse response;
+        response.set_header("Cache-Control", cache_control_for(mime_type));
+        response.set_header("Last-Modified", Tools::http_date(file_stat.st_mtime));
+        if (negotiable(mime_type, file_size)) {
+            response.set_header("Vary", "Accept-Encoding");
+            if (select_precompressed(req, canonical_file_path, mime_type, file_stat.st_mtime, response)) {
+                return response;
+            }
+        }
+        response.set_header("ETag", etag);
+        if (is_not_modified(req, etag, file_stat.st_mtime)) {
+            response.with_status(304, "Not Modified");
+            return response;
+        }
+        // Range 请求：各区间按自己的偏移 sendfile
+        if (apply_range(req, etag, file_stat.st_mtime, file_size, mime_type, response)) {
+            if (!response.ranges.empty()) {
+                response.file_path = canonical_file_path;
+            }
+            return response;
+        }
+        response.set_header("Accept-Ranges", "bytes");
+        response.set_header("Content-Type", mime_type);
+        response.set_header("Content-Length", std::to_string(file_size));
         response.file_path = canonical_file_path;
         LOG_DEBUG("[SUCCESS] Large file will be sent via sendfile: %llu bytes", (unsigned long long)file_size);
+        return response;
     }
     
-    file.close();
-    return response;
+    // 对于较小的文件（小于1MB），读取到内存并预先序列化响应头
+    auto file = std::make_shared<StaticFile>();
+    if (!read_whole_file(fd, file_size, file->content)) {
+        LOG_ERROR("[ERROR] Cannot read file: %s", canonical_file_path.c_str());
+        close(fd);
+        return HttpResponse::make_error(500);
+    }
+    close(fd);
+    
+    file->path = std::move(canonical_file_path);
+    file->mime_type = std::move(mime_type);
+    file->mtime = file_stat.st_mtime;
+    file->etag = std::move(etag);
+    file->last_modified = Tools::http_date(file_stat.st_mtime);
+    file->negotiable = negotiable(file->mime_type, file_size);
+    file->not_modified_block = validator_block(file->mime_type, file->negotiable, file->etag, file->last_modified);
+    file->header_block = "Content-Type: " + file->mime_type + "\r\n" +
+                         "Content-Length: " + std::to_string(file_size) + "\r\n" +
+                         "Accept-Ranges: bytes\r\n" +
+                         file->not_modified_block;
+    LOG_DEBUG("[SUCCESS] Small file loaded to memory: %llu bytes", (unsigned long long)file_size);
+    
+    if (cache) {
+        cache->insert(req.path, file, generation);
+    }
+    return make_static_response(req, std::move(file), cache);
 }
 
 /**
@@ -389,6 +740,60 @@ HttpResponse handle_simple_json_get(const HttpRequest& req, RequestContext& ctx)
         .with_body(json_response);
 }
 
+/**
+ * @brief 以 Prometheus 文本格式导出运行时指标（各线程的分片在此时才求和）
+ */
+HttpResponse handle_metrics(const HttpRequest& req, RequestContext& ctx) {
+    return HttpResponse()
+        .with_status(200, "OK")
+        .with_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+        .with_header("Cache-Control", "no-store")
+        .with_body(Metrics::get_instance().render());
+}
+
+// 查询串中参数 name 的值（不做 URL 解码），不存在时返回空
+static std::string_view query_param(std::string_view query, std::string_view name) {
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        if (pair.size() > name.size() && pair.compare(0, name.size(), name) == 0 && pair[name.size()] == '=') {
+            return pair.substr(name.size() + 1);
+        }
+        if (amp == std::string_view::npos) {
+            break;
+        }
+        query.remove_prefix(amp + 1);
+    }
+    return {};
+}
+
+/**
+ * @brief 导出采样请求的阶段耗时（见 metrics/Trace.h）
+ */
+HttpResponse handle_trace(const HttpRequest& req, RequestContext& ctx) {
+    if (!ctx.admin_remote && !req.from_loopback()) {
+        return HttpResponse::make_error(403);
+    }
+
+    size_t limit = 0;
+    std::string_view limit_arg = query_param(req.query, "limit");
+    std::from_chars(limit_arg.data(), limit_arg.data() + limit_arg.size(), limit);
+
+    Trace& trace = Trace::get_instance();
+    if (query_param(req.query, "format") == "chrome") {
+        return HttpResponse()
+            .with_status(200, "OK")
+            .with_header("Content-Type", "application/json")
+            .with_header("Cache-Control", "no-store")
+            .with_body(trace.render_chrome(limit ? limit : TRACE_RING_SIZE));
+    }
+    return HttpResponse()
+        .with_status(200, "OK")
+        .with_header("Content-Type", "text/plain; charset=utf-8")
+        .with_header("Cache-Control", "no-store")
+        .with_body(trace.render_text(limit ? limit : 50));
+}
+
 /**
  * @brief 处理WebSocket升级请求的handler
  */
@@ -399,21 +804,22 @@ HttpResponse handle_websocket_upgrade(const HttpRequest& req, RequestContext& ct
     }
 
     // 检查请求头
-    std::unordered_map<std::string, std::string> headers = req.headers;
-    if (headers.find("Upgrade") == headers.end() || strcasecmp(headers["Upgrade"].c_str(), "websocket") != 0)
+    auto upgrade = req.get_header("Upgrade");
+    if (!upgrade || strcasecmp(std::string(*upgrade).c_str(), "websocket") != 0)
     {
         return HttpResponse().with_status(400, "Bad Request");
     }
-    if (headers.find("Sec-WebSocket-Key") == headers.end()) {
+    auto key = req.get_header("Sec-WebSocket-Key");
+    if (!key) {
         return HttpResponse().with_status(400, "Bad Request");
     }
-    if (headers.find("Sec-WebSocket-Version") == headers.end() ||
-        headers["Sec-WebSocket-Version"] != "13") {
+    auto version = req.get_header("Sec-WebSocket-Version");
+    if (!version || *version != "13") {
         return HttpResponse().with_status(400, "Unsupported WebSocket Version");
     }
 
     // 生成Sec-WebSocket-Accept
-    std::string accept_key = headers["Sec-WebSocket-Key"];
+    std::string accept_key(*key);
     std::string accept_value = Tools::generate_accept_value(accept_key);
 
     // 构造101 Switching Protocols响应
@@ -423,3 +829,28 @@ HttpResponse handle_websocket_upgrade(const HttpRequest& req, RequestContext& ct
         .with_header("Connection", "Upgrade")
         .with_header("Sec-WebSocket-Accept", accept_value);
 }
+
+void register_routes(Router& router, bool admin_trace) {
+    // API 路由（默认在 SubReactor 线程内执行，访问 MySQL 的 handler 交给工作线程池）
+    router.add_route(HttpMethod::GET, "/api/test", handle_simple_json_get);
+    router.add_route(HttpMethod::POST, "/api/register", handle_register, ExecPolicy::Pool);
+    router.add_route(HttpMethod::POST, "/api/auth/login", handle_login, ExecPolicy::Pool);
+    router.add_route(HttpMethod::GET, "/api/auth/validate_session", handle_validate_session);
+    router.add_route(HttpMethod::GET, "/api/auth/logout", handle_logout);
+    router.add_route(HttpMethod::GET, "/api/upgrade", handle_websocket_upgrade);
+    router.add_route(HttpMethod::GET, "/metrics", handle_metrics);
+    // 管理接口：渲染要遍历整个追踪环形缓冲区，交给工作线程池；默认只对本机开放
+    if (admin_trace) {
+        router.add_route(HttpMethod::GET, "/admin/trace", handle_trace, ExecPolicy::Pool);
+    }
+    // 静态文件路由 - 基数树末尾通配段按扩展名匹配
+    router.add_route(HttpMethod::GET, "/*path.{html,htm,css,js,json,txt,xml,csv}", handle_static_file);
+    router.add_route(HttpMethod::GET, "/*path.{jpg,jpeg,png,gif,bmp,webp,svg,ico}", handle_static_file);
+    router.add_route(HttpMethod::GET, "/*path.{pdf,doc,docx,xls,xlsx,ppt,pptx}", handle_static_file);
+    router.add_route(HttpMethod::GET, "/*path.{mp3,wav,mp4,avi}", handle_static_file);
+    router.add_route(HttpMethod::GET, "/*path.{zip,tar,gz,rar}", handle_static_file);
+    router.add_route(HttpMethod::GET, "/*path.{ttf,woff,woff2}", handle_static_file);
+    // 特殊处理：根目录和无扩展名的文件（如/index, /favicon等）
+    router.add_route(HttpMethod::GET, "/", handle_static_file);  // 根目录重定向到index.html
+    router.add_route(HttpMethod::GET, "/*path.{}", handle_static_file);  // 无扩展名文件
+}
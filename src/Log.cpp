@@ -1,10 +1,13 @@
 #include "log/Log.h"
-#include <ctime>
-#include <cstdarg>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <iostream>
 #include <cstring>
-#include <sys/time.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
 
 // ---------------- 内部小工具：构建日志全路径 ----------------
 static std::string make_log_fullname(const std::string& dir,
@@ -34,85 +37,182 @@ static std::string make_log_fullname(const std::string& dir,
     return full;
 }
 
-// ---------------- 封装：日志更新切割 ----------------
-void Log::switch_log(const tm& my_tm)
-{
-    bool new_day = (m_today != my_tm.tm_mday);
-    if (new_day || (m_split_lines > 0 && (m_count % m_split_lines) == 0)) {
-        fflush(m_fp);
-        fclose(m_fp);
+// ---------------- 内部小工具：格式化一行日志 ----------------
+namespace {
+    // 每个线程缓存当前秒的 "YYYY-MM-DD HH:MM:SS"，同一秒内的日志不再调用 localtime
+    struct TimeCache {
+        time_t sec = -1;
+        tm my_tm{};
+        char text[32];
+        size_t length = 0;
+    };
+    thread_local TimeCache t_time;
+
+    // 每个线程格式化日志用的缓冲区（按 log_buf_size 分配一次），以及同步模式下组装记录的临时区
+    thread_local std::vector<char> t_line;
+    thread_local std::vector<char> t_scratch;
 
-        if (new_day) {
-            m_today = my_tm.tm_mday;
-            m_count = 0; // 跨天重置计数
+    // 线程退出时把自己的环形缓冲区交给写线程回收
+    struct RingHandle {
+        LogRing* ring = nullptr;
+        bool above_half = false;   // 已用超过一半并唤醒过写线程
+        ~RingHandle() {
+            if (ring) {
+                ring->orphaned.store(true, std::memory_order_release);
+            }
         }
+    };
+    thread_local RingHandle t_ring;
 
-        std::string full = make_log_fullname(m_dir_name, m_log_name, my_tm,
-                                             m_count, m_split_lines, new_day);
-        m_fp = fopen(full.c_str(), "a");
-        if (!m_fp) {
-            m_fp = stderr;
+    const TimeCache& time_cache(time_t sec) {
+        if (sec != t_time.sec) {
+            t_time.sec = sec;
+            localtime_r(&t_time.sec, &t_time.my_tm);
+            const tm& my_tm = t_time.my_tm;
+            int n = snprintf(t_time.text, sizeof(t_time.text), "%d-%02d-%02d %02d:%02d:%02d",
+                             my_tm.tm_year + 1900, my_tm.tm_mon + 1, my_tm.tm_mday,
+                             my_tm.tm_hour, my_tm.tm_min, my_tm.tm_sec);
+            t_time.length = n > 0 ? (size_t)n : 0;
         }
+        return t_time;
     }
-}
 
-// ---------------- 封装：写入单条日志 ----------------
-void Log::write_single_log(const std::string& msg)
-{
-    time_t t = time(nullptr);
-    tm* sys_tm = localtime(&t);
-    tm  my_tm  = *sys_tm;
+    const tm& current_tm() {
+        return time_cache(time(nullptr)).my_tm;
+    }
 
-    ++m_count;
-    switch_log(my_tm);
+    // "YYYY-MM-DD HH:MM:SS.uuuuuu [level]: "，返回长度
+    size_t format_prefix(char* buf, const timespec& ts, int level) {
+        static const char* const levels[] = {"[debug]:", "[info]:", "[warn]:", "[error]:"};
+        const char* s = (level >= 0 && level <= 3) ? levels[level] : "[info]:";
 
-    fputs(msg.c_str(), m_fp);
+        const TimeCache& now = time_cache(ts.tv_sec);
+        size_t n = now.length;
+        memcpy(buf, now.text, n);
+        buf[n++] = '.';
+        long usec = ts.tv_nsec / 1000;
+        for (int i = 5; i >= 0; --i, usec /= 10) {
+            buf[n + i] = (char)('0' + usec % 10);
+        }
+        n += 6;
+        buf[n++] = ' ';
+        size_t level_len = strlen(s);
+        memcpy(buf + n, s, level_len);
+        n += level_len;
+        buf[n++] = ' ';
+        return n;
+    }
 
-    // 计数到 flush_interval 才刷新一次
-    if (++m_unflushed >= m_flush_interval) 
-    {
-        fflush(m_fp);
-        m_unflushed = 0;
+    // 消息部分写了 m 字节（snprintf 的返回值）后补上换行，超长的消息被截断，返回行长度
+    size_t finish_line(char* buf, size_t size, size_t n, int m) {
+        if (m > 0) {
+            n += std::min((size_t)m, size - n - 2);
+        }
+        buf[n++] = '\n';
+        return n;
+    }
+
+    size_t format_line(char* buf, size_t size, int level, const char* format, va_list ap) {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        size_t n = format_prefix(buf, now, level);
+        int m = vsnprintf(buf + n, size - n - 1, format, ap);
+        return finish_line(buf, size, n, m);
+    }
+
+    // 格式化一条延迟记录
+    size_t format_record(char* buf, size_t size, const LogRecord* record) {
+        const char* p = reinterpret_cast<const char*>(record + 1);
+        LogDeferred head;
+        memcpy(&head, p, sizeof(head));
+        size_t n = format_prefix(buf, head.time, record->level);
+        int m = head.format(buf + n, size - n - 1, head.fmt, p + sizeof(head));
+        return finish_line(buf, size, n, m);
+    }
+
+    size_t format_notice(char* buf, size_t size, int level, const char* format, ...) {
+        va_list ap;
+        va_start(ap, format);
+        size_t n = format_line(buf, size, level, format, ap);
+        va_end(ap);
+        return n;
+    }
+
+    // writev 全部写完（处理部分写入与超过 IOV_MAX 的情况）
+    void write_all(int fd, iovec* iov, size_t count) {
+        while (count > 0) {
+            int batch = (int)std::min<size_t>(count, IOV_MAX);
+            ssize_t written = writev(fd, iov, batch);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return; // 磁盘出错时丢弃本批，日志不能反过来影响服务
+            }
+            while (count > 0 && (size_t)written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (written > 0) {
+                iov->iov_base = (char*)iov->iov_base + written;
+                iov->iov_len -= written;
+            }
+        }
     }
 }
 
+// ---------------- 封装：日志更新切割 ----------------
+void Log::switch_log(const tm& my_tm, long long lines)
+{
+    bool new_day = (m_today != my_tm.tm_mday);
+    long long before = m_count;
+    m_count = new_day ? lines : m_count + lines;
+    if (!new_day && before / m_split_lines == m_count / m_split_lines) {
+        return;
+    }
+    if (new_day) {
+        m_today = my_tm.tm_mday;
+    }
+
+    std::string full = make_log_fullname(m_dir_name, m_log_name, my_tm,
+                                         new_day ? 0 : m_count / m_split_lines * m_split_lines,
+                                         m_split_lines, new_day);
+    int fd = open(full.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fd = STDERR_FILENO;
+    }
+    if (m_fd >= 0 && m_fd != STDERR_FILENO) {
+        close(m_fd);
+    }
+    m_fd = fd;
+}
+
 Log::Log()
     : m_close_log(0), m_split_lines(5000000), m_log_buf_size(8192),
-      m_count(0), m_today(0), m_fp(nullptr),
-      m_log_queue(nullptr), m_exit(false), m_is_async(false) {}
+      m_count(0), m_today(0), m_fd(-1), m_is_async(false), m_ring_size(0),
+      m_record_limit(0), m_policy(LogFullPolicy::Drop), m_dropped(0), m_reported_dropped(0),
+      m_format_used(0), m_batch_lines(0), m_level(0), m_wake(false), m_flush_request(0), m_flush_done(0), m_exit(false) {}
 
 Log::~Log()
 {
-    // 优先唤醒写线程安全退出
-    if (m_is_async && m_log_queue) {
-        m_log_queue->push("LOG_ENDS_NOW");
-    }
+    // 写线程取完所有缓冲区后退出
     m_exit = true;
     if (m_is_async && m_thread.joinable()) {
+        wake();
         m_thread.join();
     }
-    if (m_fp) {
-        fflush(m_fp);
-        fclose(m_fp);
-        m_fp = nullptr;
+    if (m_fd >= 0 && m_fd != STDERR_FILENO) {
+        close(m_fd);
+        m_fd = -1;
     }
-    delete m_log_queue;
-    m_log_queue = nullptr;
 }
 
 bool Log::init(const char* file_name, int close_log,
-               int log_buf_size, int split_lines, int max_queue_size)
+               int log_buf_size, int split_lines, int ring_kb)
 {
     m_close_log    = close_log;
-    m_log_buf_size = log_buf_size;
+    m_log_buf_size = std::max(log_buf_size, 128);
     m_split_lines  = (split_lines > 0 ? split_lines : 5000000);
 
-    if (max_queue_size >= 1) {
-        m_is_async   = true;
-        m_log_queue  = new BlockQueue<std::string>(max_queue_size);
-        m_thread     = std::thread(&Log::thread_func, this);
-    }
-
     // 解析路径与基本名
     const char* p = strrchr(file_name, '/');
     if (!p) {
@@ -125,109 +225,277 @@ bool Log::init(const char* file_name, int close_log,
 
     // 初始打开：YYYY_MM_DD_ + m_log_name
     time_t t = time(nullptr);
-    tm* sys_tm = localtime(&t);
-    tm  my_tm  = *sys_tm;
+    tm my_tm;
+    localtime_r(&t, &my_tm);
     m_today    = my_tm.tm_mday;
 
     std::string full = make_log_fullname(m_dir_name, m_log_name, my_tm,
                                          /*count=*/0, m_split_lines,
                                          /*new_day=*/true);
-    m_fp = fopen(full.c_str(), "a");
-    if (!m_fp) {
+    m_fd = open(full.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
         std::cerr << "Log file open error: " << full << std::endl;
         return false;
     }
+
+    if (ring_kb > 0) {
+        // 单条记录必须能放进缓冲区，超过 m_record_limit 的延迟记录在调用线程格式化
+        m_ring_size    = std::max((size_t)ring_kb * 1024, (size_t)m_log_buf_size * 4);
+        m_record_limit = (size_t)m_log_buf_size * 2;
+        m_format_buf.resize(std::max<size_t>(256 * 1024, (size_t)m_log_buf_size * 4));
+        m_is_async     = true;
+        m_thread    = std::thread(&Log::thread_func, this);
+    }
     return true;
 }
 
-void Log::write_log(int level, const char* format, ...)
+LogRing* Log::local_ring()
 {
-    // 组装一条日志文本（含时间与级别）
-    struct timeval now{};
-    gettimeofday(&now, nullptr);
-    time_t t = time(nullptr);
-    tm* sys_tm = localtime(&t);
-    tm  my_tm  = *sys_tm;
+    if (!t_ring.ring) {
+        auto ring = std::make_unique<LogRing>(m_ring_size);
+        t_ring.ring = ring.get();
+        std::lock_guard<std::mutex> lk(m_rings_mutex);
+        m_rings.push_back(std::move(ring));
+    }
+    return t_ring.ring;
+}
 
-    char s[16] = {0};
-    switch (level) {
-        case 0: strcpy(s, "[debug]:"); break;
-        case 1: strcpy(s, "[info]:");  break;
-        case 2: strcpy(s, "[warn]:");  break;
-        case 3: strcpy(s, "[error]:"); break;
-        default: strcpy(s, "[info]:"); break;
+void Log::wake()
+{
+    {
+        std::lock_guard<std::mutex> lk(m_cond_mutex);
+        m_wake = true;
     }
+    m_cond.notify_one();
+}
 
-    char buf[m_log_buf_size];
-    va_list valst;
-    va_start(valst, format);
-    int n = snprintf(buf, 64, "%d-%02d-%02d %02d:%02d:%02d.%06ld %s ",
-                     my_tm.tm_year + 1900, my_tm.tm_mon + 1, my_tm.tm_mday,
-                     my_tm.tm_hour, my_tm.tm_min, my_tm.tm_sec,
-                     (long)now.tv_usec, s);
-    int m = vsnprintf(buf + n, m_log_buf_size - n - 1, format, valst);
-    va_end(valst);
+LogRecord* Log::reserve_record(size_t len, bool* in_ring)
+{
+    if (m_is_async && sizeof(LogRecord) + len <= m_record_limit) {
+        *in_ring = true;
+        LogRing* ring = local_ring();
+        LogRecord* record = ring->reserve(len);
+        if (record) {
+            return record;
+        }
+        if (m_policy.load(std::memory_order_relaxed) == LogFullPolicy::Drop) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            wake();
+            return nullptr;
+        }
+        // 阻塞：等写线程腾出空间
+        do {
+            wake();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            record = ring->reserve(len);
+        } while (!record && !m_exit.load(std::memory_order_relaxed));
+        return record;
+    }
 
-    buf[n + m]     = '\n';
-    buf[n + m + 1] = '\0';
-    std::string log_str(buf);
+    // 同步模式，或参数过大放不进缓冲区：在调用线程组装后直接格式化
+    *in_ring = false;
+    size_t size = sizeof(LogRecord) + len;
+    if (t_scratch.size() < size) {
+        t_scratch.resize(size);
+    }
+    LogRecord* record = reinterpret_cast<LogRecord*>(t_scratch.data());
+    record->size = (uint32_t)size;
+    record->length = (uint32_t)len;
+    return record;
+}
 
+void Log::commit_record(LogRecord* record, bool in_ring)
+{
+    if (in_ring) {
+        // 已用超过一半时提前唤醒写线程（每次越过一半只唤醒一次）
+        LogRing* ring = t_ring.ring;
+        ring->commit();
+        bool above_half = ring->used() > ring->capacity() / 2;
+        if (above_half && !t_ring.above_half) {
+            wake();
+        }
+        t_ring.above_half = above_half;
+        return;
+    }
+
+    if (record->kind == LogRecord::Text) {
+        write_line(reinterpret_cast<const char*>(record + 1), record->length, current_tm());
+        return;
+    }
+    if (t_line.size() < (size_t)m_log_buf_size) {
+        t_line.resize(m_log_buf_size);
+    }
+    size_t len = format_record(t_line.data(), t_line.size(), record);
     if (m_is_async) {
-        // 异步：只入队，不触碰文件句柄
-        m_log_queue->push(log_str);
-    } else {
-        // 同步：同一把锁内完成切割与写入，保证线程安全
-        std::lock_guard<std::mutex> lk(m_mutex);
+        // 异步模式下的超大记录：格式化后按普通整行入缓冲区
+        bool ring_ok;
+        LogRecord* text = reserve_record(len, &ring_ok);
+        if (text) {
+            text->kind = LogRecord::Text;
+            text->level = record->level;
+            memcpy(text + 1, t_line.data(), len);
+            commit_record(text, ring_ok);
+        }
+        return;
+    }
+    write_line(t_line.data(), len, t_time.my_tm);
+}
 
-        // ——行计数与切割判断——
-        // 先自增再判断，保持与常见实现一致（到 m_split_lines 时生成 ".1"）
-        ++m_count;
-        time_t t = time(nullptr);
-        tm* sys_tm = localtime(&t);
-        tm  my_tm  = *sys_tm;
-        switch_log(my_tm); // 检查是否需要切割日志
+void Log::write_line(const char* line, size_t len, const tm& my_tm)
+{
+    // 同步：同一把锁内完成切割与写入，保证线程安全
+    std::lock_guard<std::mutex> lk(m_mutex);
+    switch_log(my_tm, 1);
+    iovec iov{const_cast<char*>(line), len};
+    write_all(m_fd, &iov, 1);
+}
 
-        fputs(log_str.c_str(), m_fp);
-        fflush(m_fp);
+void Log::write_log(int level, const char* format, ...)
+{
+    if (t_line.size() < (size_t)m_log_buf_size) {
+        t_line.resize(m_log_buf_size);
     }
+    va_list valst;
+    va_start(valst, format);
+    size_t len = format_line(t_line.data(), t_line.size(), level, format, valst);
+    va_end(valst);
+
+    if (!m_is_async) {
+        write_line(t_line.data(), len, t_time.my_tm);
+        return;
+    }
+
+    // 异步：整行追加到本线程的缓冲区
+    bool in_ring;
+    LogRecord* record = reserve_record(len, &in_ring);
+    if (!record) {
+        return;
+    }
+    record->kind = LogRecord::Text;
+    record->level = (uint16_t)level;
+    memcpy(record + 1, t_line.data(), len);
+    commit_record(record, in_ring);
 }
 
-void* Log::async_write_log()
+void Log::write_batch()
 {
-    thread_func();
-    return nullptr;
+    if (m_drain_iov.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        switch_log(current_tm(), m_batch_lines);
+        write_all(m_fd, m_drain_iov.data(), m_drain_iov.size());
+    }
+    m_drain_iov.clear();
+    m_format_used = 0;
+    m_batch_lines = 0;
 }
 
-void Log::thread_func()
+size_t Log::drain()
 {
-    std::string single_log;
-    while (true) {
-        m_log_queue->pop(single_log);
+    // 回收所属线程已退出且已取空的缓冲区，并拿到本轮要处理的缓冲区列表
+    {
+        std::lock_guard<std::mutex> lk(m_rings_mutex);
+        m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(), [](const std::unique_ptr<LogRing>& ring) {
+            return ring->orphaned.load(std::memory_order_acquire) && ring->empty();
+        }), m_rings.end());
+        m_drain_rings.clear();
+        for (auto& ring : m_rings) {
+            m_drain_rings.push_back(ring.get());
+        }
+    }
 
-        if (single_log == "LOG_ENDS_NOW") 
-        {
-            // 消费剩余日志
-            while (!m_log_queue->empty()) {
-                std::string leftover;
-                if (m_log_queue->pop(leftover, 10)) {
-                    std::lock_guard<std::mutex> lk(m_mutex);
-                    write_single_log(leftover);
+    // 整行记录直接引用缓冲区中的数据，延迟记录格式化到 m_format_buf；
+    // m_format_buf 不够时先写出一批，缓冲区在全部写完后才释放
+    m_drain_end.resize(m_drain_rings.size());
+    size_t total = 0;
+    for (size_t i = 0; i < m_drain_rings.size(); ++i) {
+        LogRing* ring = m_drain_rings[i];
+        uint64_t begin = ring->begin();
+        uint64_t end = ring->end();
+        for (uint64_t pos = begin; pos != end; pos += ring->at(pos)->size) {
+            const LogRecord* record = ring->at(pos);
+            if (record->kind == LogRecord::Text) {
+                m_drain_iov.push_back({const_cast<LogRecord*>(record + 1), record->length});
+            } else if (record->kind == LogRecord::Deferred) {
+                if (m_format_buf.size() - m_format_used < (size_t)m_log_buf_size) {
+                    write_batch();
                 }
+                char* out = m_format_buf.data() + m_format_used;
+                size_t n = format_record(out, m_log_buf_size, record);
+                m_format_used += n;
+                m_drain_iov.push_back({out, n});
+            } else {
+                continue;
             }
-            break; // 退出循环
+            ++m_batch_lines;
         }
+        m_drain_end[i] = end;
+        total += end - begin;
+    }
 
-        std::lock_guard<std::mutex> lk(m_mutex);
-        write_single_log(single_log);
+    // 有日志因缓冲区写满被丢弃：在本批末尾记一条
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_reported_dropped) {
+        if (m_format_buf.size() - m_format_used < 256) {
+            write_batch();
+        }
+        char* out = m_format_buf.data() + m_format_used;
+        size_t n = format_notice(out, 256, 2, "Log: %llu records dropped (ring buffer full)",
+                                 (unsigned long long)(dropped - m_reported_dropped));
+        m_reported_dropped = dropped;
+        m_format_used += n;
+        m_drain_iov.push_back({out, n});
+        ++m_batch_lines;
     }
+    write_batch();
 
-    // 确保退出前 flush 一次
-    if (m_fp) fflush(m_fp);
+    for (size_t i = 0; i < m_drain_rings.size(); ++i) {
+        m_drain_rings[i]->consume(m_drain_end[i]);
+    }
+    return total;
 }
 
+void Log::thread_func()
+{
+    while (true) {
+        uint64_t flush_request;
+        {
+            std::lock_guard<std::mutex> lk(m_cond_mutex);
+            flush_request = m_flush_request;
+        }
+        bool exiting = m_exit.load(std::memory_order_acquire);
+
+        size_t written = drain();
+
+        if (flush_request != m_flush_done) {
+            std::lock_guard<std::mutex> lk(m_cond_mutex);
+            m_flush_done = flush_request;
+            m_flushed.notify_all();
+        }
+        if (written > 0) {
+            continue; // 写的过程中可能又有新日志
+        }
+        if (exiting) {
+            break; // 退出前最后一轮已取空
+        }
+
+        std::unique_lock<std::mutex> lk(m_cond_mutex);
+        m_cond.wait_for(lk, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS), [this] {
+            return m_wake || m_flush_request != m_flush_done || m_exit.load(std::memory_order_relaxed);
+        });
+        m_wake = false;
+    }
+}
 
 void Log::flush()
 {
-    std::lock_guard<std::mutex> lk(m_mutex);
-    if (m_fp) fflush(m_fp);
+    if (!m_is_async) {
+        return; // 同步模式下每条日志已直接 write
+    }
+    std::unique_lock<std::mutex> lk(m_cond_mutex);
+    uint64_t target = ++m_flush_request;
+    m_cond.notify_one();
+    m_flushed.wait(lk, [&] { return m_flush_done >= target; });
 }
@@ -1,4 +1,5 @@
 #include "sql/SqlConnectionPool.h"
+#include "metrics/Metrics.h"
 
 SqlConnectionPool *SqlConnectionPool::GetInstance()
 {
@@ -48,9 +49,11 @@ void SqlConnectionPool::init(string url, string User, string PassWord, string DB
 
 MYSQL *SqlConnectionPool::GetConnection()
 {
+    uint64_t wait_start = Metrics::now_ns();
     std::unique_lock<std::mutex> unique_lock(lock);
 
     cv.wait(unique_lock, [this] { return !connList.empty(); });
+    Metrics::local().sql_wait_ns.record(Metrics::now_ns() - wait_start);
 
     MYSQL *con = connList.front();
     connList.pop_front();
@@ -1,40 +1,60 @@
 #include "thread_pool/ThreadPool.h"
+#include "metrics/Metrics.h"
+
+// 当前线程若为某个线程池的工作线程，记录所属线程池与编号
+static thread_local ThreadPool *t_owner_pool = nullptr;
+static thread_local int t_worker_id = -1;
+
+// 提交线程的默认亲和性：每个提交线程第一次提交时分配一个固定序号
+static std::atomic<unsigned> g_submitter_seq{0};
+static thread_local int t_submit_hint = -1;
 
 ThreadPool::ThreadPool(int thread_number, int max_requests, int shutdown_timeout)
     : m_thread_number(thread_number),
       m_max_requests(max_requests),
+      m_slots(max_requests > 0 ? new Task[max_requests] : nullptr),
+      m_enqueued_ns(max_requests > 0 ? new uint64_t[max_requests] : nullptr),
+      m_free_slots(max_requests > 0 ? max_requests : 0),
+      m_queued(0),
       m_stop(false),
       m_shutdown_timeout(shutdown_timeout)
 {
     if (thread_number <= 0 || max_requests <= 0)
         throw std::exception();
 
-    m_threads.reserve(thread_number);
+    // 每个工作线程的收件箱/双端队列容量都按 max_requests 预分配，
+    // 任务槽总数就是上限，因此任何队列都不会溢出
+    m_workers.reserve(thread_number);
+    for (int i = 0; i < thread_number; ++i)
+    {
+        m_workers.emplace_back(new Worker(max_requests));
+    }
     for (int i = 0; i < thread_number; ++i)
     {
-        m_threads.emplace_back(&ThreadPool::run, this);
+        m_workers[i]->thread = std::thread(&ThreadPool::run, this, i);
     }
 }
 
 ThreadPool::~ThreadPool()
 {
     // 通知所有线程退出
+    m_stop.store(true);
+    for (auto &w : m_workers)
     {
-        std::unique_lock<std::mutex> lock(m_queuelocker);
-        m_stop = true;
+        std::lock_guard<std::mutex> lock(w->mtx);
+        w->cv.notify_all(); // 唤醒所有等待的线程
     }
-    m_queuestat.notify_all(); // 唤醒所有等待的线程
 
-    // 等待线程退出（带超时）
-    for (auto &thread : m_threads)
+    // 等待线程退出
+    for (auto &w : m_workers)
     {
-        if (thread.joinable())
+        if (w->thread.joinable())
         {
             // C++标准库中没有直接的超时join，但可以使用detach作为备选方案
             // 这里为了保持简单，直接使用join
             try
             {
-                thread.join();
+                w->thread.join();
             }
             catch (const std::exception &e)
             {
@@ -44,49 +64,175 @@ ThreadPool::~ThreadPool()
     }
 }
 
-bool ThreadPool::append(Task task)
+bool ThreadPool::append(Task task, int hint)
 {
+    if (m_stop.load(std::memory_order_relaxed))
+        return false;
+
+    // 取任务槽：槽位耗尽即过载，交由调用方处理
+    uint32_t slot;
+    if (!m_free_slots.pop(slot))
+        return false;
+
+    m_slots[slot] = std::move(task);
+    m_enqueued_ns[slot] = Metrics::now_ns();
+    m_queued.fetch_add(1, std::memory_order_relaxed);
+
+    // 工作线程自己提交的任务直接压入自己的双端队列，由空闲线程窃取
+    if (t_owner_pool == this && t_worker_id >= 0)
     {
-        std::unique_lock<std::mutex> lock(m_queuelocker);
-        if ((int)m_workqueue.size() >= m_max_requests)
-        {
-            return false;
-        }
-        m_workqueue.push_back(task);
+        m_workers[t_worker_id]->deque.push(slot);
+        wake_thief(t_worker_id);
+        return true;
+    }
+
+    if (hint < 0)
+    {
+        if (t_submit_hint < 0)
+            t_submit_hint = (int)(g_submitter_seq.fetch_add(1, std::memory_order_relaxed) & 0x7fffffff);
+        hint = t_submit_hint;
     }
-    m_queuestat.notify_one();
+    int id = hint % m_thread_number;
+
+    Worker &w = *m_workers[id];
+    // 先计数后入队：计数只会多不会少，工作线程看到计数非零就不会休眠
+    w.inbox_pending.fetch_add(1, std::memory_order_relaxed);
+    w.inbox.push(std::move(slot));
+
+    // 目标线程正在执行任务时（阻塞型任务可能执行很久），叫醒一个空闲线程来接管收件箱，
+    // 否则同一提交线程的任务会在一个线程上串行执行
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (w.sleeping.load(std::memory_order_relaxed) && !w.notified.load(std::memory_order_relaxed))
+        wake(id);
+    else
+        wake_thief(id);
     return true;
 }
 
-void ThreadPool::run()
+void ThreadPool::wake(int id)
 {
-    while (true)
+    Worker &w = *m_workers[id];
+    // 与 run() 中 "置 sleeping 后再检查收件箱" 配对，二者至少有一方能看到对方的写入
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (w.sleeping.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(w.mtx);
+        w.notified.store(true, std::memory_order_relaxed);
+        w.cv.notify_one();
+    }
+}
+
+void ThreadPool::wake_thief(int self)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (int k = 1; k < m_thread_number; ++k)
     {
-        std::unique_lock<std::mutex> lock(m_queuelocker);
+        int id = (self + k) % m_thread_number;
+        // 已被叫醒但尚未被调度的线程仍处于 sleeping 状态，跳过它，叫醒下一个
+        Worker &w = *m_workers[id];
+        if (w.sleeping.load(std::memory_order_relaxed) && !w.notified.load(std::memory_order_relaxed))
+        {
+            wake(id);
+            return;
+        }
+    }
+}
+
+bool ThreadPool::next_task(int id, uint32_t &slot)
+{
+    Worker &w = *m_workers[id];
 
-        // 等待任务或停止信号
-        m_queuestat.wait(lock, [this]
-                         { return m_stop || !m_workqueue.empty(); });
+    // 1. 自己队列中的任务
+    if (w.deque.pop(slot))
+        return true;
 
-        // 如果收到停止信号且队列为空，退出
-        if (m_stop && m_workqueue.empty())
+    // 2. 把收件箱中的任务转入自己的队列
+    if (drain_inbox(id, id) > 0 && w.deque.pop(slot))
+        return true;
+
+    // 3. 从其他工作线程窃取：先窃取其双端队列，再接管其收件箱（它可能正阻塞在一个长任务上）
+    for (int k = 1; k < m_thread_number; ++k)
+    {
+        int victim = (id + k) % m_thread_number;
+        if (m_workers[victim]->deque.steal(slot))
         {
-            break;
+            // 被窃取的队列中还有任务，继续叫醒下一个空闲线程
+            if (m_workers[victim]->deque.size() > 0)
+                wake_thief(id);
+            return true;
         }
+        if (drain_inbox(victim, id) > 0 && w.deque.pop(slot))
+            return true;
+    }
+    return false;
+}
+
+int ThreadPool::drain_inbox(int owner, int id)
+{
+    Worker &src = *m_workers[owner];
+    if (src.inbox_pending.load(std::memory_order_relaxed) == 0)
+        return 0;
+    // 收件箱是单消费者队列，取之前先抢占消费端
+    if (src.inbox_busy.exchange(true, std::memory_order_acquire))
+        return 0;
+
+    Worker &dst = *m_workers[id];
+    int moved = 0;
+    uint32_t s;
+    while (src.inbox.pop(s))
+    {
+        dst.deque.push(s);
+        ++moved;
+    }
+    src.inbox_busy.store(false, std::memory_order_release);
+    src.inbox_pending.fetch_sub(moved, std::memory_order_relaxed);
+
+    // 转入多于一个任务时叫醒一个空闲线程来窃取
+    if (moved > 1)
+        wake_thief(id);
+    return moved;
+}
+
+void ThreadPool::execute(uint32_t slot)
+{
+    Task task = std::move(m_slots[slot]);
+    m_slots[slot] = nullptr;
+    Metrics::local().task_wait_ns.record(Metrics::now_ns() - m_enqueued_ns[slot]);
+    m_free_slots.push(slot);
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+    // 执行任务
+    if (task)
+        task();
+}
+
+void ThreadPool::run(int id)
+{
+    t_owner_pool = this;
+    t_worker_id = id;
+    Worker &w = *m_workers[id];
 
-        // 如果队列为空，继续等待
-        if (m_workqueue.empty())
+    while (true)
+    {
+        uint32_t slot;
+        if (next_task(id, slot))
         {
+            execute(slot);
             continue;
         }
 
-        // 取出任务
-        Task task = m_workqueue.front();
-        m_workqueue.pop_front();
-        lock.unlock();
+        // 收到停止信号且已无任务可做，退出
+        if (m_stop.load())
+            break;
 
-        // 执行任务
-        if (task)
-            task();
+        // 没有任务，休眠等待投递或窃取通知
+        std::unique_lock<std::mutex> lock(w.mtx);
+        w.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        w.cv.wait(lock, [this, &w]
+                  { return m_stop.load() || w.notified.load(std::memory_order_relaxed) ||
+                                           w.inbox_pending.load(std::memory_order_relaxed) > 0; });
+        w.sleeping.store(false, std::memory_order_relaxed);
+        w.notified.store(false, std::memory_order_relaxed);
     }
 }
@@ -1,67 +1,192 @@
 #include "timer/Timer.h"
-#include <unistd.h>
-#include <iostream>
-#include <mutex>
-#include <vector>
-
-void TimerManager::add_timer(util_timer* timer) {
-    std::lock_guard<std::mutex> lock(timer_mutex);
-    auto it = timers.insert({timer->expire, timer});
-    index[timer] = it; // 保存索引
+#include <time.h>
+
+TimerManager::TimerManager() {
+    for (TimerLink& head : m_root) {
+        head.prev = head.next = &head;
+    }
+    for (auto& level : m_levels) {
+        for (TimerLink& head : level) {
+            head.prev = head.next = &head;
+        }
+    }
+    m_current = now_ms();
+}
+
+uint64_t TimerManager::now_ms() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
 }
 
-void TimerManager::adjust_timer(util_timer* timer, time_t new_expire) {
-    std::lock_guard<std::mutex> lock(timer_mutex);
-    auto it = index.find(timer);
-    if (it == index.end()) return; // 不存在该定时器
+void TimerManager::push_back(TimerLink* head, TimerLink* node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
 
-    // 先从 multimap 删除旧位置
-    timers.erase(it->second);
+void TimerManager::unlink(TimerLink* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+}
 
-    // 更新过期时间并重新插入
-    timer->expire = new_expire;
-    auto new_it = timers.insert({timer->expire, timer});
+void TimerManager::link(util_timer* timer) {
+    // 已经过期的放入下一个待处理的槽位，超出最大跨度的放在最高层末端（到达后再按 deadline 重新挂入）
+    uint64_t expire = timer->expire;
+    if (expire < m_current) {
+        expire = m_current;
+    } else if (expire - m_current > TIMER_MAX_SPAN) {
+        expire = m_current + TIMER_MAX_SPAN;
+    }
+    timer->expire = expire;
 
-    // 更新索引
-    it->second = new_it;
+    uint64_t delta = expire - m_current;
+    TimerLink* head;
+    if (delta < TIMER_ROOT_SIZE) {
+        head = &m_root[expire & (TIMER_ROOT_SIZE - 1)];
+    } else {
+        int level = 0;
+        while (level < TIMER_LEVELS - 1 &&
+               delta >= ((uint64_t)1 << (TIMER_ROOT_BITS + TIMER_LEVEL_BITS * (level + 1)))) {
+            ++level;
+        }
+        int shift = TIMER_ROOT_BITS + TIMER_LEVEL_BITS * level;
+        head = &m_levels[level][(expire >> shift) & (TIMER_LEVEL_SIZE - 1)];
+    }
+    push_back(head, timer);
 }
 
-void TimerManager::del_timer(util_timer* timer) {
-    std::lock_guard<std::mutex> lock(timer_mutex);
-    auto it = index.find(timer);
-    if (it == index.end()) return; // 定时器已经被删除
+void TimerManager::cascade(TimerLink* head) {
+    // 先把整个槽位摘下再逐个重新分配，重新分配的定时器只会落到更低的层
+    TimerLink list;
+    if (head->next == head) {
+        return;
+    }
+    list.next = head->next;
+    list.prev = head->prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    head->prev = head->next = head;
+
+    while (list.next != &list) {
+        util_timer* timer = static_cast<util_timer*>(list.next);
+        unlink(timer);
+        link(timer);
+    }
+}
+
+void TimerManager::add_timer(util_timer* timer, uint64_t deadline) {
+    if (timer->active()) {
+        unlink(timer);
+        --m_size;
+    }
+    timer->expire = timer->deadline = deadline;
+    link(timer);
+    ++m_size;
+}
 
-    timers.erase(it->second); // 删除 multimap 节点
-    index.erase(it);          // 删除索引
-    delete timer;
+void TimerManager::adjust_timer(util_timer* timer, uint64_t deadline) {
+    if (!timer->active()) return; // 不在时间轮上（已删除或正在执行回调）
+
+    if (deadline >= timer->expire) {
+        // 延期：节点留在原槽位，到达时再检查 deadline
+        timer->deadline = deadline;
+        return;
+    }
+    unlink(timer);
+    timer->expire = timer->deadline = deadline;
+    link(timer);
+}
+
+void TimerManager::del_timer(util_timer* timer) {
+    if (!timer->active()) return; // 定时器已经被删除
+    unlink(timer);
+    --m_size;
 }
 
 void TimerManager::tick() {
-    std::vector<util_timer*> expired_timers;
-    
-    // 在锁内收集过期的定时器
-    {
-        std::lock_guard<std::mutex> lock(timer_mutex);
-        if (timers.empty()) return;
-
-        time_t cur = time(nullptr);
-        auto it = timers.begin();
-
-        while (it != timers.end() && it->first <= cur) {
-            util_timer* timer = it->second;
-            expired_timers.push_back(timer);
-            
-            // 从索引中删除
-            index.erase(timer);
-            it = timers.erase(it); // 删除并获取下一个迭代器
+    advance(now_ms());
+}
+
+uint64_t TimerManager::next_expire() const {
+    if (m_size == 0) {
+        return UINT64_MAX;
+    }
+    uint64_t next = UINT64_MAX;
+    // 第 0 层：从当前时刻起一圈内的第一个非空槽位
+    for (uint64_t t = m_current; t < m_current + TIMER_ROOT_SIZE; ++t) {
+        const TimerLink& head = m_root[t & (TIMER_ROOT_SIZE - 1)];
+        if (head.next != &head) {
+            next = t;
+            break;
+        }
+    }
+    // 上层：槽位在其下放时刻（低位全为 0 的时刻）被处理，取最早的非空槽位
+    for (int level = 0; level < TIMER_LEVELS; ++level) {
+        int shift = TIMER_ROOT_BITS + TIMER_LEVEL_BITS * level;
+        uint64_t unit = (uint64_t)1 << shift;
+        uint64_t t = (m_current + unit - 1) & ~(unit - 1);
+        for (size_t k = 0; k < TIMER_LEVEL_SIZE && t < next; ++k, t += unit) {
+            const TimerLink& head = m_levels[level][(t >> shift) & (TIMER_LEVEL_SIZE - 1)];
+            if (head.next != &head) {
+                next = t;
+                break;
+            }
         }
     }
-    
-    // 在锁外执行回调函数并删除定时器
-    for (util_timer* timer : expired_timers) {
-        if (timer->cb_func) {
-            timer->cb_func(timer->user_data);
+    return next;
+}
+
+void TimerManager::advance(uint64_t now) {
+    while (m_current <= now) {
+        // 跳过中间的空槽位（跳过的各层下放时刻对应的槽位也都为空）
+        uint64_t next = next_expire();
+        if (next > now) {
+            m_current = now + 1;
+            return;
+        }
+        m_current = next;
+
+        size_t index = m_current & (TIMER_ROOT_SIZE - 1);
+        if (index == 0) {
+            // 第 0 层转完一圈：把上一层当前槽位的定时器分配下来，上一层也转完一圈时继续向上
+            for (int level = 0; level < TIMER_LEVELS; ++level) {
+                int shift = TIMER_ROOT_BITS + TIMER_LEVEL_BITS * level;
+                size_t slot = (m_current >> shift) & (TIMER_LEVEL_SIZE - 1);
+                cascade(&m_levels[level][slot]);
+                if (slot != 0) break;
+            }
+        }
+
+        uint64_t tick = m_current++;
+        TimerLink* head = &m_root[index];
+        if (head->next == head) {
+            continue;
+        }
+
+        // 本槽位整体移到局部链表：回调中删除或调整其它定时器都只是普通的摘链操作
+        TimerLink pending;
+        pending.next = head->next;
+        pending.prev = head->prev;
+        pending.next->prev = &pending;
+        pending.prev->next = &pending;
+        head->prev = head->next = head;
+
+        while (pending.next != &pending) {
+            util_timer* timer = static_cast<util_timer*>(pending.next);
+            unlink(timer);
+            if (timer->deadline > tick) {
+                // 期间有过活动，按新的 deadline 重新挂入
+                timer->expire = timer->deadline;
+                link(timer);
+                continue;
+            }
+            --m_size;
+            if (timer->cb_func) {
+                timer->cb_func(timer->user_data);
+            }
         }
-        delete timer;
     }
 }
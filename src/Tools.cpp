@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <algorithm>
 #include <mutex>
+#include <linux/filter.h>
 
 // 用于保护epoll操作的全局锁
 static std::mutex epoll_mutex;
@@ -78,6 +79,35 @@ void Tools::addsig(int sig, void(handler)(int), bool restart)
     }
 }
 
+bool Tools::attach_reuseport_cbpf(int listenfd, int group_size)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    if (group_size <= 0)
+        return false;
+
+    // A = 当前处理软中断的 CPU 编号；A = A % group_size；返回 A 作为组内套接字下标
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)group_size},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    struct sock_fprog prog;
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+
+    if (setsockopt(listenfd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == -1)
+    {
+        perror("setsockopt SO_ATTACH_REUSEPORT_CBPF");
+        return false;
+    }
+    return true;
+#else
+    (void)listenfd;
+    (void)group_size;
+    return false;
+#endif
+}
+
 void Tools::create_parent_dirs(const char *path)
 {
     std::string spath(path);
@@ -203,36 +233,34 @@ std::string Tools::parse_form_field(const std::string& body, const std::string&
 /**
  * @brief 封装了 webserver.cpp 中新连接到来时的定时器初始化逻辑
  */
-void Tools::init_timer(TimerManager &tm, client_data *cd, int sockfd, const sockaddr_in &client_addr, int timeout_sec, std::function<void(client_data *)> callback)
+void Tools::init_timer(TimerManager &tm, client_data *cd, int sockfd, const sockaddr_in &client_addr, int timeout_ms, std::function<void(client_data *)> callback)
 {
     if (!cd) return;
 
     // 初始化客户端数据
-    cd->address = client_addr; //
-    cd->sockfd = sockfd;       //
-
-    // 创建定时器
-    util_timer *timer = new util_timer;
-    timer->expire = time(nullptr) + timeout_sec; //
-    timer->user_data = cd;                       //
-    timer->cb_func = callback;                   //
-
-    // 关联定时器
-    cd->timer = timer;               //
-    cd->timer_deleted = false;       //
-    tm.add_timer(timer);             //
+    cd->address = client_addr;
+    cd->sockfd = sockfd;
+
+    // 定时器节点嵌在 client_data 中，无需分配
+    cd->timer.user_data = cd;
+    cd->timer.cb_func = std::move(callback);
+    tm.add_timer(&cd->timer, TimerManager::now_ms() + (uint64_t)timeout_ms);
 }
 
 /**
- * @brief 封装了 webserver.cpp 中处理 EPOLLIN/EPOLLOUT 时的定时器调整逻辑
+ * @brief 封装了 SubReactor 按连接所处阶段设置超时时的定时器调整逻辑
  */
-void Tools::adjust_timer(TimerManager &tm, client_data *cd, int timeout_sec)
+void Tools::adjust_timer(TimerManager &tm, client_data *cd, uint64_t deadline)
 {
-    // 检查定时器是否有效且未被标记删除
-    if (cd && cd->timer && !cd->timer_deleted) //
+    if (!cd) return;
+    if (cd->timer.active())
+    {
+        // 推后时只改 deadline，节点不移动（时间轮到达原槽位时再重新挂入）
+        tm.adjust_timer(&cd->timer, deadline);
+    }
+    else
     {
-        time_t new_expire = time(nullptr) + timeout_sec; //
-        tm.adjust_timer(cd->timer, new_expire);          //
+        tm.add_timer(&cd->timer, deadline);
     }
 }
 
@@ -241,12 +269,9 @@ void Tools::adjust_timer(TimerManager &tm, client_data *cd, int timeout_sec)
  */
 void Tools::del_timer(TimerManager &tm, client_data *cd)
 {
-    // 检查定时器是否有效且未被标记删除
-    if (cd && cd->timer && !cd->timer_deleted) //
+    if (cd && cd->timer.active())
     {
-        cd->timer_deleted = true;      //
-        tm.del_timer(cd->timer);       //
-        cd->timer = nullptr;           //
+        tm.del_timer(&cd->timer);
     }
 }
 
@@ -308,4 +333,54 @@ std::string Tools::parse_cookie(const std::string& cookie, const std::string& ke
     return cookie.substr(start, end - start);
 }
 
+std::string Tools::http_date(time_t t)
+{
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    char buf[32];
+    size_t n = strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buf, n);
+}
+
+bool Tools::parse_http_date(std::string_view s, time_t& t)
+{
+    // 依次尝试 IMF-fixdate、RFC 850、asctime
+    static const char* formats[] = {"%a, %d %b %Y %H:%M:%S GMT", "%A, %d-%b-%y %H:%M:%S GMT", "%a %b %d %H:%M:%S %Y"};
+    char buf[64];
+    if (s.size() >= sizeof(buf)) return false;
+    memcpy(buf, s.data(), s.size());
+    buf[s.size()] = '\0';
+    for (const char* format : formats) {
+        struct tm tm = {};
+        const char* end = strptime(buf, format, &tm);
+        if (end && *end == '\0') {
+            t = timegm(&tm);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Tools::etag_list_matches(std::string_view list, std::string_view etag)
+{
+    // 与 etag 比较时不区分强弱
+    if (etag.size() >= 2 && etag[0] == 'W' && etag[1] == '/') etag.remove_prefix(2);
+
+    size_t i = 0;
+    while (i < list.size()) {
+        // 跳过分隔符与空白
+        while (i < list.size() && (list[i] == ' ' || list[i] == '\t' || list[i] == ',')) ++i;
+        if (i >= list.size()) break;
+        if (list[i] == '*') return true;
+        if (list.compare(i, 2, "W/") == 0) i += 2;
+        if (i >= list.size() || list[i] != '"') return false; // 格式错误
+        // 实体标签的内容中不会出现引号，但可以出现逗号
+        size_t close = list.find('"', i + 1);
+        if (close == std::string_view::npos) return false;
+        if (list.substr(i, close + 1 - i) == etag) return true;
+        i = close + 1;
+    }
+    return false;
+}
+
 int *Tools::u_pipefd = nullptr;
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "http/BufferPool.h"
+#include "metrics/Metrics.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+static const size_t HUGEPAGE_SIZE = 2 * 1024 * 1024;
+
+// 线程缓存：每个等级一个当前弹匣与一个备用弹匣（Bonwick 的双弹匣方案），
+// 分配/释放在两个弹匣之间来回时不必访问仓库；计数器单写者，抓取统计时汇总
+struct BufferThreadCache {
+    uint32_t loaded[BUFFER_CLASS_COUNT];
+    uint32_t previous[BUFFER_CLASS_COUNT];
+    MetricCounter allocs[BUFFER_CLASS_COUNT];
+    MetricCounter frees[BUFFER_CLASS_COUNT];
+    MetricCounter depot_gets[BUFFER_CLASS_COUNT];
+    MetricCounter depot_puts[BUFFER_CLASS_COUNT];
+};
+
+namespace {
+
+enum class CacheState : uint8_t { None, Active, Disabled };
+
+thread_local BufferThreadCache* t_cache = nullptr;
+thread_local CacheState t_cache_state = CacheState::None;
+
+// 线程退出时把本线程缓存的弹匣还给仓库
+struct CacheReaper {
+    bool armed = false;
+    ~CacheReaper() {
+        if (armed) {
+            BufferPool::get_instance().flush_thread_cache();
+        }
+    }
+};
+thread_local CacheReaper t_reaper;
+
+} // namespace
+
+BufferPool::BufferPool() {
+    for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+        SizeClass& sc = m_classes[cls];
+        // 多预留一个大页，使 arena 起始地址按 2MB 对齐，启用透明大页时可以整页映射
+        void* p = mmap(nullptr, BUFFER_ARENA_BYTES + HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p != MAP_FAILED) {
+            uintptr_t aligned = ((uintptr_t)p + HUGEPAGE_SIZE - 1) & ~(uintptr_t)(HUGEPAGE_SIZE - 1);
+            sc.base = (char*)aligned;
+            sc.block_count = BUFFER_ARENA_BYTES / BUFFER_CLASS_SIZES[cls];
+        }
+        // 仓库中的满弹匣不超过 块数/弹匣大小；每个线程缓存持有 2 个，退出时最多交回 2 个未满的弹匣
+        size_t magazine_count = sc.block_count / BUFFER_MAGAZINE_SIZE + 4 * BUFFER_MAX_CACHES + 1;
+        sc.magazines.reset(new Magazine[magazine_count]);
+        sc.depot.reset(new IndexStack(magazine_count, false));
+        sc.empty.reset(new IndexStack(magazine_count));
+        sc.spill.count = 0;
+    }
+}
+
+BufferPool::~BufferPool() = default;
+
+void* BufferPool::allocate(size_t size) {
+    int cls = size_class(size);
+    if (cls < 0) {
+        m_oversize_allocs.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    BufferThreadCache* cache = local_cache();
+    if (!cache) {
+        m_classes[cls].slow_allocs.fetch_add(1, std::memory_order_relaxed);
+        return allocate_slow(cls);
+    }
+    cache->allocs[cls].add();
+
+    // 1. 当前弹匣
+    Magazine* m = &magazine(cls, cache->loaded[cls]);
+    if (m->count > 0) {
+        return m->slots[--m->count];
+    }
+    // 2. 备用弹匣有块则交换
+    Magazine* prev = &magazine(cls, cache->previous[cls]);
+    if (prev->count > 0) {
+        std::swap(cache->loaded[cls], cache->previous[cls]);
+        return prev->slots[--prev->count];
+    }
+    // 3. 从仓库取一个弹匣，空的备用弹匣交回
+    SizeClass& sc = m_classes[cls];
+    uint32_t idx;
+    if (sc.depot->pop(idx)) {
+        sc.depot_count.fetch_sub(1, std::memory_order_relaxed);
+        sc.empty->push(cache->previous[cls]);
+        cache->previous[cls] = cache->loaded[cls];
+        cache->loaded[cls] = idx;
+        cache->depot_gets[cls].add();
+        Magazine& full = magazine(cls, idx);
+        return full.slots[--full.count];
+    }
+    // 4. 从 arena 切一个新块
+    return carve(cls);
+}
+
+void BufferPool::deallocate(void* p, size_t size) noexcept {
+    int cls = size_class(size);
+    if (cls < 0) {
+        ::operator delete(p);
+        return;
+    }
+    BufferThreadCache* cache = local_cache();
+    if (cache) {
+        cache->frees[cls].add();
+    } else {
+        m_classes[cls].slow_frees.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!in_arena(cls, p)) {
+        ::operator delete(p);  // arena 用尽时 operator new 得到的块
+        return;
+    }
+    if (!cache) {
+        deallocate_slow(cls, p);
+        return;
+    }
+
+    // 1. 当前弹匣未满
+    Magazine* m = &magazine(cls, cache->loaded[cls]);
+    if (m->count < BUFFER_MAGAZINE_SIZE) {
+        m->slots[m->count++] = p;
+        return;
+    }
+    // 2. 备用弹匣为空则交换
+    Magazine* prev = &magazine(cls, cache->previous[cls]);
+    if (prev->count == 0) {
+        std::swap(cache->loaded[cls], cache->previous[cls]);
+        prev->slots[prev->count++] = p;
+        return;
+    }
+    // 3. 两个弹匣都满：满的备用弹匣交给仓库，换一个空弹匣
+    uint32_t idx;
+    if (take_empty(cls, idx)) {
+        SizeClass& sc = m_classes[cls];
+        sc.depot->push(cache->previous[cls]);
+        sc.depot_count.fetch_add(1, std::memory_order_relaxed);
+        cache->previous[cls] = cache->loaded[cls];
+        cache->loaded[cls] = idx;
+        cache->depot_puts[cls].add();
+        Magazine& empty = magazine(cls, idx);
+        empty.slots[empty.count++] = p;
+        return;
+    }
+    deallocate_slow(cls, p);
+}
+
+BufferThreadCache* BufferPool::local_cache() {
+    if (t_cache_state == CacheState::None) {
+        t_cache_state = CacheState::Disabled;
+        t_cache = create_cache();
+        if (t_cache) {
+            t_cache_state = CacheState::Active;
+            t_reaper.armed = true;
+        }
+    }
+    return t_cache;
+}
+
+BufferThreadCache* BufferPool::create_cache() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_caches.size() >= BUFFER_MAX_CACHES) {
+        return nullptr;
+    }
+    std::unique_ptr<BufferThreadCache> cache(new BufferThreadCache());
+    for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+        if (!take_empty(cls, cache->loaded[cls]) || !take_empty(cls, cache->previous[cls])) {
+            return nullptr;  // 按容量预分配，不会发生
+        }
+    }
+    m_caches.push_back(std::move(cache));
+    return m_caches.back().get();
+}
+
+void BufferPool::flush_thread_cache() {
+    if (t_cache_state != CacheState::Active) {
+        return;
+    }
+    for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+        SizeClass& sc = m_classes[cls];
+        for (uint32_t idx : {t_cache->loaded[cls], t_cache->previous[cls]}) {
+            if (magazine(cls, idx).count > 0) {
+                sc.depot->push(idx);
+                sc.depot_count.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                sc.empty->push(idx);
+            }
+        }
+    }
+    // 缓存对象（计数器）保留在 m_caches 中，统计保持单调；之后本线程走慢路径
+    t_cache = nullptr;
+    t_cache_state = CacheState::Disabled;
+}
+
+bool BufferPool::take_empty(size_t cls, uint32_t& idx) {
+    if (!m_classes[cls].empty->pop(idx)) {
+        return false;
+    }
+    magazine(cls, idx).count = 0;
+    return true;
+}
+
+void* BufferPool::carve(size_t cls) {
+    SizeClass& sc = m_classes[cls];
+    if (sc.base) {
+        size_t i = sc.next_block.fetch_add(1, std::memory_order_relaxed);
+        if (i < sc.block_count) {
+            return sc.base + i * BUFFER_CLASS_SIZES[cls];
+        }
+    }
+    m_fallback_allocs.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(BUFFER_CLASS_SIZES[cls]);
+}
+
+// 没有线程缓存的线程（超出上限或已退出）：通过加锁的 spill 弹匣与仓库交换
+void* BufferPool::allocate_slow(size_t cls) {
+    SizeClass& sc = m_classes[cls];
+    {
+        std::lock_guard<std::mutex> lock(m_spill_mutex);
+        uint32_t idx;
+        if (sc.spill.count == 0 && sc.depot->pop(idx)) {
+            sc.depot_count.fetch_sub(1, std::memory_order_relaxed);
+            Magazine& m = magazine(cls, idx);
+            memcpy(sc.spill.slots, m.slots, m.count * sizeof(void*));
+            sc.spill.count = m.count;
+            m.count = 0;
+            sc.empty->push(idx);
+        }
+        if (sc.spill.count > 0) {
+            return sc.spill.slots[--sc.spill.count];
+        }
+    }
+    return carve(cls);
+}
+
+void BufferPool::deallocate_slow(size_t cls, void* p) {
+    SizeClass& sc = m_classes[cls];
+    std::lock_guard<std::mutex> lock(m_spill_mutex);
+    uint32_t idx;
+    if (sc.spill.count == BUFFER_MAGAZINE_SIZE) {
+        if (!take_empty(cls, idx)) {
+            return;  // 空弹匣按容量预分配，不会发生；真的发生时丢弃这个块
+        }
+        Magazine& m = magazine(cls, idx);
+        memcpy(m.slots, sc.spill.slots, sizeof(sc.spill.slots));
+        m.count = BUFFER_MAGAZINE_SIZE;
+        sc.depot->push(idx);
+        sc.depot_count.fetch_add(1, std::memory_order_relaxed);
+        sc.spill.count = 0;
+    }
+    sc.spill.slots[sc.spill.count++] = p;
+}
+
+bool BufferPool::set_hugepages(bool enable) {
+    bool ok = true;
+    for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+        SizeClass& sc = m_classes[cls];
+        if (sc.base && madvise(sc.base, sc.block_count * BUFFER_CLASS_SIZES[cls],
+                               enable ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) != 0) {
+            ok = false;
+        }
+    }
+    m_hugepages.store(enable && ok, std::memory_order_relaxed);
+    return ok;
+}
+
+BufferPoolStats BufferPool::stats() {
+    BufferPoolStats s;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& cache : m_caches) {
+            for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+                s.classes[cls].allocs += cache->allocs[cls].value();
+                s.classes[cls].frees += cache->frees[cls].value();
+                s.classes[cls].depot_gets += cache->depot_gets[cls].value();
+                s.classes[cls].depot_puts += cache->depot_puts[cls].value();
+            }
+        }
+    }
+    for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+        const SizeClass& sc = m_classes[cls];
+        BufferClassStats& c = s.classes[cls];
+        c.allocs += sc.slow_allocs.load(std::memory_order_relaxed);
+        c.frees += sc.slow_frees.load(std::memory_order_relaxed);
+        c.arena_blocks = std::min(sc.next_block.load(std::memory_order_relaxed), sc.block_count);
+        c.depot_magazines = (uint64_t)std::max<int64_t>(0, sc.depot_count.load(std::memory_order_relaxed));
+    }
+    s.oversize_allocs = m_oversize_allocs.load(std::memory_order_relaxed);
+    s.fallback_allocs = m_fallback_allocs.load(std::memory_order_relaxed);
+    s.hugepages = m_hugepages.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,254 @@
+#include "http/Compression.h"
+#include "log/Log.h"
+#include <cstring>
+#include <zlib.h>
+#ifdef WEBSERVER_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+// ---------------------
+// Accept-Encoding 协商
+// ---------------------
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// 忽略大小写比较，b 为小写字面量（每个静态文件请求都要协商，避免逐字节调用 libc）
+static inline bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != b[i]) return false;
+    }
+    return true;
+}
+
+// 解析参数中的 q 值（RFC 7231 5.3.1），返回千分制，无 q 参数时为 1000，格式错误时为 0
+static int parse_qvalue(std::string_view params) {
+    while (!params.empty()) {
+        size_t semi = params.find(';');
+        std::string_view param = trim(params.substr(0, semi));
+        params.remove_prefix(semi == std::string_view::npos ? params.size() : semi + 1);
+        if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=') {
+            continue;
+        }
+        std::string_view value = param.substr(2);
+        if (value.empty() || (value[0] != '0' && value[0] != '1')) {
+            return 0;
+        }
+        int q = (value[0] - '0') * 1000;
+        if (value.size() > 1) {
+            if (value[1] != '.') return 0;
+            int scale = 100;
+            for (size_t i = 2; i < value.size() && scale > 0; ++i, scale /= 10) {
+                if (value[i] < '0' || value[i] > '9') return 0;
+                q += (value[i] - '0') * scale;
+            }
+        }
+        return q > 1000 ? 1000 : q;
+    }
+    return 1000;
+}
+
+size_t Compression::negotiate(std::string_view accept_encoding, ContentCoding* out) {
+    int gzip_q = -1, br_q = -1, any_q = -1; // -1 表示未出现
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view item = accept_encoding.substr(0, comma);
+        accept_encoding.remove_prefix(comma == std::string_view::npos ? accept_encoding.size() : comma + 1);
+
+        size_t semi = item.find(';');
+        std::string_view coding = trim(item.substr(0, semi));
+        int q = semi == std::string_view::npos ? 1000 : parse_qvalue(item.substr(semi + 1));
+        if (iequals(coding, "gzip") || iequals(coding, "x-gzip")) {
+            gzip_q = q;
+        } else if (iequals(coding, "br")) {
+            br_q = q;
+        } else if (coding == "*") {
+            any_q = q;
+        }
+    }
+    // "*" 适用于没有单独列出的编码
+    if (gzip_q < 0) gzip_q = any_q;
+    if (br_q < 0) br_q = any_q;
+
+    size_t count = 0;
+    if (br_q > 0 && br_q >= gzip_q) {
+        out[count++] = ContentCoding::Brotli;
+        if (gzip_q > 0) out[count++] = ContentCoding::Gzip;
+    } else if (gzip_q > 0) {
+        out[count++] = ContentCoding::Gzip;
+        if (br_q > 0) out[count++] = ContentCoding::Brotli;
+    }
+    return count;
+}
+
+bool Compression::compressible(std::string_view mime_type) {
+    // 去掉 "; charset=..." 之类的参数
+    mime_type = trim(mime_type.substr(0, mime_type.find(';')));
+    if (iequals(mime_type.substr(0, 5), "text/")) {
+        return true;
+    }
+    static const std::string_view types[] = {
+        "application/javascript", "application/json", "application/xml",
+        "application/xhtml+xml", "application/wasm", "image/svg+xml", "image/x-icon",
+    };
+    for (std::string_view type : types) {
+        if (iequals(mime_type, type)) return true;
+    }
+    return false;
+}
+
+bool Compression::available(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::Gzip:
+            return true;
+#ifdef WEBSERVER_HAVE_BROTLI
+        case ContentCoding::Brotli:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* Compression::name(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::Gzip: return "gzip";
+        case ContentCoding::Brotli: return "br";
+        default: return "identity";
+    }
+}
+
+const char* Compression::suffix(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::Gzip: return ".gz";
+        case ContentCoding::Brotli: return ".br";
+        default: return "";
+    }
+}
+
+int Compression::static_level(ContentCoding coding) {
+    // 每个文件只压缩一次，但第一次请求在 Reactor 线程上同步压缩：
+    // gzip 9 比 6 只慢约 1/3；br 6 以上每级耗时成倍增长而体积只小几个百分点
+    return coding == ContentCoding::Brotli ? 5 : 9;
+}
+
+int Compression::dynamic_level(ContentCoding coding, size_t size) {
+    // 每个响应都要压缩：级别随大小递减，使单个响应的压缩耗时大致与 64KB 的 gzip 6 相当
+    if (coding == ContentCoding::Brotli) {
+        if (size <= 64 * 1024) return 4;
+        if (size <= 1024 * 1024) return 2;
+        return 1;
+    }
+    if (size <= 64 * 1024) return 6;
+    if (size <= 1024 * 1024) return 4;
+    return 1;
+}
+
+// ---------------------
+// 压缩实现
+// ---------------------
+static bool gzip_compress(std::string_view input, int level, std::string& out) {
+    z_stream stream{};
+    // windowBits 加 16 输出 gzip 封装（而不是 zlib 封装）
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    out.resize(deflateBound(&stream, input.size()));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = input.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = out.size();
+    int ret = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return ret == Z_STREAM_END;
+}
+
+#ifdef WEBSERVER_HAVE_BROTLI
+static bool brotli_compress(std::string_view input, int quality, std::string& out) {
+    size_t size = BrotliEncoderMaxCompressedSize(input.size());
+    if (size == 0) {
+        return false;
+    }
+    out.resize(size);
+    // 文本内容使用 BROTLI_MODE_TEXT；窗口取默认值 22（4MB）
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, input.size(),
+                               reinterpret_cast<const uint8_t*>(input.data()), &size,
+                               reinterpret_cast<uint8_t*>(&out[0]))) {
+        return false;
+    }
+    out.resize(size);
+    return true;
+}
+#endif
+
+bool Compression::compress(ContentCoding coding, std::string_view input, int level, std::string& out) {
+    switch (coding) {
+        case ContentCoding::Gzip:
+            return gzip_compress(input, level, out);
+#ifdef WEBSERVER_HAVE_BROTLI
+        case ContentCoding::Brotli:
+            return brotli_compress(input, level, out);
+#endif
+        default:
+            return false;
+    }
+}
+
+// ---------------------
+// 动态响应
+// ---------------------
+void Compression::compress_response(const HttpRequest& req, HttpResponse& response) {
+    static constexpr uint32_t ACCEPT_ENCODING = HttpHeaders::hash_name("Accept-Encoding");
+    if (response.status_code != 200 || response.body.size() < HTTP_COMPRESS_MIN_SIZE ||
+        response.body.size() > HTTP_COMPRESS_MAX_DYNAMIC || !response.file_path.empty() ||
+        !response.shared_body.empty() || !response.ranges.empty() || !response.raw_headers.empty() ||
+        response.headers.count("Content-Encoding")) {
+        return;
+    }
+    auto type = response.headers.find("Content-Type");
+    if (type == response.headers.end() || !compressible(type->second)) {
+        return;
+    }
+
+    // 响应内容随 Accept-Encoding 变化，供共享缓存区分
+    auto vary = response.headers.find("Vary");
+    if (vary == response.headers.end()) {
+        response.headers.emplace("Vary", "Accept-Encoding");
+    } else if (strcasestr(vary->second.c_str(), "Accept-Encoding") == nullptr && vary->second != "*") {
+        vary->second += ", Accept-Encoding";
+    }
+
+    auto accept_encoding = req.headers.get("Accept-Encoding", ACCEPT_ENCODING);
+    if (!accept_encoding) {
+        return;
+    }
+    ContentCoding codings[HTTP_COMPRESS_MAX_CODINGS];
+    size_t count = negotiate(*accept_encoding, codings);
+    for (size_t i = 0; i < count; ++i) {
+        ContentCoding coding = codings[i];
+        if (!available(coding)) {
+            continue;
+        }
+        std::string compressed;
+        if (!compress(coding, response.body, dynamic_level(coding, response.body.size()), compressed)) {
+            LOG_WARN("Compression: %s failed for %zu bytes", name(coding), response.body.size());
+            return;
+        }
+        if (compressed.size() >= response.body.size()) {
+            return; // 没有收益，发送原始内容
+        }
+        response.body = std::move(compressed);
+        response.headers["Content-Encoding"] = name(coding);
+        auto length = response.headers.find("Content-Length");
+        if (length != response.headers.end()) {
+            length->second = std::to_string(response.body.size());
+        }
+        return;
+    }
+}
@@ -0,0 +1,61 @@
+#include "http/HttpClock.h"
+#include "tools/Tools.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+alignas(64) std::atomic<uint64_t> HttpClock::s_words[HttpClock::WORDS];
+std::atomic<uint32_t> HttpClock::s_seq{0};
+std::atomic<uint32_t> HttpClock::s_length{0};
+std::atomic<int64_t> HttpClock::s_now{0};
+std::mutex HttpClock::s_writer;
+
+void HttpClock::update() {
+    update(time(nullptr));
+}
+
+void HttpClock::update(time_t now) {
+    std::string prefix = "Date: " + Tools::http_date(now) + "\r\nServer: " HTTP_SERVER_NAME "\r\n";
+    uint64_t words[WORDS] = {};
+    size_t length = std::min(prefix.size(), HTTP_CLOCK_PREFIX_MAX);
+    memcpy(words, prefix.data(), length);
+
+    std::lock_guard<std::mutex> lock(s_writer);
+    uint32_t seq = s_seq.load(std::memory_order_relaxed);
+    // 序号变为奇数：读者看到后会重试
+    s_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; ++i) {
+        s_words[i].store(words[i], std::memory_order_relaxed);
+    }
+    s_length.store((uint32_t)length, std::memory_order_relaxed);
+    s_now.store((int64_t)now, std::memory_order_relaxed);
+    s_seq.store(seq + 2, std::memory_order_release);
+}
+
+size_t HttpClock::copy_prefix(char* dst) {
+    uint64_t words[WORDS];
+    uint32_t length;
+    while (true) {
+        uint32_t seq = s_seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            continue; // 写者正在更新
+        }
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = s_words[i].load(std::memory_order_relaxed);
+        }
+        length = s_length.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s_seq.load(std::memory_order_relaxed) != seq) {
+            continue; // 拷贝期间发生过更新
+        }
+        if (length == 0) {
+            // 服务器启动前（或基准测试中）尚未更新过
+            update();
+            continue;
+        }
+        break;
+    }
+    memcpy(dst, words, length);
+    return length;
+}
@@ -1,13 +1,17 @@
 #include "http/HttpConnection.h"
 #include "http/BufferPool.h"
+#include "http/Compression.h"
+#include "http/HeaderWriter.h"
+#include "http/HttpClock.h"
 #include "log/Log.h"
+#include "metrics/Metrics.h"
 #include <sys/sendfile.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstring>
 #include <sys/stat.h>
 #include <fstream>
-#include <sstream>
+#include <random>
 
 // 构造函数
 HttpConnection::HttpConnection(int sockfd, const sockaddr_in& addr, Router* router, RequestContext* context)
@@ -16,12 +20,11 @@ HttpConnection::HttpConnection(int sockfd, const sockaddr_in& addr, Router* rout
     m_read_buffer = BufferPool::get_instance().acquire(4096);
     m_write_buffer = BufferPool::get_instance().acquire(4096);
     reset();
+    m_accept_ns = Trace::get_instance().enabled() ? Metrics::now_ns() : 0;
 }
 
 HttpConnection::~HttpConnection() {
-    if (m_file_fd != -1) {
-        close(m_file_fd);
-    }
+    clear_output();
     // 将缓冲区返回池中
     BufferPool::get_instance().release(std::move(m_read_buffer));
     BufferPool::get_instance().release(std::move(m_write_buffer));
@@ -31,6 +34,7 @@ HttpConnection::~HttpConnection() {
 Action HttpConnection::handle_read() {
     const size_t READ_CHUNK_SIZE = 4096;
     ssize_t bytes_read = 0;
+    bool fresh = !m_trace_begun && m_read_buffer.empty(); // 本次读到的是一个新请求的开头
     
     while (true) {
         // 确保缓冲区有足够空间
@@ -60,286 +64,525 @@ Action HttpConnection::handle_read() {
         
         // 调整缓冲区大小为实际读取的数据大小
         m_read_buffer.resize(old_size + bytes_read);
+        m_bytes_read += bytes_read;
+        Metrics::local().bytes_in.add(bytes_read);
     }
     
     if (m_read_buffer.empty()) {
         // 没有读取到数据，继续等待
         return Action::Read;
     }
+    if (fresh) {
+        trace_begin();
+    }
     
-    // 解析HTTP请求
-    auto parse_result = m_parser.parse(m_read_buffer);
-    
-    switch (parse_result) {
-        case HttpParser::ParseResult::Complete: {
-            // 请求解析完成，处理请求
-            const HttpRequest& request = m_parser.get_request();
-            // 判断是否是websocket升级
-            m_is_websocket = request.is_websocket_upgrade();
-            // 使用handler构建响应
-            HttpResponse response = m_router->route_request(request, *m_context);
-            
-            // 准备响应
-            prepare_response(response);
-            m_is_writing = true;
-            
-            return Action::Write;
+    return process_buffered();
+}
+
+// 依次处理读缓冲区中所有完整的请求（HTTP/1.1 管线化）
+Action HttpConnection::process_buffered() {
+    size_t queued = 0;
+    while (!m_close_after_write && !m_upgrade_after_write && !m_read_buffer.empty()) {
+        // 本批响应已满：先发送，发送完毕后 handle_write 会回到这里继续
+        if (queued >= HTTP_PIPELINE_DEPTH || m_write_buffer.size() >= HTTP_PIPELINE_BUFFER) {
+            break;
         }
-        case HttpParser::ParseResult::Incomplete:
+        if (!m_trace_begun) {
+            trace_begin(); // 读缓冲区中残留的管线化请求
+        }
+
+        auto parse_result = m_parser.parse(m_read_buffer);
+        if (parse_result == HttpParser::ParseResult::Incomplete) {
             // 需要更多数据
-            return Action::Read;
-        case HttpParser::ParseResult::Error:
-            // 解析错误，发送400错误响应
-            LOG_ERROR("HTTP request parse error");
-            HttpResponse error_response = HttpResponse::make_error(400);
-            prepare_response(error_response);
-            m_is_writing = true;
-            return Action::Write;
+            break;
+        }
+        if (parse_result == HttpParser::ParseResult::Error ||
+            parse_result == HttpParser::ParseResult::TooManyHeaders) {
+            // 解析错误发送 400，请求头过多发送 431；之后的字节已无法定界，发送完即关闭
+            int code = parse_result == HttpParser::ParseResult::TooManyHeaders ? 431 : 400;
+            LOG_ERROR("HTTP request parse error (%d)", code);
+            Metrics::local().parse_errors.add();
+            Metrics::record_request(0, code);
+            trace_end(code);
+            prepare_response(HttpResponse::make_error(code));
+            m_close_after_write = true;
+            ++queued;
+            break;
+        }
+
+        // 请求解析完成，处理请求
+        trace_mark(TracePoint::Parsed);
+        HttpRequest& request = m_parser.get_request();
+        request.remote_addr = m_address.sin_addr.s_addr;
+        // 判断是否是websocket升级
+        m_is_websocket = request.is_websocket_upgrade();
+        // 匹配路由（同时填入路径参数），会阻塞的 handler 交给工作线程池执行；
+        // 此前已排队的响应留在队列中，待该请求完成后按顺序一起发送
+        m_route = m_router->find_route(request);
+        trace_mark(TracePoint::Routed);
+        if (m_route && m_route->policy == ExecPolicy::Pool) {
+            return Action::Process;
+        }
+        process_request();
+        ++queued;
     }
-    
-    return Action::Read;
+
+    return m_out_head < m_out.size() ? Action::Write : Action::Read;
 }
 
-// 向socket写入数据
-Action HttpConnection::handle_write() {
-    if (!m_is_writing) {
-        return Action::Read;
+// 执行路由 handler 并将响应入队
+Action HttpConnection::process_request() {
+    const HttpRequest& request = m_parser.get_request();
+    if (m_trace_sampled) {
+        m_trace.worker_tid = Trace::thread_id();
+        trace_mark(TracePoint::HandlerStart);
     }
-    
-    ssize_t bytes_written = 0;
-    
-    while (m_bytes_to_send > 0) {
-        if (m_file_fd != -1) {
-            // 如果有文件需要发送，先发送响应头，再发送文件
-            if (m_iov[0].iov_len > 0) {
-                // 先发送响应头
-                bytes_written = write(m_sockfd, m_iov[0].iov_base, m_iov[0].iov_len);
+    // 使用handler构建响应
+    HttpResponse response = m_route ? m_route->handler(request, *m_context)
+                                    : HttpResponse::make_error(404);
+    // 动态响应体按 Accept-Encoding 压缩（Pool 路由在工作线程中完成，不占用 Reactor）
+    Compression::compress_response(request, response);
+    trace_mark(TracePoint::HandlerEnd);
+    finish_request(std::move(response));
+    return Action::Write;
+}
+
+// 过载降级：返回 503 并在发送后关闭连接
+Action HttpConnection::reject_overloaded() {
+    Metrics::record_request(m_route ? m_route->metrics_id : 0, 503);
+    trace_end(503);
+    prepare_response(HttpResponse::make_error(503));
+    m_close_after_write = true;
+    return Action::Write;
+}
+
+// 响应入队，并根据请求/响应决定连接的后续状态
+void HttpConnection::finish_request(HttpResponse&& response) {
+    const HttpRequest& request = m_parser.get_request();
+    if (m_is_websocket) {
+        // 握手成功则在 101 响应发送后升级，否则关闭
+        if (response.status_code == 101) {
+            m_upgrade_after_write = true;
+        } else {
+            m_close_after_write = true;
+        }
+    } else {
+        auto connection = response.headers.find("Connection");
+        bool response_close = connection != response.headers.end() && connection->second == "close";
+        if (response_close || !request.keep_alive()) {
+            m_close_after_write = true;
+        }
+    }
+
+    int status = response.status_code;
+    Metrics::record_request(m_route ? m_route->metrics_id : 0, status);
+    prepare_response(std::move(response));
+    trace_end(status);
+
+    // 响应已序列化，请求不再被引用，可以丢弃其字节并开始解析下一个请求
+    ++m_requests;
+    reset_for_keep_alive();
+}
+
+// 发送队列中的数据：连续的内存片段合并为一次 writev，文件体用 sendfile
+bool HttpConnection::flush(Action& action) {
+    while (m_out_head < m_out.size()) {
+        OutSegment& head = m_out[m_out_head];
+
+        if (head.buf_len == 0 && head.body_len == 0) {
+            // 响应头已发送完，发送文件内容
+            if (head.file_len > 0) {
+                ssize_t bytes_written = sendfile(m_sockfd, head.file_fd, &head.file_offset, head.file_len);
                 if (bytes_written == -1) {
                     if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                        return Action::Write;
+                        action = Action::Write;
+                        return false;
                     }
-                    LOG_ERROR("write header error: %s", strerror(errno));
-                    close(m_file_fd);
-                    m_file_fd = -1;
-                    return Action::Close;
+                    LOG_ERROR("sendfile error: %s", strerror(errno));
+                    action = Action::Close;
+                    return false;
                 }
-                
-                m_iov[0].iov_base = (char*)m_iov[0].iov_base + bytes_written;
-                m_iov[0].iov_len -= bytes_written;
-                m_bytes_to_send -= bytes_written;
-                m_bytes_have_sent += bytes_written;
-                
-                if (m_iov[0].iov_len > 0) {
-                    // 响应头还没发送完
+                head.file_len -= bytes_written;
+                m_bytes_sent += bytes_written;
+                Metrics::local().bytes_out.add(bytes_written);
+                if (head.file_len > 0) {
                     continue;
                 }
             }
-            
-            // 发送文件内容
-            if (m_file_bytes_to_send > 0) {
-                bytes_written = sendfile(m_sockfd, m_file_fd, &m_file_offset, m_file_bytes_to_send);
-                if (bytes_written == -1) {
-                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                        return Action::Write;
-                    }
-                    LOG_ERROR("sendfile error: %s", strerror(errno));
-                    close(m_file_fd);
-                    m_file_fd = -1;
-                    return Action::Close;
-                }
-                
-                m_file_bytes_to_send -= bytes_written;
-                m_bytes_to_send -= bytes_written;
-                m_bytes_have_sent += bytes_written;
+            head.pin.reset(); // 最后一个引用释放时关闭文件
+            ++m_out_head;
+            continue;
+        }
+
+        // 从队首开始收集内存片段（响应头 + 内存响应体），遇到带文件体的片段为止
+        struct iovec iov[HTTP_WRITE_IOV_MAX];
+        int iov_count = 0;
+        for (size_t i = m_out_head; i < m_out.size() && iov_count + 2 <= HTTP_WRITE_IOV_MAX; ++i) {
+            const OutSegment& seg = m_out[i];
+            if (seg.buf_len > 0) {
+                iov[iov_count].iov_base = m_write_buffer.data() + seg.buf_offset;
+                iov[iov_count].iov_len = seg.buf_len;
+                ++iov_count;
             }
-        } else {
-            // 发送普通响应（JSON或HTML等）
-            bytes_written = writev(m_sockfd, m_iov, m_iov_count);
-            
-            if (bytes_written == -1) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    return Action::Write;
-                }
-                LOG_ERROR("writev error: %s", strerror(errno));
-                return Action::Close;
+            if (seg.body_len > 0) {
+                iov[iov_count].iov_base = const_cast<char*>(seg.body);
+                iov[iov_count].iov_len = seg.body_len;
+                ++iov_count;
             }
-            
-            m_bytes_have_sent += bytes_written;
-            m_bytes_to_send -= bytes_written;
-            
-            // 更新iovec结构
-            if (bytes_written >= m_iov[0].iov_len) {
-                // 第一个缓冲区已经发送完毕
-                bytes_written -= m_iov[0].iov_len;
-                m_iov[0].iov_len = 0;
-                
-                if (m_iov_count > 1 && bytes_written > 0) {
-                    // 更新第二个缓冲区
-                    m_iov[1].iov_base = (char*)m_iov[1].iov_base + bytes_written;
-                    m_iov[1].iov_len -= bytes_written;
-                }
-            } else {
-                // 第一个缓冲区还没发送完
-                m_iov[0].iov_base = (char*)m_iov[0].iov_base + bytes_written;
-                m_iov[0].iov_len -= bytes_written;
+            if (seg.file_fd != -1) {
+                break;
             }
         }
+
+        ssize_t bytes_written = writev(m_sockfd, iov, iov_count);
+        if (bytes_written == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                action = Action::Write;
+                return false;
+            }
+            LOG_ERROR("writev error: %s", strerror(errno));
+            action = Action::Close;
+            return false;
+        }
+
+        // 按发送的字节数推进队列
+        m_bytes_sent += bytes_written;
+        Metrics::local().bytes_out.add(bytes_written);
+        size_t remaining = bytes_written;
+        for (size_t i = m_out_head; i < m_out.size() && remaining > 0; ++i) {
+            OutSegment& seg = m_out[i];
+            size_t n = std::min(remaining, seg.buf_len);
+            seg.buf_offset += n;
+            seg.buf_len -= n;
+            remaining -= n;
+            n = std::min(remaining, seg.body_len);
+            seg.body += n;
+            seg.body_len -= n;
+            remaining -= n;
+            if (seg.buf_len > 0 || seg.body_len > 0 || seg.file_fd != -1) {
+                break;
+            }
+            seg.pin.reset();
+            m_out_head = i + 1;
+        }
     }
-    
-    // 数据发送完毕，关闭文件描述符
-    if (m_file_fd != -1) {
-        close(m_file_fd);
-        m_file_fd = -1;
-    }
-    
-    // 检查是否为Keep-Alive连接
-    const HttpRequest& request = m_parser.get_request();
-    auto connection_header = request.get_header("Connection");
-    
-    if (connection_header && (*connection_header == "keep-alive" || *connection_header == "Keep-Alive")) {
-        // Keep-Alive连接，重置状态等待下一个请求
-        reset_for_keep_alive();
-        return Action::Wait;
-    } else {
-        // 非Keep-Alive连接，若为websocket升级则返回升级事件，否则直接关闭协议
-        if(m_is_websocket) {
+
+    // 本批全部发送完毕，缓冲区复用给下一批
+    m_out.clear();
+    m_out_head = 0;
+    m_write_buffer.clear();
+    return true;
+}
+
+// 向socket写入数据
+Action HttpConnection::handle_write() {
+    while (true) {
+        Action action = Action::Write;
+        if (!flush(action)) {
+            return action;
+        }
+        if (m_trace_pending) {
+            m_trace_done.t[(size_t)TracePoint::Flushed] = Metrics::now_ns();
+            Trace::get_instance().commit(m_trace_done);
+            m_trace_pending = false;
+        }
+
+        // 过载降级、Connection: close 或解析错误的响应发送完毕后直接关闭，释放连接资源
+        if (m_close_after_write) {
+            return Action::Close;
+        }
+        // websocket 握手响应发送完毕，升级协议
+        if (m_upgrade_after_write) {
+            m_upgrade_after_write = false;
             m_is_websocket = false; // 重置状态
             return Action::Upgrade;
         }
-        else{
-            return Action::Close;
-        }    
+
+        // 继续处理读缓冲区中剩余的管线化请求，产生新的响应则立即发送
+        action = process_buffered();
+        if (action != Action::Write) {
+            return action == Action::Read ? Action::Wait : action;
+        }
     }
 }
 
-// 准备响应数据
-void HttpConnection::prepare_response(const HttpResponse& response) {
-    // 清空写缓冲区
-    m_write_buffer.clear();
-    
-    // 构建响应头
-    std::ostringstream header_stream;
-    header_stream << "HTTP/1.1 " << response.status_code << " " << response.status_text << "\r\n";
-    
-    // 添加响应头
-    for (const auto& [key, value] : response.headers) {
-        header_stream << key << ": " << value << "\r\n";
+namespace {
+    // 响应体所在的文件，由发送队列中引用它的所有片段共享，最后一个片段发送完时关闭
+    struct ScopedFile {
+        int fd;
+        explicit ScopedFile(int f) : fd(f) {}
+        ~ScopedFile() { close(fd); }
+    };
+
+    // 生成 multipart/byteranges 的分隔符
+    std::string make_boundary() {
+        static thread_local std::mt19937_64 rng(std::random_device{}());
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)rng());
+        return buf;
     }
-    
+}
+
+// 把响应序列化后直接追加到 m_write_buffer 并加入发送队列
+void HttpConnection::prepare_response(HttpResponse&& response) {
+    OutSegment seg{m_write_buffer.size(), 0, nullptr, 0, -1, 0, 0, nullptr};
+    BodySource source;
+
     // 如果是文件响应
     if (!response.file_path.empty()) {
         // 打开文件
-        m_file_fd = open(response.file_path.c_str(), O_RDONLY);
-        if (m_file_fd == -1) {
+        int file_fd = open(response.file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_fd == -1) {
             LOG_ERROR("Failed to open file: %s", response.file_path.c_str());
             // 发送404错误
-            HttpResponse error_response = HttpResponse::make_error(404);
-            prepare_response(error_response);
+            prepare_response(HttpResponse::make_error(404));
             return;
         }
         
         // 获取文件大小
         struct stat file_stat;
-        if (fstat(m_file_fd, &file_stat) == -1) {
+        if (fstat(file_fd, &file_stat) == -1) {
             LOG_ERROR("Failed to get file stat: %s", response.file_path.c_str());
-            close(m_file_fd);
-            m_file_fd = -1;
-            HttpResponse error_response = HttpResponse::make_error(500);
-            prepare_response(error_response);
+            close(file_fd);
+            prepare_response(HttpResponse::make_error(500));
             return;
         }
-        
-        // 如果上层没设置 Content-Length，则自动补充
-        if (response.headers.find("Content-Length") == response.headers.end()) {
-            header_stream << "Content-Length: " << file_stat.st_size << "\r\n";
-        }
-        header_stream << "\r\n";
-        
-        // 准备iovec结构
-        std::string header_str = header_stream.str();
-        m_write_buffer.assign(header_str.begin(), header_str.end());
-        
-        // 确保缓冲区不为空
-        if (!m_write_buffer.empty()) {
-            m_iov[0].iov_base = m_write_buffer.data();
-            m_iov[0].iov_len = m_write_buffer.size();
-        } else {
-            m_iov[0].iov_base = nullptr;
-            m_iov[0].iov_len = 0;
-        }
-        m_iov_count = 1;
-        
-        m_file_offset = 0;
-        m_file_bytes_to_send = file_stat.st_size;
-        m_bytes_to_send = m_write_buffer.size() + file_stat.st_size;
+        source.fd = file_fd;
+        source.size = file_stat.st_size;
+        source.pin = std::make_shared<ScopedFile>(file_fd);
+    } else if (!response.shared_body.empty()) {
+        // 不经拷贝的响应体，作为单独的 iovec 发送
+        source.data = response.shared_body.data();
+        source.size = response.shared_body.size();
+        source.pin = response.pin;
+    } else if (response.body.size() > HTTP_INLINE_BODY_MAX) {
+        // 较大的 body 移交给发送队列持有，作为单独的 iovec 发送，不拷贝进写缓冲区
+        auto body = std::make_shared<std::string>(std::move(response.body));
+        source.data = body->data();
+        source.size = body->size();
+        source.pin = std::move(body);
+    }
+
+    if (!response.ranges.empty()) {
+        prepare_range_response(response, source);
+        return;
+    }
+
+    // 状态行与响应头；较小的 body 与响应头一起放入写缓冲区
+    HeaderWriter<PoolBuffer> writer(m_write_buffer);
+    bool inline_body = source.fd == -1 && !source.data;
+    size_t estimate = 64 + HTTP_CLOCK_PREFIX_MAX + response.raw_headers.size() + (inline_body ? response.body.size() : 0);
+    for (const auto& [key, value] : response.headers) {
+        estimate += key.size() + value.size() + 4;
+    }
+    writer.reserve(estimate);
+    append_status_and_headers(response, false);
+    // 如果上层没设置 Content-Length，则自动补充；1xx/204/304 没有响应体，也不带 Content-Length
+    bool has_body = response.status_code >= 200 && response.status_code != 204 && response.status_code != 304;
+    if (has_body && response.raw_headers.empty() &&
+        response.headers.find("Content-Length") == response.headers.end()) {
+        writer.header("Content-Length", inline_body ? response.body.size() : source.size);
+    }
+    writer.end();
+
+    if (source.fd != -1) {
+        seg.file_fd = source.fd;
+        seg.file_len = source.size;
+        seg.pin = std::move(source.pin);
+    } else if (source.data) {
+        seg.body = source.data;
+        seg.body_len = source.size;
+        seg.pin = std::move(source.pin);
     } else {
-        // 文本响应
-        if (!response.body.empty() && 
-            response.headers.find("Content-Length") == response.headers.end()) {
-            header_stream << "Content-Length: " << response.body.size() << "\r\n";
+        writer.append(response.body);
+    }
+    seg.buf_len = m_write_buffer.size() - seg.buf_offset;
+    m_out.push_back(std::move(seg));
+}
+
+// 状态行与响应头（不含结尾空行）；skip_content_type 为 true 时不输出 headers 中的 Content-Type
+void HttpConnection::append_status_and_headers(const HttpResponse& response, bool skip_content_type) {
+    HeaderWriter<PoolBuffer> writer(m_write_buffer);
+    writer.status_line(response.status_code, response.status_text);
+    // Date 与 Server：每秒格式化一次的前缀，这里只是拷贝
+    char prefix[HTTP_CLOCK_PREFIX_MAX];
+    writer.append(std::string_view(prefix, HttpClock::copy_prefix(prefix)));
+    for (const auto& [key, value] : response.headers) {
+        if (skip_content_type && key == "Content-Type") {
+            continue;
         }
-        header_stream << "\r\n";
-        
-        if (!response.body.empty()) {
-            header_stream << response.body;
+        writer.header(key, value);
+    }
+    writer.append(response.raw_headers);
+}
+
+// 206 Partial Content：单个区间直接发送，多个区间以 multipart/byteranges 发送，
+// 每个区间是一个发送片段，文件体按各自的偏移 sendfile，内存体作为独立的 iovec
+void HttpConnection::prepare_range_response(const HttpResponse& response, const BodySource& source) {
+    for (const ByteRange& range : response.ranges) {
+        if (range.first > range.last || range.last >= source.size) {
+            // 文件在 handler 检查之后发生了变化
+            prepare_response(HttpResponse::make_error(500));
+            return;
         }
-        
-        std::string response_str = header_stream.str();
-        m_write_buffer.assign(response_str.begin(), response_str.end());
-        
-        // 确保缓冲区不为空
-        if (!m_write_buffer.empty()) {
-            m_iov[0].iov_base = m_write_buffer.data();
-            m_iov[0].iov_len = m_write_buffer.size();
+    }
+
+    HeaderWriter<PoolBuffer> writer(m_write_buffer);
+    // 片段的响应体指向区间
+    auto set_body = [&](OutSegment& seg, const ByteRange& range) {
+        uint64_t length = range.last - range.first + 1;
+        if (source.fd != -1) {
+            seg.file_fd = source.fd;
+            seg.file_offset = range.first;
+            seg.file_len = length;
         } else {
-            m_iov[0].iov_base = nullptr;
-            m_iov[0].iov_len = 0;
+            seg.body = source.data + range.first;
+            seg.body_len = length;
         }
-        m_iov_count = 1;
-        
-        m_bytes_to_send = m_write_buffer.size();
+        seg.pin = source.pin;
+    };
+
+    OutSegment seg{m_write_buffer.size(), 0, nullptr, 0, -1, 0, 0, nullptr};
+
+    if (response.ranges.size() == 1) {
+        const ByteRange& range = response.ranges[0];
+        append_status_and_headers(response, false);
+        writer.content_range(range.first, range.last, source.size);
+        writer.header("Content-Length", range.last - range.first + 1);
+        writer.end();
+        set_body(seg, range);
+        seg.buf_len = m_write_buffer.size() - seg.buf_offset;
+        m_out.push_back(std::move(seg));
+        return;
     }
-    
-    m_bytes_have_sent = 0;
+
+    // 多区间：先生成每个分段的头部以计算总长度
+    auto type = response.headers.find("Content-Type");
+    std::string boundary = make_boundary();
+    std::vector<std::string> part_headers;
+    part_headers.reserve(response.ranges.size());
+    uint64_t length = 0;
+    for (const ByteRange& range : response.ranges) {
+        std::string part;
+        HeaderWriter<std::string> part_writer(part);
+        part_writer.append("\r\n--");
+        part_writer.append(boundary);
+        part_writer.append("\r\n");
+        if (type != response.headers.end()) {
+            part_writer.header("Content-Type", type->second);
+        }
+        part_writer.content_range(range.first, range.last, source.size);
+        part_writer.end();
+        length += part.size() + (range.last - range.first + 1);
+        part_headers.push_back(std::move(part));
+    }
+    std::string closing = "\r\n--" + boundary + "--\r\n";
+    length += closing.size();
+
+    append_status_and_headers(response, true);
+    writer.append("Content-Type: multipart/byteranges; boundary=");
+    writer.append(boundary);
+    writer.append("\r\n");
+    writer.header("Content-Length", length);
+    writer.end();
+
+    for (size_t i = 0; i < response.ranges.size(); ++i) {
+        writer.append(part_headers[i]);
+        set_body(seg, response.ranges[i]);
+        seg.buf_len = m_write_buffer.size() - seg.buf_offset;
+        m_out.push_back(std::move(seg));
+        seg = OutSegment{m_write_buffer.size(), 0, nullptr, 0, -1, 0, 0, nullptr};
+    }
+    writer.append(closing);
+    seg.buf_len = closing.size();
+    m_out.push_back(std::move(seg));
+}
+
+ConnPhase HttpConnection::phase() const {
+    if (m_out_head < m_out.size()) {
+        return ConnPhase::Write;
+    }
+    if (m_parser.in_body()) {
+        return ConnPhase::Body;
+    }
+    // 读缓冲区中残留的是下一个（管线化）请求的开头
+    return m_read_buffer.empty() ? ConnPhase::Idle : ConnPhase::Header;
+}
+
+// 丢弃发送队列（文件随 pin 一起关闭）
+void HttpConnection::clear_output() {
+    m_out.clear();
+    m_out_head = 0;
+    m_write_buffer.clear();
 }
 
-// 重置连接状态以支持Keep-Alive
+// 当前请求处理完毕，准备处理同一连接上的下一个请求
 void HttpConnection::reset_for_keep_alive() {
+    // 丢弃上一个请求仍留在读缓冲区中的头部字节（零拷贝请求在处理完之前一直引用它们），
+    // 其后可能紧跟着管线化的下一个请求
+    size_t consumed = std::min(m_parser.consumed(), m_read_buffer.size());
+    m_read_buffer.erase(m_read_buffer.begin(), m_read_buffer.begin() + consumed);
     m_parser.reset();
-    m_read_buffer.clear();
-    m_write_buffer.clear();
-    m_is_writing = false;
-    
-    if (m_file_fd != -1) {
-        close(m_file_fd);
-        m_file_fd = -1;
+    m_route = nullptr;
+    m_is_websocket = false;
+    m_trace_begun = false;
+    m_trace_sampled = false;
+}
+
+// 新请求开始：按采样率决定是否追踪
+void HttpConnection::trace_begin() {
+    m_trace_begun = true;
+    m_trace_sampled = Trace::get_instance().sample();
+    if (!m_trace_sampled) {
+        return;
     }
-    
-    m_file_offset = 0;
-    m_file_bytes_to_send = 0;
-    
-    // 清零iovec结构
-    memset(m_iov, 0, sizeof(m_iov));
-    m_iov_count = 0;
-    m_bytes_to_send = 0;
-    m_bytes_have_sent = 0;
+    memset(&m_trace, 0, sizeof(m_trace));
+    m_trace.t[(size_t)TracePoint::Accept] = m_requests == 0 ? m_accept_ns : 0;
+    m_trace.t[(size_t)TracePoint::Read] = Metrics::now_ns();
+    m_trace.reactor_tid = Trace::thread_id();
+    m_trace.fd = m_sockfd;
+}
 
-    m_is_websocket = false;
+// 响应已入队：在请求被丢弃前拷贝请求信息；上一条记录还未发送完时丢弃本条
+void HttpConnection::trace_end(int status) {
+    if (!m_trace_sampled) {
+        return;
+    }
+    m_trace_sampled = false;
+    if (m_trace_pending) {
+        return;
+    }
+    const HttpRequest& request = m_parser.get_request();
+    m_trace.t[(size_t)TracePoint::Queued] = Metrics::now_ns();
+    m_trace.status = (uint16_t)status;
+    m_trace.method = (uint8_t)request.method;
+    m_trace.route_id = m_route ? m_route->metrics_id : 0;
+    size_t len = std::min(request.path.size(), TRACE_PATH_MAX - 1);
+    memcpy(m_trace.path, request.path.data(), len);
+    m_trace.path[len] = '\0';
+    m_trace_done = m_trace;
+    m_trace_pending = true;
+}
+
+// Pool 路由的响应回到 SubReactor 线程（handler 在本线程执行的请求没有这一跳）
+void HttpConnection::trace_returned() {
+    if (m_trace_pending && m_trace_done.worker_tid != Trace::thread_id() &&
+        m_trace_done.t[(size_t)TracePoint::Reactor] == 0) {
+        m_trace_done.t[(size_t)TracePoint::Reactor] = Metrics::now_ns();
+    }
 }
 
 // 完全重置连接状态
 void HttpConnection::reset() {
     reset_for_keep_alive();
+    clear_output();
+    m_close_after_write = false;
+    m_upgrade_after_write = false;
+    m_trace_pending = false;
 }
 
 // 重新初始化连接（用于内存池复用）
 void HttpConnection::reinitialize(int sockfd, const sockaddr_in& addr, Router* router, RequestContext* context) {
-    // 关闭旧的文件描述符（如果有）
-    if (m_file_fd != -1) {
-        close(m_file_fd);
-        m_file_fd = -1;
-    }
-    
     // 设置新的连接参数
     m_sockfd = sockfd;
     m_address = addr;
@@ -352,4 +595,8 @@ void HttpConnection::reinitialize(int sockfd, const sockaddr_in& addr, Router* r
     // 清空缓冲区但保持容量
     m_read_buffer.clear();
     m_write_buffer.clear();
+    m_bytes_read = 0;
+    m_bytes_sent = 0;
+    m_requests = 0;
+    m_accept_ns = Trace::get_instance().enabled() ? Metrics::now_ns() : 0;
 }
@@ -50,42 +50,73 @@ HttpParser::HttpParser(std::string temp_upload_dir)
 }
 void HttpParser::reset() {
     m_state = ParseState::REQUEST_LINE;
-    m_request = HttpRequest();
+    m_request.clear();
     m_boundary.clear();
     m_current_part_name.clear();
     m_current_file.reset();
     if (m_file_stream.is_open()) {
         m_file_stream.close();
     }
+    m_content_length = 0;
+    m_consumed = 0;
+    m_tokens.clear();
 }
-bool HttpParser::parse_request_line(const std::string& line) {
-    // ... 实现和之前一样 ...
-    std::istringstream iss(line);
-    std::string method_str, path, version;
-    if (!(iss >> method_str >> path >> version)) {
+// 去掉首尾的空格和制表符
+static std::string_view trim(std::string_view s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) return std::string_view();
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+// 取出下一个以空格分隔的字段
+static std::string_view next_token(std::string_view& s) {
+    size_t begin = s.find_first_not_of(' ');
+    if (begin == std::string_view::npos) {
+        s = std::string_view();
+        return s;
+    }
+    s.remove_prefix(begin);
+    size_t end = s.find(' ');
+    std::string_view token = s.substr(0, end);
+    s.remove_prefix(end == std::string_view::npos ? s.size() : end);
+    return token;
+}
+bool HttpParser::parse_request_line(std::string_view line) {
+    std::string_view method_str = next_token(line);
+    std::string_view path = next_token(line);
+    std::string_view version = next_token(line);
+    if (version.empty()) {
         return false;
     }
     if (method_str == "GET") m_request.method = HttpMethod::GET;
     else if (method_str == "POST") m_request.method = HttpMethod::POST;
     else if (method_str == "HEAD") m_request.method = HttpMethod::HEAD;
     else m_request.method = HttpMethod::UNKNOWN;
-    m_request.path = path;
+    m_request.set_target(path);
     m_request.version = version;
     return true;
 }
-bool HttpParser::parse_header_line(const std::string& line) {
-    // ... 实现和之前一样 ...
-    size_t colon_pos = line.find(':');
-    if (colon_pos == std::string::npos) {
+// 根据分词结果构建请求行与请求头（不再逐行查找 \r\n 和 ':'）
+bool HttpParser::parse_header_block(std::string_view data) {
+    if (m_tokens.count == 0) {
+        return false;
+    }
+    const HttpTokens::Line& request_line = m_tokens.lines[0];
+    if (!parse_request_line(data.substr(request_line.begin, request_line.end - request_line.begin))) {
         return false;
     }
-    std::string key = line.substr(0, colon_pos);
-    std::string value = line.substr(colon_pos + 1);
-    key.erase(0, key.find_first_not_of(" \t"));
-    key.erase(key.find_last_not_of(" \t") + 1);
-    value.erase(0, value.find_first_not_of(" \t"));
-    value.erase(value.find_last_not_of(" \t") + 1);
-    m_request.headers[key] = value;
+    for (size_t i = 1; i < m_tokens.count; ++i) {
+        const HttpTokens::Line& line = m_tokens.lines[i];
+        if (line.colon == HttpTokens::NO_COLON) {
+            return false;
+        }
+        std::string_view name = data.substr(line.begin, line.colon - line.begin);
+        std::string_view value = data.substr(line.colon + 1, line.end - line.colon - 1);
+        // 分词器已限制行数，数组不会溢出
+        if (!m_request.headers.add(trim(name), trim(value))) {
+            return false;
+        }
+    }
     return true;
 }
 void HttpParser::handle_form_urlencoded(const std::string& body) {
@@ -100,57 +131,61 @@ void HttpParser::handle_form_urlencoded(const std::string& body) {
         }
     }
 }
-// 主要解析逻辑，和之前一样
-HttpParser::ParseResult HttpParser::parse(std::vector<char>& buffer) {
-    // ... 这部分代码完全不需要修改，和之前一样 ...
+// 主要解析逻辑
+// 请求行和请求头只在整个头部块到齐后一次性解析，结果是指向 buffer 的 string_view，
+// 无请求体的请求解析完成后不修改 buffer，由调用方在处理完请求后丢弃 consumed() 字节；
+// 带请求体的请求先把头部复制到请求中，再按原来的方式逐段消费 buffer 中的请求体
+HttpParser::ParseResult HttpParser::parse(PoolBuffer& buffer) {
     std::string_view data(buffer.data(), buffer.size());
     size_t processed_bytes = 0;
+
+    if (m_state == ParseState::REQUEST_LINE) {
+        // 一次遍历找出所有行尾和冒号，数据不完整时下次从上次扫描的位置继续
+        HttpScanner::Result scan = HttpScanner::scan(data.data(), data.size(), m_tokens);
+        if (scan == HttpScanner::Result::Incomplete) return ParseResult::Incomplete;
+        if (scan == HttpScanner::Result::TooMany) return ParseResult::TooManyHeaders;
+        if (!parse_header_block(data)) return ParseResult::Error;
+        processed_bytes = m_tokens.header_end;
+
+        if (m_request.is_multipart()) {
+            m_boundary = "--" + m_request.get_boundary();
+            if (m_boundary == "--") return ParseResult::Error;
+            m_state = ParseState::MULTIPART_BOUNDARY_SEARCH;
+        } else if (auto content_length_str = m_request.get_header("Content-Length")) {
+            try {
+                m_content_length = std::stoul(std::string(*content_length_str));
+            } catch(...) { return ParseResult::Error; }
+            m_state = m_content_length > 0 ? ParseState::BODY : ParseState::DONE;
+        } else {
+            m_state = ParseState::DONE;
+        }
+
+        if (m_state == ParseState::DONE) {
+            // 零拷贝路径：请求行/请求头直接引用 buffer
+            m_consumed = processed_bytes;
+            return ParseResult::Complete;
+        }
+
+        // 请求体会被逐段消费并从 buffer 中删除，先让请求持有头部副本
+        m_request.detach_from(data.substr(0, processed_bytes));
+    }
+
     while (processed_bytes < data.size()) {
         switch (m_state) {
             case ParseState::REQUEST_LINE:
-            case ParseState::HEADERS: {
-                size_t crlf_pos = data.find("\r\n", processed_bytes);
-                if (crlf_pos == std::string_view::npos) return ParseResult::Incomplete;
-                std::string line = std::string(data.substr(processed_bytes, crlf_pos - processed_bytes));
-                processed_bytes = crlf_pos + 2;
-                if (m_state == ParseState::REQUEST_LINE) {
-                    if (!parse_request_line(line)) return ParseResult::Error;
-                    m_state = ParseState::HEADERS;
-                } else {
-                    if (line.empty()) {
-                        if (m_request.is_multipart()) {
-                            m_boundary = "--" + m_request.get_boundary();
-                            if (m_boundary == "--") return ParseResult::Error;
-                            m_state = ParseState::MULTIPART_BOUNDARY_SEARCH;
-                        } else if (m_request.get_header("Content-Length")) {
-                            m_state = ParseState::BODY;
-                        } else {
-                            m_state = ParseState::DONE;
-                        }
-                    } else {
-                        if (!parse_header_line(line)) return ParseResult::Error;
-                    }
-                }
-                break;
-            }
+                return ParseResult::Error; // 不会到达
             case ParseState::BODY: {
-                auto content_length_str = m_request.get_header("Content-Length");
-                if (!content_length_str) return ParseResult::Error;
-                size_t content_length = 0;
-                try {
-                    content_length = std::stoul(std::string(*content_length_str));
-                } catch(...) { return ParseResult::Error; }
                 size_t body_received = m_request.raw_body.size();
-                size_t bytes_to_read = std::min(data.size() - processed_bytes, content_length - body_received);
+                size_t bytes_to_read = std::min(data.size() - processed_bytes, m_content_length - body_received);
                 m_request.raw_body.append(data.substr(processed_bytes, bytes_to_read));
                 processed_bytes += bytes_to_read;
-                if (m_request.raw_body.size() == content_length) {
+                if (m_request.raw_body.size() == m_content_length) {
                     auto content_type = m_request.get_header("Content-Type");
                     if (content_type && content_type->find("application/x-www-form-urlencoded") != std::string::npos) {
                         handle_form_urlencoded(m_request.raw_body);
                     }
                     m_state = ParseState::DONE;
-                } else if (m_request.raw_body.size() > content_length) {
+                } else if (m_request.raw_body.size() > m_content_length) {
                     return ParseResult::Error;
                 }
                 break;
@@ -1,16 +1,63 @@
 #include "http/HttpRequest.h"
 #include <algorithm>
 #include <cctype>
+#include <strings.h> // for strncasecmp
+#include <arpa/inet.h> // for ntohl
+
+// ---------------------
+// 追加请求头
+// ---------------------
+bool HttpHeaders::add(std::string_view name, std::string_view value) {
+    if (m_count == HTTP_MAX_HEADERS) return false;
+    uint32_t hash = hash_name(name);
+    size_t idx = m_count++;
+    m_items[idx] = HttpHeader{name, value};
+    m_hashes[idx] = hash;
+
+    // 线性探测；遇到同名请求头时让索引指向新的一个
+    for (size_t slot = hash & (INDEX_SIZE - 1);; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+        if (m_index[slot] == 0) {
+            m_index[slot] = (uint8_t)(idx + 1);
+            return true;
+        }
+        size_t j = m_index[slot] - 1;
+        if (m_hashes[j] == hash && m_items[j].name.size() == name.size() &&
+            strncasecmp(m_items[j].name.data(), name.data(), name.size()) == 0) {
+            m_index[slot] = (uint8_t)(idx + 1);
+            return true;
+        }
+    }
+}
+
+// ---------------------
+// 按名字查找请求头
+// ---------------------
+std::optional<std::string_view> HttpHeaders::get(std::string_view name, uint32_t hash) const {
+    for (size_t slot = hash & (INDEX_SIZE - 1); m_index[slot] != 0; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+        const size_t j = m_index[slot] - 1;
+        const HttpHeader& h = m_items[j];
+        if (m_hashes[j] == hash && h.name.size() == name.size() &&
+            strncasecmp(h.name.data(), name.data(), name.size()) == 0) {
+            return h.value;
+        }
+    }
+    return std::nullopt;
+}
 
 // ---------------------
 // 获取头部字段
 // ---------------------
 std::optional<std::string_view> HttpRequest::get_header(std::string_view key) const {
-    // 不区分大小写匹配
-    for (const auto& [k, v] : headers) {
-        if (std::equal(k.begin(), k.end(), key.begin(), key.end(),
-                       [](char a, char b) { return std::tolower(a) == std::tolower(b); })) {
-            return std::string_view(v);
+    return headers.get(key);
+}
+
+// ---------------------
+// 获取路径参数
+// ---------------------
+std::optional<std::string_view> HttpRequest::get_param(std::string_view name) const {
+    for (size_t i = 0; i < params.count; ++i) {
+        if (params.items[i].name == name) {
+            return std::string_view(path).substr(params.items[i].offset, params.items[i].length);
         }
     }
     return std::nullopt;
@@ -60,22 +107,108 @@ bool HttpRequest::is_websocket_upgrade() const {
     }
 
     // 检查 Upgrade 头
-    auto it_upgrade = headers.find("Upgrade");
-    if (it_upgrade == headers.end() ||
-        strcasecmp(it_upgrade->second.c_str(), "websocket") != 0) {
+    auto upgrade = get_header("Upgrade");
+    if (!upgrade || upgrade->size() != 9 || strncasecmp(upgrade->data(), "websocket", 9) != 0) {
         return false;
     }
 
     // 检查 Sec-WebSocket-Key 头
-    if (headers.find("Sec-WebSocket-Key") == headers.end()) {
+    if (!headers.contains("Sec-WebSocket-Key")) {
         return false;
     }
 
     // 检查 Sec-WebSocket-Version 头
-    auto it_version = headers.find("Sec-WebSocket-Version");
-    if (it_version == headers.end() || it_version->second != "13") {
+    auto version_header = get_header("Sec-WebSocket-Version");
+    if (!version_header || *version_header != "13") {
         return false;
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+// 逗号分隔的列表中是否包含 token（忽略大小写与空白）
+static bool list_contains_token(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (item.size() == token.size() && strncasecmp(item.data(), token.data(), token.size()) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---------------------
+// 判断响应后是否保持连接
+// ---------------------
+bool HttpRequest::keep_alive() const {
+    if (auto connection = get_header("Connection")) {
+        if (list_contains_token(*connection, "close")) return false;
+        if (list_contains_token(*connection, "keep-alive")) return true;
+    }
+    return version == "HTTP/1.1";
+}
+
+// ---------------------
+// 是否来自本机回环地址
+// ---------------------
+bool HttpRequest::from_loopback() const {
+    return (ntohl(remote_addr) >> 24) == 127;
+}
+
+// ---------------------
+// 拆分请求目标
+// ---------------------
+void HttpRequest::set_target(std::string_view target) {
+    size_t q = target.find('?');
+    if (q == std::string_view::npos) {
+        path = target;
+        query = std::string_view();
+    } else {
+        path = target.substr(0, q);
+        query = target.substr(q + 1);
+    }
+}
+
+// ---------------------
+// 清空请求（保留容量）
+// ---------------------
+void HttpRequest::clear() {
+    method = HttpMethod::UNKNOWN;
+    path = std::string_view();
+    query = std::string_view();
+    version = std::string_view();
+    headers.clear();
+    remote_addr = 0;
+    params.clear();
+    raw_body.clear();
+    form_fields.clear();
+    uploaded_files.clear();
+    m_header_storage.clear();
+}
+
+// ---------------------
+// 把请求行与请求头复制到自己的存储中
+// ---------------------
+void HttpRequest::detach_from(std::string_view block) {
+    m_header_storage.assign(block.data(), block.size());
+    const char* old_base = block.data();
+    const char* new_base = m_header_storage.data();
+
+    // 位于 block 内的 string_view 平移到副本上，其余保持不变
+    auto remap = [&](std::string_view& v) {
+        if (!v.empty() && v.data() >= old_base && v.data() + v.size() <= old_base + block.size()) {
+            v = std::string_view(new_base + (v.data() - old_base), v.size());
+        }
+    };
+    remap(path);
+    remap(query);
+    remap(version);
+    for (auto& h : headers) {
+        remap(h.name);
+        remap(h.value);
+    }
+}
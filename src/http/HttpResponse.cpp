@@ -1,5 +1,5 @@
 #include "http/HttpResponse.h"
-#include <sstream>
+#include "http/HeaderWriter.h"
 #include <filesystem>
 
 void HttpResponse::set_header(const std::string& key, const std::string& value) {
@@ -27,14 +27,20 @@ HttpResponse& HttpResponse::with_header(std::string_view key, std::string_view v
 // 构建完整 HTTP 响应文本
 // ---------------------
 std::string HttpResponse::to_string() const {
-    std::ostringstream oss;
-    oss << "HTTP/1.1 " << status_code << " " << status_text << "\r\n";
+    std::string out;
+    HeaderWriter<std::string> writer(out);
+    size_t estimate = 64 + body.size();
     for (const auto& [k, v] : headers) {
-        oss << k << ": " << v << "\r\n";
+        estimate += k.size() + v.size() + 4;
     }
-    oss << "\r\n";
-    oss << body;
-    return oss.str();
+    writer.reserve(estimate);
+    writer.status_line(status_code, status_text);
+    for (const auto& [k, v] : headers) {
+        writer.header(k, v);
+    }
+    writer.end();
+    writer.append(body);
+    return out;
 }
 
 // ---------------------
@@ -53,6 +59,13 @@ HttpResponse HttpResponse::make_error(int code) {
         case 404:
             resp.with_status(404, error_404_title).with_body(error_404_form);
             break;
+        case 431:
+            resp.with_status(431, error_431_title).with_body(error_431_form);
+            break;
+        case 503:
+            resp.with_status(503, error_503_title).with_body(error_503_form);
+            resp.set_header("Retry-After", "1");
+            break;
         case 500:
         default:
             resp.with_status(500, error_500_title).with_body(error_500_form);
@@ -0,0 +1,203 @@
+#include "http/HttpScanner.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCANNER_X86 1
+#endif
+
+// ---------------------
+// 处理一个候选字节（'\n' 或 ':'），返回 true 表示找到了头部结束的空行
+// ---------------------
+static inline bool on_delimiter(const char* data, size_t idx, HttpTokens& t, HttpScanner::Result& result) {
+    if (data[idx] == ':') {
+        if (t.colon == HttpTokens::NO_COLON) {
+            t.colon = (uint32_t)idx;
+        }
+        return false;
+    }
+    // '\n'：只有 "\r\n" 才是行结束
+    if (idx == 0 || data[idx - 1] != '\r') {
+        return false;
+    }
+    size_t cr = idx - 1;
+    if (cr == t.line_begin) {
+        // 空行：头部块结束
+        t.header_end = idx + 1;
+        result = HttpScanner::Result::Complete;
+        return true;
+    }
+    if (t.count == HttpTokens::MAX_LINES) {
+        result = HttpScanner::Result::TooMany;
+        return true;
+    }
+    t.lines[t.count++] = HttpTokens::Line{(uint32_t)t.line_begin, (uint32_t)cr, t.colon};
+    t.line_begin = idx + 1;
+    t.colon = HttpTokens::NO_COLON;
+    return false;
+}
+
+// 逐字节扫描 [t.pos, end)
+static inline bool scan_tail(const char* data, size_t end, HttpTokens& t, HttpScanner::Result& result) {
+    for (size_t i = t.pos; i < end; ++i) {
+        char c = data[i];
+        if ((c == '\n' || c == ':') && on_delimiter(data, i, t, result)) {
+            t.pos = i + 1;
+            return true;
+        }
+    }
+    t.pos = end;
+    return false;
+}
+
+// ---------------------
+// 标量实现：SWAR，每次检查 8 字节中是否含有 '\n' 或 ':'
+// ---------------------
+static inline uint64_t swar_has_byte(uint64_t w, uint64_t pattern) {
+    uint64_t v = w ^ pattern;
+    // 含 0 字节的位置最高位为 1（可能有假阳性，逐字节再确认）
+    return (v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL;
+}
+
+static HttpScanner::Result scan_scalar(const char* data, size_t len, HttpTokens& t) {
+    HttpScanner::Result result = HttpScanner::Result::Incomplete;
+    const uint64_t lf = 0x0a0a0a0a0a0a0a0aULL;
+    const uint64_t colon = 0x3a3a3a3a3a3a3a3aULL;
+    size_t i = t.pos;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, sizeof(w));
+        if ((swar_has_byte(w, lf) | swar_has_byte(w, colon)) == 0) {
+            continue;
+        }
+        for (size_t k = i; k < i + 8; ++k) {
+            char c = data[k];
+            if ((c == '\n' || c == ':') && on_delimiter(data, k, t, result)) {
+                t.pos = k + 1;
+                return result;
+            }
+        }
+    }
+    t.pos = i;
+    scan_tail(data, len, t, result);
+    return result;
+}
+
+#ifdef HTTP_SCANNER_X86
+// 依次处理 mask 中置位的字节
+static inline bool drain_mask(const char* data, size_t base, uint32_t mask, HttpTokens& t,
+                              HttpScanner::Result& result) {
+    while (mask) {
+        size_t idx = base + __builtin_ctz(mask);
+        if (on_delimiter(data, idx, t, result)) {
+            t.pos = idx + 1;
+            return true;
+        }
+        mask &= mask - 1;
+    }
+    return false;
+}
+
+// ---------------------
+// SSE2 实现：每次比较 16 字节
+// ---------------------
+__attribute__((target("sse2")))
+static HttpScanner::Result scan_sse2(const char* data, size_t len, HttpTokens& t) {
+    HttpScanner::Result result = HttpScanner::Result::Incomplete;
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i colon = _mm_set1_epi8(':');
+    size_t i = t.pos;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, colon)));
+        if (mask && drain_mask(data, i, mask, t, result)) {
+            return result;
+        }
+    }
+    t.pos = i;
+    scan_tail(data, len, t, result);
+    return result;
+}
+
+// ---------------------
+// AVX2 实现：每次比较 32 字节
+// ---------------------
+__attribute__((target("avx2")))
+static HttpScanner::Result scan_avx2(const char* data, size_t len, HttpTokens& t) {
+    HttpScanner::Result result = HttpScanner::Result::Incomplete;
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i colon = _mm256_set1_epi8(':');
+    size_t i = t.pos;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, colon)));
+        if (mask && drain_mask(data, i, mask, t, result)) {
+            return result;
+        }
+    }
+    t.pos = i;
+    scan_tail(data, len, t, result);
+    return result;
+}
+#endif
+
+// ---------------------
+// 运行时选择实现
+// ---------------------
+bool HttpScanner::supported(Impl impl) {
+    switch (impl) {
+        case Impl::Scalar:
+            return true;
+#ifdef HTTP_SCANNER_X86
+        case Impl::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Impl::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+static HttpScanner::Impl detect_impl() {
+#ifdef HTTP_SCANNER_X86
+    __builtin_cpu_init(); // 在静态初始化阶段调用 __builtin_cpu_supports 前必须先初始化
+#endif
+    if (HttpScanner::supported(HttpScanner::Impl::AVX2)) return HttpScanner::Impl::AVX2;
+    if (HttpScanner::supported(HttpScanner::Impl::SSE2)) return HttpScanner::Impl::SSE2;
+    return HttpScanner::Impl::Scalar;
+}
+
+static HttpScanner::Result (*scan_fn(HttpScanner::Impl impl))(const char*, size_t, HttpTokens&) {
+    switch (impl) {
+#ifdef HTTP_SCANNER_X86
+        case HttpScanner::Impl::AVX2:
+            return scan_avx2;
+        case HttpScanner::Impl::SSE2:
+            return scan_sse2;
+#endif
+        default:
+            return scan_scalar;
+    }
+}
+
+HttpScanner::Impl HttpScanner::s_impl = detect_impl();
+HttpScanner::ScanFn HttpScanner::s_scan = scan_fn(HttpScanner::s_impl);
+
+bool HttpScanner::set_impl(Impl impl) {
+    if (!supported(impl)) {
+        return false;
+    }
+    s_impl = impl;
+    s_scan = scan_fn(impl);
+    return true;
+}
+
+const char* HttpScanner::impl_name(Impl impl) {
+    switch (impl) {
+        case Impl::AVX2: return "avx2";
+        case Impl::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
@@ -1,20 +1,26 @@
 // Router.cpp
 
 #include "http/Router.h"
+#include "metrics/Metrics.h"
 #include <stdexcept>
 
+/**
+ * @brief 检查路径是否包含正则表达式特殊字符（基数树语法使用的 : * . { } , 不算在内）
+ */
+static bool is_regex_pattern(const std::string& path) {
+    return path.find_first_of("^$()[]|\\?+") != std::string::npos;
+}
+
 /**
  * @brief RouteRule构造函数
  */
-RouteRule::RouteRule(const std::string& path, HttpHandler h) 
-    : pattern(path), handler(h) {
-    // 检查是否包含正则表达式特殊字符
-    is_regex = (path.find_first_of(".*+?^${}()|[]\\") != std::string::npos);
-    
-    if (is_regex) {
+RouteRule::RouteRule(const std::string& path, HttpHandler h, ExecPolicy p) 
+    : pattern(path), handler(h), is_regex(false), policy(p) {
+    if (is_regex_pattern(path)) {
         try {
             // 编译正则表达式
             regex_pattern = std::regex(path);
+            is_regex = true;
         } catch (const std::regex_error& e) {
             // 如果正则表达式编译失败，将其作为普通字符串处理
             is_regex = false;
@@ -22,59 +28,276 @@ RouteRule::RouteRule(const std::string& path, HttpHandler h)
     }
 }
 
+/**
+ * @brief 判断通配段匹配到的剩余路径是否满足扩展名约束
+ */
+bool RouteNode::CatchAll::accepts(std::string_view rest) const {
+    if (any_ext) {
+        return true;
+    }
+    if (exts.empty()) {
+        // ".{}"：要求不带扩展名
+        return rest.find('.') == std::string_view::npos;
+    }
+    for (const auto& ext : exts) {
+        // 至少一个字符的主体 + "." + 扩展名，与旧正则 "/.*\.(ext)$" 一致
+        if (rest.size() > ext.size() && rest[rest.size() - ext.size() - 1] == '.' &&
+            rest.compare(rest.size() - ext.size(), ext.size(), ext) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief 向路由表中添加一条路由规则
  * @param method HTTP 方法 (GET, POST, etc.)
- * @param path 请求路径 (e.g., "/login" 或 "/api/user/\d+")
+ * @param path 请求路径模式 (e.g., "/login"、"/api/user/:id" 或末尾通配段，语法见 Router.h)
  * @param handler 用于处理该请求的函数
+ * @param policy 执行策略，默认在 SubReactor 线程内执行
  */
-void Router::add_route(HttpMethod method, const std::string& path, HttpHandler handler) {
-    // 创建路由规则并添加到对应方法的规则列表中
-    m_routes[method].emplace_back(path, handler);
+void Router::add_route(HttpMethod method, const std::string& path, HttpHandler handler, ExecPolicy policy) {
+    MethodRoutes& routes = m_routes[static_cast<size_t>(method)];
+    routes.rules.emplace_back(path, handler, policy);
+    static const char* const method_names[] = {"GET", "POST", "HEAD", "UNKNOWN"};
+    routes.rules.back().metrics_id =
+        Metrics::get_instance().register_route(std::string(method_names[static_cast<size_t>(method)]) + " " + path);
+    const RouteRule* rule = &routes.rules.back();
+
+    if (rule->is_regex) {
+        routes.regex_rules.push_back(rule);
+    } else {
+        insert(&routes.root, path, rule);
+    }
 }
 
 /**
  * @brief 根据传入的请求，查找并执行对应的处理函数
- * @param req 传入的 HttpRequest 对象
+ * @param req 传入的 HttpRequest 对象，匹配得到的路径参数写入 req.params
  * @param context 请求上下文，包含数据库连接池等资源
  * @return HttpResponse 处理函数返回的响应或一个错误响应
  */
-HttpResponse Router::route_request(const HttpRequest& req, RequestContext& context) {
-    // 1. 根据请求方法查找对应的路由规则列表
-    auto method_iter = m_routes.find(req.method);
-    if (method_iter == m_routes.end()) {
-        // 如果没有为该方法注册任何路由
+HttpResponse Router::route_request(HttpRequest& req, RequestContext& context) {
+    const RouteRule* rule = find_route(req);
+    if (rule == nullptr) {
+        // 没有找到匹配的路由规则
         return HttpResponse::make_error(404);
     }
+    // 找到匹配的路由，执行处理函数
+    return rule->handler(req, context);
+}
 
-    // 2. 遍历该方法的所有路由规则，找到匹配的规则
-    const auto& route_rules = method_iter->second;
-    
-    for (const auto& rule : route_rules) {
-        bool matches = false;
-        
-        if (rule.is_regex) {
-            // 使用正则表达式匹配
-            std::smatch match_result;
-            matches = std::regex_match(req.path, match_result, rule.regex_pattern);
-        } else {
-            // 使用精确字符串匹配
-            matches = (req.path == rule.pattern);
+/**
+ * @brief 查找与请求匹配的路由规则
+ * @param req 传入的 HttpRequest 对象，匹配得到的路径参数写入 req.params
+ * @return 匹配的路由规则，未找到返回 nullptr
+ */
+const RouteRule* Router::find_route(HttpRequest& req) const {
+    return match(req.method, req.path, req.params);
+}
+
+/**
+ * @brief 按方法和路径查找路由规则
+ * @param method 请求方法
+ * @param path 请求目标，"?" 之后的查询串不参与匹配
+ * @param params 输出的路径参数（偏移量相对于 path）
+ * @return 匹配的路由规则，未找到返回 nullptr
+ */
+const RouteRule* Router::match(HttpMethod method, std::string_view path, RouteParams& params) const {
+    params.clear();
+
+    // 1. 根据请求方法查找对应的路由表
+    const MethodRoutes& routes = m_routes[static_cast<size_t>(method)];
+
+    path = path.substr(0, path.find('?'));
+
+    // 2. 在基数树中查找，O(路径长度)
+    const RouteRule* rule = match_node(&routes.root, path, 0, params);
+    if (rule) {
+        return rule;
+    }
+
+    // 3. 兼容旧的正则路由，按注册顺序逐条尝试
+    for (const RouteRule* regex_rule : routes.regex_rules) {
+        if (std::regex_match(path.begin(), path.end(), regex_rule->regex_pattern)) {
+            params.clear();
+            return regex_rule;
         }
-        
-        if (matches) {
-            // 找到匹配的路由，执行处理函数
-            return rule.handler(req, context);
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief 解析路由模式并插入基数树
+ * @throws std::invalid_argument 模式语法错误或与已有参数名冲突
+ */
+void Router::insert(RouteNode* root, const std::string& pattern, const RouteRule* rule) {
+    RouteNode* node = root;
+    size_t param_count = 0;
+    size_t i = 0;
+
+    while (i < pattern.size()) {
+        char c = pattern[i];
+        bool segment_start = (i == 0 || pattern[i - 1] == '/');
+
+        if (c == ':' && segment_start) {
+            // ":name" 参数段
+            size_t end = pattern.find('/', i);
+            if (end == std::string::npos) end = pattern.size();
+            std::string name = pattern.substr(i + 1, end - i - 1);
+            if (name.empty()) {
+                throw std::invalid_argument("Router: empty parameter name in " + pattern);
+            }
+            if (node->param_child && node->param_name != name) {
+                throw std::invalid_argument("Router: conflicting parameter name in " + pattern);
+            }
+            if (!node->param_child) {
+                node->param_child = std::make_unique<RouteNode>();
+                node->param_name = name;
+            }
+            node = node->param_child.get();
+            ++param_count;
+            i = end;
+        } else if (c == '*' && segment_start) {
+            // "*name" 或 "*name.{ext,...}" 通配段，必须位于末尾
+            RouteNode::CatchAll ca;
+            size_t brace = pattern.find(".{", i);
+            ca.name = pattern.substr(i + 1, (brace == std::string::npos ? pattern.size() : brace) - i - 1);
+            if (ca.name.find('/') != std::string::npos) {
+                throw std::invalid_argument("Router: catch-all must be the last segment in " + pattern);
+            }
+            if (brace != std::string::npos) {
+                if (pattern.back() != '}') {
+                    throw std::invalid_argument("Router: malformed extension list in " + pattern);
+                }
+                ca.any_ext = false;
+                std::string_view list(pattern.data() + brace + 2, pattern.size() - brace - 3);
+                while (!list.empty()) {
+                    size_t comma = list.find(',');
+                    std::string_view ext = list.substr(0, comma);
+                    if (!ext.empty()) ca.exts.emplace_back(ext);
+                    if (comma == std::string_view::npos) break;
+                    list.remove_prefix(comma + 1);
+                }
+            }
+            if (++param_count > ROUTE_MAX_PARAMS) {
+                throw std::invalid_argument("Router: too many parameters in " + pattern);
+            }
+            ca.rule = rule;
+            node->catch_alls.push_back(std::move(ca));
+            return;
+        } else {
+            // 字面量，一直到下一个参数段/通配段
+            size_t end = i;
+            while (end < pattern.size() &&
+                   !((pattern[end] == ':' || pattern[end] == '*') && (end == 0 || pattern[end - 1] == '/'))) {
+                ++end;
+            }
+            node = insert_literal(node, std::string_view(pattern).substr(i, end - i));
+            i = end;
         }
     }
 
-    // 3. 没有找到匹配的路由规则
-    return HttpResponse::make_error(404);
+    if (param_count > ROUTE_MAX_PARAMS) {
+        throw std::invalid_argument("Router: too many parameters in " + pattern);
+    }
+    // 重复注册时保留先注册的规则，与旧的线性匹配行为一致
+    if (node->rule == nullptr) {
+        node->rule = rule;
+    }
+}
+
+/**
+ * @brief 插入一段字面量，必要时拆分已有的边
+ * @return 字面量结束处的节点
+ */
+RouteNode* Router::insert_literal(RouteNode* node, std::string_view literal) {
+    while (!literal.empty()) {
+        std::unique_ptr<RouteNode>* slot = nullptr;
+        for (auto& child : node->children) {
+            if (child->prefix[0] == literal[0]) {
+                slot = &child;
+                break;
+            }
+        }
+
+        if (slot == nullptr) {
+            // 没有共同前缀的子节点，直接新建一条边
+            node->children.push_back(std::make_unique<RouteNode>());
+            node->children.back()->prefix = std::string(literal);
+            return node->children.back().get();
+        }
+
+        RouteNode* child = slot->get();
+        size_t common = 0;
+        while (common < child->prefix.size() && common < literal.size() &&
+               child->prefix[common] == literal[common]) {
+            ++common;
+        }
+
+        if (common < child->prefix.size()) {
+            // 拆分边：child 的前缀只有前 common 个字符相同
+            auto mid = std::make_unique<RouteNode>();
+            mid->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            mid->children.push_back(std::move(*slot));
+            *slot = std::move(mid);
+            child = slot->get();
+        }
+
+        literal.remove_prefix(common);
+        node = child;
+    }
+    return node;
 }
 
 /**
- * @brief 检查路径是否包含正则表达式特殊字符
+ * @brief 从 node 开始匹配 path[pos:]（node 自身的前缀已匹配）
+ * 字面量子节点首字符互不相同，因此只有在字面量、参数段、通配段之间才需要回溯
  */
-bool Router::is_regex_pattern(const std::string& path) {
-    return path.find_first_of(".*+?^${}()|[]\\") != std::string::npos;
-}
\ No newline at end of file
+const RouteRule* Router::match_node(const RouteNode* node, std::string_view path, size_t pos,
+                                    RouteParams& params) {
+    // 1. 字面量
+    if (pos == path.size()) {
+        if (node->rule) return node->rule;
+    } else {
+        for (const auto& child : node->children) {
+            const std::string& prefix = child->prefix;
+            if (prefix[0] == path[pos]) {
+                if (path.compare(pos, prefix.size(), prefix) == 0) {
+                    const RouteRule* rule = match_node(child.get(), path, pos + prefix.size(), params);
+                    if (rule) return rule;
+                }
+                break;
+            }
+        }
+    }
+
+    // 2. 参数段：匹配到下一个 '/' 为止，不能为空
+    if (node->param_child && pos < path.size() && path[pos] != '/') {
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) end = path.size();
+        size_t saved = params.count;
+        if (saved < ROUTE_MAX_PARAMS) {
+            params.items[saved] = RouteParam{node->param_name, (uint32_t)pos, (uint32_t)(end - pos)};
+            params.count = saved + 1;
+        }
+        const RouteRule* rule = match_node(node->param_child.get(), path, end, params);
+        if (rule) return rule;
+        params.count = saved;
+    }
+
+    // 3. 通配段：剩余全部路径
+    std::string_view rest = path.substr(pos);
+    for (const auto& ca : node->catch_alls) {
+        if (ca.accepts(rest)) {
+            if (params.count < ROUTE_MAX_PARAMS) {
+                params.items[params.count++] = RouteParam{ca.name, (uint32_t)pos, (uint32_t)rest.size()};
+            }
+            return ca.rule;
+        }
+    }
+
+    return nullptr;
+}
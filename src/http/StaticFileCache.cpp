@@ -0,0 +1,284 @@
+#include "http/StaticFileCache.h"
+#include "log/Log.h"
+#include <filesystem>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// 需要使缓存失效的 inotify 事件
+static const uint32_t WATCH_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                                   IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+StaticFileCache::~StaticFileCache() {
+    if (m_watcher.joinable()) {
+        uint64_t one = 1;
+        ssize_t n = write(m_stop_fd, &one, sizeof(one));
+        (void)n;
+        m_watcher.join();
+    }
+    if (m_inotify_fd != -1) {
+        close(m_inotify_fd);
+    }
+    if (m_stop_fd != -1) {
+        close(m_stop_fd);
+    }
+}
+
+bool StaticFileCache::init(const std::string& doc_root, size_t capacity_bytes) {
+    std::error_code ec;
+    m_doc_root = std::filesystem::canonical(doc_root, ec).string();
+    if (ec) {
+        LOG_ERROR("StaticFileCache: cannot resolve doc_root %s: %s", doc_root.c_str(), ec.message().c_str());
+        return false;
+    }
+    if (capacity_bytes == 0) {
+        return true;
+    }
+
+    m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_inotify_fd == -1 || m_stop_fd == -1) {
+        LOG_ERROR("StaticFileCache: inotify/eventfd init failed: %s, cache disabled", strerror(errno));
+        return false;
+    }
+    add_watch_recursive(m_doc_root);
+
+    m_capacity = capacity_bytes;
+    m_shard_capacity = capacity_bytes / STATIC_CACHE_SHARDS;
+    m_variant_shard_capacity = capacity_bytes / STATIC_CACHE_VARIANT_SHARE / STATIC_CACHE_SHARDS;
+    m_watcher = std::thread(&StaticFileCache::watch_loop, this);
+    LOG_INFO("StaticFileCache: %zu bytes, %zu shards, watching %zu dirs under %s",
+             capacity_bytes, STATIC_CACHE_SHARDS, m_watch_dirs.size(), m_doc_root.c_str());
+    return true;
+}
+
+StaticFileCache::Shard& StaticFileCache::shard_for(Shard* shards, std::string_view key) {
+    return shards[std::hash<std::string_view>()(key) & (STATIC_CACHE_SHARDS - 1)];
+}
+
+std::shared_ptr<const StaticFile> StaticFileCache::lookup(std::string_view key) {
+    return lookup_in(m_shards, key, m_hits, m_misses);
+}
+
+std::shared_ptr<const StaticFile> StaticFileCache::lookup_variant(std::string_view key) {
+    return lookup_in(m_variant_shards, key, m_variant_hits, m_variant_misses);
+}
+
+void StaticFileCache::insert(std::string_view key, std::shared_ptr<const StaticFile> file, uint64_t generation) {
+    insert_in(m_shards, m_shard_capacity, key, std::move(file), generation);
+}
+
+void StaticFileCache::insert_variant(std::string_view key, std::shared_ptr<const StaticFile> file, uint64_t generation) {
+    insert_in(m_variant_shards, m_variant_shard_capacity, key, std::move(file), generation);
+}
+
+void StaticFileCache::variant_key(const StaticFile& file, std::string_view encoding, std::string& key) {
+    key.assign(file.path);
+    key += '\0';
+    key.append(encoding.data(), encoding.size());
+    key += '\0';
+    key += file.etag;
+}
+
+std::shared_ptr<const StaticFile> StaticFileCache::lookup_in(Shard* shards, std::string_view key,
+                                                             std::atomic<uint64_t>& hits,
+                                                             std::atomic<uint64_t>& misses) {
+    if (!enabled()) {
+        return nullptr;
+    }
+    Shard& shard = shard_for(shards, key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return it->second->file;
+}
+
+void StaticFileCache::insert_in(Shard* shards, size_t shard_capacity, std::string_view key,
+                                std::shared_ptr<const StaticFile> file, uint64_t generation) {
+    if (!enabled() || !file) {
+        return;
+    }
+    size_t charge = key.size() + file->content.size() + file->header_block.size() + sizeof(Entry);
+    if (file->content.size() > STATIC_CACHE_MAX_FILE || charge > shard_capacity) {
+        return;
+    }
+
+    Shard& shard = shard_for(shards, key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // 读取文件期间发生过失效，读到的可能是旧内容
+    if (generation != m_generation.load(std::memory_order_acquire)) {
+        return;
+    }
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.bytes -= it->second->charge;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+    shard.lru.push_front(Entry{std::string(key), std::move(file), charge});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.bytes += charge;
+    evict_locked(shard, shard_capacity);
+}
+
+void StaticFileCache::evict_locked(Shard& shard, size_t capacity) {
+    while (shard.bytes > capacity && !shard.lru.empty()) {
+        Entry& victim = shard.lru.back();
+        shard.bytes -= victim.charge;
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void StaticFileCache::invalidate(std::string_view path) {
+    // 先推进代数，使正在读取文件的 insert 放弃插入
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+    invalidate_in(m_shards, path);
+    invalidate_in(m_variant_shards, path);
+}
+
+void StaticFileCache::invalidate_in(Shard* shards, std::string_view path) {
+    for (size_t i = 0; i < STATIC_CACHE_SHARDS; ++i) {
+        Shard& shard = shards[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.lru.begin(); it != shard.lru.end();) {
+            const std::string& file_path = it->file->path;
+            bool match = file_path.compare(0, path.size(), path) == 0 &&
+                         (file_path.size() == path.size() || file_path[path.size()] == '/');
+            if (match) {
+                shard.bytes -= it->charge;
+                shard.index.erase(it->key);
+                it = shard.lru.erase(it);
+                m_invalidations.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void StaticFileCache::clear() {
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+    for (Shard* shards : {m_shards, m_variant_shards}) {
+        for (size_t i = 0; i < STATIC_CACHE_SHARDS; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            shards[i].index.clear();
+            shards[i].lru.clear();
+            shards[i].bytes = 0;
+        }
+    }
+}
+
+StaticFileCache::Stats StaticFileCache::stats() const {
+    Stats s{};
+    s.hits = m_hits.load(std::memory_order_relaxed);
+    s.misses = m_misses.load(std::memory_order_relaxed);
+    s.evictions = m_evictions.load(std::memory_order_relaxed);
+    s.invalidations = m_invalidations.load(std::memory_order_relaxed);
+    s.variant_hits = m_variant_hits.load(std::memory_order_relaxed);
+    s.variant_misses = m_variant_misses.load(std::memory_order_relaxed);
+    for (const Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.entries += shard.lru.size();
+        s.bytes += shard.bytes;
+    }
+    for (const Shard& shard : m_variant_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.variant_entries += shard.lru.size();
+        s.variant_bytes += shard.bytes;
+    }
+    return s;
+}
+
+std::string StaticFileCache::make_etag(ino_t inode, time_t mtime, size_t size) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "\"%lx-%lx-%zx\"", (unsigned long)inode, (unsigned long)mtime, size);
+    return buf;
+}
+
+// ---------------------
+// inotify 监听
+// ---------------------
+void StaticFileCache::add_watch_recursive(const std::string& dir) {
+    // inotify 不递归，每个子目录单独添加监听
+    int wd = inotify_add_watch(m_inotify_fd, dir.c_str(), WATCH_MASK);
+    if (wd == -1) {
+        LOG_WARN("StaticFileCache: inotify_add_watch %s failed: %s", dir.c_str(), strerror(errno));
+        return;
+    }
+    m_watch_dirs[wd] = dir;
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            add_watch_recursive(it->path().string());
+        }
+    }
+}
+
+void StaticFileCache::watch_loop() {
+    alignas(struct inotify_event) char buf[16 * 1024];
+    pollfd fds[2] = {{m_inotify_fd, POLLIN, 0}, {m_stop_fd, POLLIN, 0}};
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("StaticFileCache: poll error: %s", strerror(errno));
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        ssize_t len;
+        while ((len = read(m_inotify_fd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                const inotify_event* ev = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    // 事件丢失，无法确定哪些文件变化了
+                    LOG_WARN("StaticFileCache: inotify queue overflow, clearing cache");
+                    clear();
+                    continue;
+                }
+                auto dir = m_watch_dirs.find(ev->wd);
+                if (dir == m_watch_dirs.end()) {
+                    continue;
+                }
+                if (ev->mask & IN_IGNORED) {
+                    // 目录已被删除或移走，监听自动撤销
+                    m_watch_dirs.erase(dir);
+                    continue;
+                }
+
+                std::string dir_path = dir->second; // add_watch_recursive 可能使迭代器失效
+                std::string path = dir_path;
+                if (ev->len > 0) {
+                    path += '/';
+                    path += ev->name;
+                }
+                if ((ev->mask & (IN_CREATE | IN_MOVED_TO)) && (ev->mask & IN_ISDIR)) {
+                    add_watch_recursive(path);
+                }
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    // 新出现的文件可能改变无扩展名请求（/name -> /name.html）的解析结果
+                    invalidate(dir_path);
+                } else {
+                    invalidate(path);
+                }
+                LOG_DEBUG("StaticFileCache: invalidated %s (mask 0x%x)", path.c_str(), ev->mask);
+            }
+        }
+    }
+}
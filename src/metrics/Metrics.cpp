@@ -0,0 +1,263 @@
+#include "metrics/Metrics.h"
+#include <cstdio>
+
+const double METRICS_LATENCY_BOUNDS[] = {
+    0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+    0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+const size_t METRICS_LATENCY_BOUND_COUNT = sizeof(METRICS_LATENCY_BOUNDS) / sizeof(double);
+const double METRICS_COUNT_BOUNDS[] = {0, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+const size_t METRICS_COUNT_BOUND_COUNT = sizeof(METRICS_COUNT_BOUNDS) / sizeof(double);
+
+// 单独计数的状态码，其余归入最后一个槽位 "other"
+static const int STATUS_CODES[] = {
+    101, 200, 201, 204, 206, 301, 302, 304, 307, 308, 400, 401, 403, 404, 405, 408,
+    411, 413, 414, 416, 417, 429, 431, 500, 501, 502, 503, 504, 505};
+static const size_t STATUS_CODE_COUNT = sizeof(STATUS_CODES) / sizeof(int);
+static_assert(STATUS_CODE_COUNT < sizeof(MetricsShard::requests[0]) / sizeof(MetricCounter),
+              "status slots must leave room for \"other\"");
+static const size_t STATUS_OTHER = sizeof(MetricsShard::requests[0]) / sizeof(MetricCounter) - 1;
+
+void HistogramSnapshot::add(const Histogram& h)
+{
+    for (size_t i = 0; i < HIST_BUCKETS; ++i) {
+        uint64_t c = h.count(i);
+        counts[i] += c;
+        count += c;
+    }
+    sum += h.sum();
+}
+
+void MetricsWriter::family(const char* name, const char* help, const char* type)
+{
+    m_out += "# HELP ";
+    m_out += name;
+    m_out += ' ';
+    m_out += help;
+    m_out += "\n# TYPE ";
+    m_out += name;
+    m_out += ' ';
+    m_out += type;
+    m_out += '\n';
+}
+
+void MetricsWriter::sample(const char* name, const std::string& labels, uint64_t value)
+{
+    m_out += name;
+    if (!labels.empty()) {
+        m_out += '{';
+        m_out += labels;
+        m_out += '}';
+    }
+    m_out += ' ';
+    m_out += std::to_string(value);
+    m_out += '\n';
+}
+
+void MetricsWriter::sample(const char* name, const std::string& labels, double value)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    m_out += name;
+    if (!labels.empty()) {
+        m_out += '{';
+        m_out += labels;
+        m_out += '}';
+    }
+    m_out += ' ';
+    m_out += buf;
+    m_out += '\n';
+}
+
+void MetricsWriter::histogram(const char* name, const std::string& labels, const HistogramSnapshot& h,
+                              const double* bounds, size_t bound_count, double scale)
+{
+    std::string bucket_name = std::string(name) + "_bucket";
+    std::string prefix = labels.empty() ? std::string() : labels + ",";
+
+    // 桶的上界不超过 le 时计入该 le（跨越 le 的桶计入下一个 le，误差在桶宽以内）
+    size_t i = 0;
+    uint64_t cumulative = 0;
+    char le[32];
+    for (size_t b = 0; b < bound_count; ++b) {
+        while (i < HIST_BUCKETS && (double)(Histogram::bucket_upper(i) - 1) * scale <= bounds[b]) {
+            cumulative += h.counts[i++];
+        }
+        snprintf(le, sizeof(le), "%g", bounds[b]);
+        sample(bucket_name.c_str(), prefix + "le=\"" + le + "\"", cumulative);
+    }
+    sample(bucket_name.c_str(), prefix + "le=\"+Inf\"", h.count);
+    sample((std::string(name) + "_sum").c_str(), labels, (double)h.sum * scale);
+    sample((std::string(name) + "_count").c_str(), labels, h.count);
+}
+
+MetricsShard* Metrics::create_shard()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_shards.emplace_back(new MetricsShard());
+    return m_shards.back().get();
+}
+
+size_t Metrics::status_slot(int status)
+{
+    // 有序表上二分查找
+    size_t lo = 0, hi = STATUS_CODE_COUNT;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (STATUS_CODES[mid] < status) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < STATUS_CODE_COUNT && STATUS_CODES[lo] == status ? lo : STATUS_OTHER;
+}
+
+uint32_t Metrics::register_route(const std::string& label)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_routes.size() >= METRICS_MAX_ROUTES) {
+        m_routes.back() = "other";
+        return (uint32_t)(METRICS_MAX_ROUTES - 1);
+    }
+    m_routes.push_back(label);
+    return (uint32_t)(m_routes.size() - 1);
+}
+
+std::string Metrics::route_label(uint32_t route_id)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return route_id < m_routes.size() ? m_routes[route_id] : std::string("none");
+}
+
+uint64_t Metrics::reactor_queue_depth(int reactor)
+{
+    size_t slot = reactor_slot(reactor);
+    uint64_t posted = 0, run = 0;
+    std::lock_guard<std::mutex> lk(m_mutex);
+    for (auto& shard : m_shards) {
+        // 先读执行数再读投递数：并发更新时结果只会偏大，不会下溢
+        run += shard->reactor_run[slot].value();
+    }
+    for (auto& shard : m_shards) {
+        posted += shard->reactor_posted[slot].value();
+    }
+    return posted > run ? posted - run : 0;
+}
+
+size_t Metrics::add_collector(std::function<void(MetricsWriter&)> collector)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_collectors.push_back(std::move(collector));
+    return m_collectors.size() - 1;
+}
+
+void Metrics::remove_collector(size_t id)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (id < m_collectors.size()) {
+        m_collectors[id] = nullptr;
+    }
+}
+
+// 路由标签中的 \ 与 " 需要转义
+static std::string escape_label(const std::string& value)
+{
+    std::string out;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+std::string Metrics::render()
+{
+    std::string out;
+    out.reserve(16 * 1024);
+    MetricsWriter w(out);
+
+#ifdef WEBSERVER_BUILD_TYPE
+    w.family("webserver_build_info", "Build configuration of the running binary.", "gauge");
+    w.sample("webserver_build_info", "build_type=\"" WEBSERVER_BUILD_TYPE "\"", (uint64_t)1);
+#endif
+
+    std::vector<std::function<void(MetricsWriter&)>> collectors;
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+
+        // 1. 各分片求和
+        uint64_t accepts = 0, parse_errors = 0, bytes_in = 0, bytes_out = 0, frames_in = 0, frames_out = 0, ws_overload = 0;
+        std::vector<uint64_t> requests(METRICS_MAX_ROUTES * (STATUS_OTHER + 1), 0);
+        HistogramSnapshot task_wait, sql_wait, fanout;
+        for (auto& shard : m_shards) {
+            accepts += shard->accepts.value();
+            parse_errors += shard->parse_errors.value();
+            bytes_in += shard->bytes_in.value();
+            bytes_out += shard->bytes_out.value();
+            frames_in += shard->ws_frames_in.value();
+            frames_out += shard->ws_frames_out.value();
+            ws_overload += shard->ws_overload_closes.value();
+            for (size_t r = 0; r < m_routes.size(); ++r) {
+                for (size_t s = 0; s <= STATUS_OTHER; ++s) {
+                    requests[r * (STATUS_OTHER + 1) + s] += shard->requests[r][s].value();
+                }
+            }
+            task_wait.add(shard->task_wait_ns);
+            sql_wait.add(shard->sql_wait_ns);
+            fanout.add(shard->ws_fanout);
+        }
+
+        // 2. 输出
+        w.family("webserver_accepted_connections_total", "Accepted TCP connections.", "counter");
+        w.sample("webserver_accepted_connections_total", "", accepts);
+
+        w.family("webserver_http_requests_total", "HTTP responses by route and status code.", "counter");
+        for (size_t r = 0; r < m_routes.size(); ++r) {
+            std::string route = "route=\"" + escape_label(m_routes[r]) + "\",code=\"";
+            for (size_t s = 0; s <= STATUS_OTHER; ++s) {
+                uint64_t value = requests[r * (STATUS_OTHER + 1) + s];
+                if (value == 0) {
+                    continue;
+                }
+                std::string code = s == STATUS_OTHER ? "other" : std::to_string(STATUS_CODES[s]);
+                w.sample("webserver_http_requests_total", route + code + "\"", value);
+            }
+        }
+
+        w.family("webserver_http_parse_errors_total", "Malformed HTTP requests.", "counter");
+        w.sample("webserver_http_parse_errors_total", "", parse_errors);
+        w.family("webserver_http_received_bytes_total", "Bytes read from HTTP connections.", "counter");
+        w.sample("webserver_http_received_bytes_total", "", bytes_in);
+        w.family("webserver_http_sent_bytes_total", "Bytes written to HTTP connections.", "counter");
+        w.sample("webserver_http_sent_bytes_total", "", bytes_out);
+
+        w.family("webserver_threadpool_task_wait_seconds", "Time tasks spend queued in the worker pool.", "histogram");
+        w.histogram("webserver_threadpool_task_wait_seconds", "", task_wait,
+                    METRICS_LATENCY_BOUNDS, METRICS_LATENCY_BOUND_COUNT, 1e-9);
+        w.family("webserver_sql_pool_wait_seconds", "Time spent waiting for a MySQL connection.", "histogram");
+        w.histogram("webserver_sql_pool_wait_seconds", "", sql_wait,
+                    METRICS_LATENCY_BOUNDS, METRICS_LATENCY_BOUND_COUNT, 1e-9);
+
+        w.family("webserver_websocket_frames_received_total", "WebSocket frames received.", "counter");
+        w.sample("webserver_websocket_frames_received_total", "", frames_in);
+        w.family("webserver_websocket_frames_sent_total", "WebSocket frames queued for sending.", "counter");
+        w.sample("webserver_websocket_frames_sent_total", "", frames_out);
+        w.family("webserver_websocket_overload_closes_total", "WebSocket connections closed with 1013 because the worker pool was full.", "counter");
+        w.sample("webserver_websocket_overload_closes_total", "", ws_overload);
+        w.family("webserver_websocket_broadcast_fanout", "Recipients per room broadcast.", "histogram");
+        w.histogram("webserver_websocket_broadcast_fanout", "", fanout,
+                    METRICS_COUNT_BOUNDS, METRICS_COUNT_BOUND_COUNT, 1.0);
+
+        collectors = m_collectors;
+    }
+
+    // 3. 各组件的状态（不持有 m_mutex，收集函数可以调用 reactor_queue_depth 等接口）
+    for (auto& collect : collectors) {
+        if (collect) {
+            collect(w);
+        }
+    }
+    return out;
+}
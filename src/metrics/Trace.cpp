@@ -0,0 +1,254 @@
+#include "metrics/Trace.h"
+#include "metrics/Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(TRACE_RING_SIZE && (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+static const size_t TRACE_POINTS = (size_t)TracePoint::Count;
+
+// 以某个时间点结束的阶段名：阶段从之前最近一个经过的时间点开始
+static const char* const PHASE_NAMES[TRACE_POINTS] = {
+    nullptr, "accept", "read", "route", "queue", "handler", "serialize", "hop", "write"};
+
+static const char* const METHOD_NAMES[] = {"GET", "POST", "HEAD", "UNKNOWN"};
+
+static const char* method_name(uint8_t method) {
+    return method < sizeof(METHOD_NAMES) / sizeof(METHOD_NAMES[0]) ? METHOD_NAMES[method] : "UNKNOWN";
+}
+
+// 阶段 p 的开始时间点，没有则返回 TRACE_POINTS
+static size_t phase_start(const TraceRecord& r, size_t p) {
+    if (r.t[p] == 0) {
+        return TRACE_POINTS;
+    }
+    for (size_t q = p; q-- > 0;) {
+        if (r.t[q] != 0) {
+            return q;
+        }
+    }
+    return TRACE_POINTS;
+}
+
+// handler 与序列化响应在执行 handler 的线程上（Pool 路由为工作线程）
+static bool on_worker(size_t p) {
+    return p == (size_t)TracePoint::HandlerEnd || p == (size_t)TracePoint::Queued;
+}
+
+bool Trace::sample() {
+    uint32_t every = sample_rate();
+    if (every == 0) {
+        return false;
+    }
+    thread_local uint32_t count = 0;
+    if (++count < every) {
+        return false;
+    }
+    count = 0;
+    return true;
+}
+
+uint32_t Trace::thread_id() {
+    thread_local uint32_t tid = (uint32_t)syscall(SYS_gettid);
+    return tid;
+}
+
+void Trace::commit(const TraceRecord& record) {
+    uint64_t words[WORDS] = {};
+    memcpy(words, &record, sizeof(record));
+
+    Slot& slot = m_slots[m_next.fetch_add(1, std::memory_order_relaxed) & (TRACE_RING_SIZE - 1)];
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_relaxed)) {
+        return; // 另一个写者正在写这个槽位（环形缓冲区已绕回一圈），丢弃
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+void Trace::snapshot(std::vector<TraceRecord>& out, size_t limit) const {
+    uint64_t next = m_next.load(std::memory_order_acquire);
+    size_t n = (size_t)std::min<uint64_t>({next, (uint64_t)TRACE_RING_SIZE, (uint64_t)limit});
+    out.clear();
+    out.reserve(n);
+    uint64_t words[WORDS];
+    for (size_t k = 1; k <= n; ++k) {
+        const Slot& slot = m_slots[(next - k) & (TRACE_RING_SIZE - 1)];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq == 0 || (seq & 1)) {
+            continue;
+        }
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            continue; // 拷贝期间被覆盖
+        }
+        TraceRecord record;
+        memcpy(&record, words, sizeof(record));
+        record.path[TRACE_PATH_MAX - 1] = '\0';
+        out.push_back(record);
+    }
+}
+
+static void append_us(std::string& out, uint64_t ns) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f", ns / 1000.0);
+    out += buf;
+}
+
+std::string Trace::render_text(size_t limit) const {
+    std::vector<TraceRecord> records;
+    snapshot(records, TRACE_RING_SIZE);
+
+    std::string out;
+    char line[256];
+    snprintf(line, sizeof(line), "# sample 1/%u, %zu records, durations in microseconds\n",
+             sample_rate(), records.size());
+    out += line;
+
+    // 1. 各阶段耗时的分位数（保留的全部记录）
+    out += "# phase         count       p50       p90       p99       max\n";
+    std::vector<uint64_t> values;
+    auto quantiles = [&](const char* name) {
+        if (values.empty()) {
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        auto at = [&](double q) { return values[std::min(values.size() - 1, (size_t)(q * values.size()))]; };
+        snprintf(line, sizeof(line), "%-12s %8zu %9.1f %9.1f %9.1f %9.1f\n", name, values.size(),
+                 at(0.5) / 1000.0, at(0.9) / 1000.0, at(0.99) / 1000.0, values.back() / 1000.0);
+        out += line;
+    };
+    for (size_t p = 1; p < TRACE_POINTS; ++p) {
+        values.clear();
+        for (const auto& r : records) {
+            size_t q = phase_start(r, p);
+            if (q != TRACE_POINTS) {
+                values.push_back(r.t[p] - r.t[q]);
+            }
+        }
+        quantiles(PHASE_NAMES[p]);
+    }
+    values.clear();
+    for (const auto& r : records) {
+        if (r.t[(size_t)TracePoint::Read] && r.t[(size_t)TracePoint::Flushed]) {
+            values.push_back(r.t[(size_t)TracePoint::Flushed] - r.t[(size_t)TracePoint::Read]);
+        }
+    }
+    quantiles("total");
+
+    // 2. 最近的记录：read 到 write 之间各阶段，未经过的阶段为 -
+    out += "#\n# recent: status method path route total";
+    for (size_t p = 1; p < TRACE_POINTS; ++p) {
+        out += ' ';
+        out += PHASE_NAMES[p];
+    }
+    out += '\n';
+    Metrics& metrics = Metrics::get_instance();
+    for (size_t i = 0; i < records.size() && i < limit; ++i) {
+        const TraceRecord& r = records[i];
+        uint64_t total = r.t[(size_t)TracePoint::Flushed] && r.t[(size_t)TracePoint::Read]
+                             ? r.t[(size_t)TracePoint::Flushed] - r.t[(size_t)TracePoint::Read] : 0;
+        snprintf(line, sizeof(line), "%u %s %s [%s] ", r.status, method_name(r.method),
+                 r.path[0] ? r.path : "-", metrics.route_label(r.route_id).c_str());
+        out += line;
+        append_us(out, total);
+        for (size_t p = 1; p < TRACE_POINTS; ++p) {
+            out += ' ';
+            size_t q = phase_start(r, p);
+            if (q == TRACE_POINTS) {
+                out += '-';
+            } else {
+                append_us(out, r.t[p] - r.t[q]);
+            }
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+static void append_json_string(std::string& out, const char* s) {
+    out += '"';
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += (char)c;
+        }
+    }
+    out += '"';
+}
+
+// 一个完整事件（ph = "X"），时间单位为微秒
+static void append_event(std::string& out, const char* name, uint32_t tid, uint64_t start_ns, uint64_t dur_ns) {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"cat\":\"http\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+             "\"ts\":%.3f,\"dur\":%.3f}", name, (int)getpid(), tid, start_ns / 1000.0, dur_ns / 1000.0);
+    out += buf;
+}
+
+std::string Trace::render_chrome(size_t limit) const {
+    std::vector<TraceRecord> records;
+    snapshot(records, limit);
+
+    Metrics& metrics = Metrics::get_instance();
+    std::string out;
+    out.reserve(records.size() * 1024 + 64);
+    out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char buf[96];
+    for (auto it = records.rbegin(); it != records.rend(); ++it) {
+        const TraceRecord& r = *it;
+        size_t begin = r.t[(size_t)TracePoint::Accept] ? (size_t)TracePoint::Accept : (size_t)TracePoint::Read;
+        uint64_t end = 0;
+        for (size_t p = 0; p < TRACE_POINTS; ++p) {
+            end = std::max(end, r.t[p]);
+        }
+        if (r.t[begin] == 0 || end < r.t[begin]) {
+            continue;
+        }
+
+        // 整个请求（位于 SubReactor 线程），args 中带上请求信息
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        append_event(out, "request", r.reactor_tid, r.t[begin], end - r.t[begin]);
+        out.pop_back();
+        out += ",\"args\":{\"method\":\"";
+        out += method_name(r.method);
+        out += "\",\"path\":";
+        append_json_string(out, r.path);
+        out += ",\"route\":";
+        append_json_string(out, metrics.route_label(r.route_id).c_str());
+        snprintf(buf, sizeof(buf), ",\"status\":%u,\"fd\":%d}}", r.status, r.fd);
+        out += buf;
+
+        // 各阶段：handler/serialize 位于执行 handler 的线程，其余位于 SubReactor 线程
+        for (size_t p = 1; p < TRACE_POINTS; ++p) {
+            size_t q = phase_start(r, p);
+            if (q == TRACE_POINTS) {
+                continue;
+            }
+            uint32_t tid = on_worker(p) && r.worker_tid ? r.worker_tid : r.reactor_tid;
+            out += ',';
+            append_event(out, PHASE_NAMES[p], tid, r.t[q], r.t[p] - r.t[q]);
+        }
+    }
+    out += "]}\n";
+    return out;
+}
@@ -1,18 +1,23 @@
 #include "webserver/SubReactor.h"
 #include <string.h> // for bzero
+#include <sys/socket.h> // for accept4
 
 int MAX_FD = 65536;
 
 SubReactor::SubReactor()
-    : m_epollfd(-1), m_timeout_sec(15), m_pool(nullptr),
+    : m_id(0), m_epollfd(-1), m_listenfd(-1), m_timerfd(-1), m_timer_armed(UINT64_MAX), m_pool(nullptr),
       m_connPool(nullptr), m_router(nullptr), m_context(nullptr),
-      m_stop_server(nullptr),m_wakeup_fd(-1) // 新增：初始化 m_wakeup_fd
+      m_stop_server(nullptr),m_wakeup_fd(-1), // 新增：初始化 m_wakeup_fd
+      m_task_queue(SUB_TASK_NODE_NUMBER), m_wakeup_pending(false)
 {
     m_pipefd[0] = -1;
     m_pipefd[1] = -1;
     m_connections.resize(MAX_FD + 1);
     m_ws_connections.resize(MAX_FD + 1);
     m_client_data.resize(MAX_FD + 1);
+    for (auto &count : m_timeout_closes) {
+        count.store(0, std::memory_order_relaxed);
+    }
 }
 
 SubReactor::~SubReactor()
@@ -34,28 +39,33 @@ SubReactor::~SubReactor()
     {
         close(m_wakeup_fd);
     }
+    if (m_timerfd != -1)
+    {
+        close(m_timerfd);
+    }
+    if (m_listenfd != -1)
+    {
+        close(m_listenfd);
+    }
 
     // 清理所有剩余的连接和定时器
     m_connections.clear();
     m_ws_connections.clear();
     
     for (auto& client : m_client_data) {
-        if (client.timer && !client.timer_deleted) {
-            client.timer_deleted = true;
-            m_timer_manager.del_timer(client.timer);
-            client.timer = nullptr;
-        }
+        m_timer_manager.del_timer(&client.timer);
     }
 }
 
 void SubReactor::init(ThreadPool *pool, SqlConnectionPool *connPool, Router *router,
-                      RequestContext *context, int timeout_sec, std::atomic<bool> *stop_flag)
+                      RequestContext *context, const ConnTimeouts &timeouts, std::atomic<bool> *stop_flag, int id)
 {
+    m_id = id;
     m_pool = pool;
     m_connPool = connPool;
     m_router = router;
     m_context = context;
-    m_timeout_sec = timeout_sec;
+    m_timeouts = timeouts;
     m_stop_server = stop_flag;
 
     // 设置 WebSocket 服务器上下文（单例模式）
@@ -88,15 +98,27 @@ void SubReactor::init(ThreadPool *pool, SqlConnectionPool *connPool, Router *rou
         exit(EXIT_FAILURE);
     }
     Tools::addfd(m_epollfd, m_wakeup_fd, false, 0); // 使用 LT 模式监听
+
+    // 5. 创建驱动时间轮的 timerfd，按需设置到下一个到期时刻
+    m_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_timerfd < 0) {
+        LOG_ERROR("Failed to create timerfd");
+        std::cerr << "Failed to create timerfd" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    Tools::addfd(m_epollfd, m_timerfd, false, 0); // LT 模式
 }
 
-void SubReactor::addTask(std::function<void()> task)
+void SubReactor::addTask(Task task)
 {
-    {
-        std::lock_guard<std::mutex> lock(m_task_mutex);
-        m_task_queue.push(std::move(task));
+    m_task_queue.push(std::move(task));
+    Metrics::reactor_posted(m_id);
+
+    // 只有 空→非空 的转换才写 eventfd，其余生产者搭便车，由同一次唤醒统一处理
+    if (m_wakeup_pending.exchange(true, std::memory_order_acq_rel)) {
+        return;
     }
-    
+
     // 唤醒 SubReactor 线程
     uint64_t one = 1;
     ssize_t n = write(m_wakeup_fd, &one, sizeof(one));
@@ -113,18 +135,18 @@ void SubReactor::handle_wakeup()
         LOG_ERROR("read from m_wakeup_fd error");
     }
 
-    std::queue<std::function<void()>> tasks;
-    {
-        std::lock_guard<std::mutex> lock(m_task_mutex);
-        tasks.swap(m_task_queue); // 高效交换，减少锁的持有时间
-    }
+    // 先清除标志再取任务：之后入队的生产者会重新写 eventfd，
+    // 正在链接中的生产者也会在完成后看到标志为 false 而再次唤醒，不会丢任务
+    m_wakeup_pending.exchange(false, std::memory_order_acq_rel);
 
-    while (!tasks.empty())
+    Task task;
+    uint64_t run = 0;
+    while (m_task_queue.pop(task))
     {
-        std::function<void()> task = tasks.front();
-        tasks.pop();
         task(); // 在 SubReactor 线程中执行任务
+        ++run;
     }
+    Metrics::reactor_run(m_id, run);
 }
 
 int SubReactor::getPipeFd() const
@@ -133,6 +155,133 @@ int SubReactor::getPipeFd() const
     return m_pipefd[1];
 }
 
+bool SubReactor::listenReusePort(int port)
+{
+    m_listenfd = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenfd < 0)
+    {
+        perror("SubReactor socket error");
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(m_listenfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    // 同一端口上的每个监听套接字都设置 SO_REUSEPORT，由内核在它们之间分发新连接
+    if (setsockopt(m_listenfd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) == -1)
+    {
+        perror("SubReactor setsockopt SO_REUSEPORT error");
+        close(m_listenfd);
+        m_listenfd = -1;
+        return false;
+    }
+
+    sockaddr_in address;
+    bzero(&address, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(m_listenfd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        listen(m_listenfd, SOMAXCONN) < 0)
+    {
+        perror("SubReactor bind/listen error");
+        close(m_listenfd);
+        m_listenfd = -1;
+        return false;
+    }
+
+    // 监听套接字使用 LT 模式，与主 Reactor 的处理方式保持一致
+    Tools::addfd(m_epollfd, m_listenfd, false, 0);
+    return true;
+}
+
+int SubReactor::getListenFd() const
+{
+    return m_listenfd;
+}
+
+void SubReactor::handle_accept()
+{
+    while (true) // LT模式，循环 accept 直到队列为空
+    {
+        sockaddr_in client_addr;
+        socklen_t len = sizeof(client_addr);
+        int connfd = accept4(m_listenfd, (sockaddr *)&client_addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (connfd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                LOG_ERROR("SubReactor: accept4 error: %s", strerror(errno));
+            }
+            break;
+        }
+        if (connfd > MAX_FD)
+        {
+            LOG_ERROR("SubReactor: fd %d exceeds MAX_FD, closing", connfd);
+            close(connfd);
+            continue;
+        }
+        handle_new_connection(connfd, client_addr);
+    }
+}
+
+void SubReactor::handle_http_read(int sockfd, const std::shared_ptr<ManagedConnection> &conn)
+{
+    handle_http_action(sockfd, conn, conn->get()->handle_read());
+}
+
+void SubReactor::handle_http_action(int sockfd, const std::shared_ptr<ManagedConnection> &conn, Action action)
+{
+    if (action == Action::Process)
+    {
+        update_timeout(sockfd, conn->get(), action);
+        // 会阻塞的 handler：派发到工作线程池，完成后回到本 Reactor 线程发送响应
+        bool queued = m_pool->append([conn, this, sockfd]() {
+            Action action = conn->get()->process_request();
+            this->addTask([conn, this, sockfd, action]() {
+                // 等待期间连接可能已超时关闭，fd 甚至已被新连接复用
+                if (m_connections[sockfd] != conn)
+                    return;
+                conn->get()->trace_returned();
+                if (action == Action::Write)
+                    handle_http_write(sockfd, conn);
+                else
+                    handle_action(sockfd, action);
+            });
+        });
+        if (!queued)
+        {
+            // 工作线程池过载：不排队等待，直接返回 503 卸载负载
+            LOG_WARN("SubReactor: ThreadPool overloaded, shedding fd=%d with 503", sockfd);
+            conn->get()->reject_overloaded();
+            handle_http_write(sockfd, conn);
+        }
+        return;
+    }
+
+    if (action == Action::Write)
+    {
+        // 响应已就绪，直接尝试发送，省去一次 EPOLLOUT 往返
+        handle_http_write(sockfd, conn);
+        return;
+    }
+    update_timeout(sockfd, conn->get(), action);
+    handle_action(sockfd, action);
+}
+
+void SubReactor::handle_http_write(int sockfd, const std::shared_ptr<ManagedConnection> &conn)
+{
+    Action action = conn->get()->handle_write();
+    if (action == Action::Process)
+    {
+        // 发送完毕后继续处理管线化请求时遇到了需要派发到线程池的路由
+        handle_http_action(sockfd, conn, action);
+        return;
+    }
+    update_timeout(sockfd, conn->get(), action);
+    handle_action(sockfd, action);
+}
+
 void SubReactor::handle_action(int connfd, Action action)
 {
     // 判断是 WebSocket 还是 HTTP 连接
@@ -191,35 +340,133 @@ void SubReactor::handle_action(int connfd, Action action)
     }
 }
 
-void SubReactor::handle_new_connection(int connfd)
+void SubReactor::handle_new_connection(int connfd, const sockaddr_in &client_addr)
 {
     // 1. 将新连接添加到本 Reactor 的 epoll (ET, ONESHOT)
     Tools::addfd(m_epollfd, connfd, true, 1);
     LOG_INFO("SubReactor: New client connected: %d", connfd);
+    Metrics::local().accepts.add();
 
     // 2. 创建 HTTP 连接对象
-    // httpconnection 构造函数需要 sockaddr_in 参数，但实际上没有使用这个参数，所以传入一个空的 sockaddr_in
-    sockaddr_in client_addr;
-    bzero(&client_addr, sizeof(client_addr));
     m_connections[connfd] = std::make_shared<ManagedConnection>(connfd, client_addr, m_router, m_context);
 
-    // 3. 创建定时器回调函数，回调函数在m_timer_manager.tick()时被调用，所以与连接关闭是同步的
+    // 3. 创建定时器回调函数，回调函数在 timerfd 到期后的 m_timer_manager.tick() 中被调用，所以与连接关闭是同步的
     std::function<void(client_data *)> timeout_cb = [this](client_data *user_data)
     {
-        if (user_data && user_data->sockfd >= 0 && !user_data->timer_deleted)
-        {
-            this->addTask([this, sockfd = user_data->sockfd]() {
-                LOG_DEBUG("SubReactor: Connection timeout, scheduling close action for fd=%d", sockfd);
-                if (m_connections[sockfd]) {
-                    // 调用标准的关闭流程
-                    handle_action(sockfd, Action::Close);
-                }
-            });
-        }
+        handle_timeout(user_data);
     };
 
-    // 4. 初始化并添加定时器
-    Tools::init_timer(m_timer_manager, &m_client_data[connfd], connfd, client_addr, m_timeout_sec, timeout_cb);
+    // 4. 初始化并添加定时器：第一个请求的请求头从建立连接起计时
+    client_data &cd = m_client_data[connfd];
+    cd.phase = ConnPhase::Header;
+    cd.phase_start = TimerManager::now_ms();
+    cd.phase_bytes = 0;
+    cd.phase_request = 0;
+    Tools::init_timer(m_timer_manager, &cd, connfd, client_addr, m_timeouts.header_ms, timeout_cb);
+    if (cd.timer.expire < m_timer_armed) {
+        rearm_timer(); // 比 timerfd 当前的到期时刻更早
+    }
+}
+
+void SubReactor::update_timeout(int sockfd, HttpConnection *conn, Action action)
+{
+    if (action == Action::Close || action == Action::Upgrade) {
+        return;
+    }
+    client_data &cd = m_client_data[sockfd];
+    ConnPhase phase = action == Action::Process ? ConnPhase::Busy : conn->phase();
+    uint64_t now = TimerManager::now_ms();
+    if (phase != cd.phase || conn->requests() != cd.phase_request) {
+        cd.phase = phase;
+        cd.phase_start = now;
+        cd.phase_bytes = phase == ConnPhase::Write ? conn->bytes_sent() : conn->bytes_read();
+        cd.phase_request = conn->requests();
+    }
+
+    uint64_t deadline = 0;
+    switch (phase) {
+    case ConnPhase::Busy:
+        // handler 执行时间不计入超时，完成后按新的阶段重新加入
+        Tools::del_timer(m_timer_manager, &cd);
+        return;
+    case ConnPhase::Idle:
+        deadline = now + m_timeouts.idle_ms;
+        break;
+    case ConnPhase::Header:
+        deadline = cd.phase_start + m_timeouts.header_ms;
+        break;
+    case ConnPhase::Body:
+        if (m_timeouts.body_min_rate > 0) {
+            // 每收到 body_min_rate 字节多给 1 秒，低于最低速率的上传最终会超时
+            uint64_t received = conn->bytes_read() - cd.phase_bytes;
+            deadline = cd.phase_start + m_timeouts.body_ms + received * 1000 / m_timeouts.body_min_rate;
+        } else {
+            deadline = now + m_timeouts.body_ms;
+        }
+        break;
+    case ConnPhase::Write:
+        if (conn->bytes_sent() != cd.phase_bytes) {
+            // 有发送进展，重新计时
+            cd.phase_start = now;
+            cd.phase_bytes = conn->bytes_sent();
+        }
+        deadline = cd.phase_start + m_timeouts.write_ms;
+        break;
+    default:
+        return;
+    }
+
+    Tools::adjust_timer(m_timer_manager, &cd, deadline);
+    if (cd.timer.expire < m_timer_armed) {
+        rearm_timer();
+    }
+}
+
+void SubReactor::handle_timeout(client_data *cd)
+{
+    int sockfd = cd->sockfd;
+    if (sockfd < 0 || !m_connections[sockfd]) {
+        return;
+    }
+    static const char *const names[] = {"idle", "header", "body", "write", "busy"};
+    m_timeout_closes[(size_t)cd->phase].fetch_add(1, std::memory_order_relaxed);
+    LOG_INFO("SubReactor: %s timeout, closing fd=%d", names[(size_t)cd->phase], sockfd);
+    // 调用标准的关闭流程（在本 Reactor 线程的 tick 中，与其它事件处理不会并发）
+    handle_action(sockfd, Action::Close);
+}
+
+uint64_t SubReactor::getTimeoutCloses(ConnPhase phase) const
+{
+    return m_timeout_closes[(size_t)phase].load(std::memory_order_relaxed);
+}
+
+void SubReactor::handle_timer()
+{
+    uint64_t expirations;
+    ssize_t n = read(m_timerfd, &expirations, sizeof(expirations)); // 清空 timerfd 计数
+    (void)n;
+    m_timer_armed = UINT64_MAX;
+    m_timer_manager.tick();
+    rearm_timer();
+}
+
+void SubReactor::rearm_timer()
+{
+    uint64_t next = m_timer_manager.next_expire();
+    if (next == m_timer_armed) {
+        return;
+    }
+    itimerspec spec{};
+    if (next != UINT64_MAX) {
+        // 全 0 表示停止计时，到期时刻至少取 1ns
+        spec.it_value.tv_sec = next / 1000;
+        spec.it_value.tv_nsec = (long)(next % 1000) * 1000000 + 1;
+    }
+    if (timerfd_settime(m_timerfd, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        LOG_ERROR("SubReactor: timerfd_settime failed: %s", strerror(errno));
+        return;
+    }
+    m_timer_armed = next;
 }
 
 void SubReactor::eventLoop()
@@ -232,6 +479,7 @@ void SubReactor::eventLoop()
             LOG_ERROR("SubReactor: epoll failure");
             break;
         }
+        uint64_t loop_start = Metrics::now_ns();
 
         for (int i = 0; i < num; ++i)
         {
@@ -254,8 +502,12 @@ void SubReactor::eventLoop()
                     int msg = msg_buf[j];
                     if (msg >= 0)
                     {
-                        // 新连接
-                        handle_new_connection(msg);
+                        // 新连接（主 Reactor 不传递地址，用 getpeername 取回，管理接口按对端地址限制访问）
+                        sockaddr_in client_addr;
+                        socklen_t len = sizeof(client_addr);
+                        if (getpeername(msg, (sockaddr *)&client_addr, &len) != 0)
+                            bzero(&client_addr, sizeof(client_addr));
+                        handle_new_connection(msg, client_addr);
                     }
                     else if (msg == -1)
                     {
@@ -264,28 +516,32 @@ void SubReactor::eventLoop()
                         LOG_INFO("SubReactor: Received STOP signal.");
                         break; // 跳出 for 循环，外层 while 会检测到 stop
                     }
-                    else if (msg == -2)
-                    {
-                        // 定时器 Tick 信号
-                        m_timer_manager.tick();
-                        // LOG_DEBUG("SubReactor: Timer tick executed");
-                    }
                 }
                 if (*m_stop_server) break; // 跳出外层 for 循环
             }
-            // 2. 新增：处理来自工作线程的唤醒事件
+            // 2. SO_REUSEPORT 模式：本 Reactor 直接接收新连接
+            else if (sockfd == m_listenfd)
+            {
+                handle_accept();
+            }
+            // 3. 新增：处理来自工作线程的唤醒事件
             else if (sockfd == m_wakeup_fd)
             {
                 handle_wakeup();
             }
-            // 3. 处理连接错误
+            // 3.1 本 Reactor 的 timerfd 到期：处理超时连接
+            else if (sockfd == m_timerfd)
+            {
+                handle_timer();
+            }
+            // 4. 处理连接错误
             else if (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
             {
                 this->addTask([this, sockfd]() {
                     handle_action(sockfd, Action::Close);
                 });
             }
-            // 4. 处理读事件 (EPOLLIN)
+            // 5. 处理读事件 (EPOLLIN)
             else if (events[i].events & EPOLLIN)
             {
                 LOG_DEBUG("SubReactor: EPOLLIN event on fd %d", sockfd);
@@ -301,12 +557,18 @@ void SubReactor::eventLoop()
                     }
                     if (ws_conn) {
                         // 派发任务到工作线程池
-                        m_pool->append([ws_conn, this, sockfd]() {
+                        bool queued = m_pool->append([ws_conn, this, sockfd]() {
                             Action action = ws_conn->handle_read();
                             this->addTask([this, sockfd, action]() {
                                 handle_action(sockfd, action);
                             });
                         });
+                        if (!queued) {
+                            // 线程池过载：重新注册事件会让 epoll 立即再次报告该 fd，Reactor 空转；
+                            // 与 HTTP 的 503 一样卸载负载，发送 1013 关闭帧后关闭连接
+                            LOG_WARN("SubReactor: ThreadPool overloaded, closing WebSocket fd=%d with 1013", sockfd);
+                            handle_action(sockfd, ws_conn->reject_overloaded());
+                        }
                     }
                 } else {
                     // HTTP 连接
@@ -317,19 +579,12 @@ void SubReactor::eventLoop()
                         }
                     }
                     if (conn_shared) {
-                        // 更新定时器
-                        Tools::adjust_timer(m_timer_manager, &m_client_data[sockfd], m_timeout_sec);
-                        // 派发任务到工作线程池
-                        m_pool->append([conn_shared, this, sockfd]() {
-                            Action action = conn_shared->get()->handle_read();
-                            this->addTask([this, sockfd, action]() {
-                                handle_action(sockfd, action);
-                            });
-                        });
+                        // 定时器在处理完毕后按连接所处的阶段更新
+                        handle_http_read(sockfd, conn_shared);
                     }
                 }
             }
-            // 5. 处理写事件 (EPOLLOUT)
+            // 6. 处理写事件 (EPOLLOUT)
             else if (events[i].events & EPOLLOUT)
             {
                 LOG_DEBUG("SubReactor: EPOLLOUT event on fd %d", sockfd);
@@ -345,12 +600,18 @@ void SubReactor::eventLoop()
                     }
                     if (ws_conn) {
                         // 派发任务到工作线程池
-                        m_pool->append([ws_conn, this, sockfd]() {
+                        bool queued = m_pool->append([ws_conn, this, sockfd]() {
                             Action action = ws_conn->handle_write();
                             this->addTask([this, sockfd, action]() {
                                 handle_action(sockfd, action);
                             });
                         });
+                        if (!queued) {
+                            // 线程池过载：重新注册事件会让 epoll 立即再次报告该 fd，Reactor 空转；
+                            // 与 HTTP 的 503 一样卸载负载，发送 1013 关闭帧后关闭连接
+                            LOG_WARN("SubReactor: ThreadPool overloaded, closing WebSocket fd=%d with 1013", sockfd);
+                            handle_action(sockfd, ws_conn->reject_overloaded());
+                        }
                     }
                 } else {
                     // HTTP 连接
@@ -361,19 +622,12 @@ void SubReactor::eventLoop()
                         }
                     }
                     if (conn_shared) {
-                        // 更新定时器
-                        Tools::adjust_timer(m_timer_manager, &m_client_data[sockfd], m_timeout_sec);
-                        // 派发任务到工作线程池
-                        m_pool->append([conn_shared, this, sockfd]() {
-                            Action action = conn_shared->get()->handle_write();
-                            this->addTask([this, sockfd, action]() {
-                                handle_action(sockfd, action);
-                            });
-                        });
+                        handle_http_write(sockfd, conn_shared);
                     }
                 }
             }
         } 
+        m_loop_hist.record(Metrics::now_ns() - loop_start);
     } 
 
     LOG_INFO("SubReactor shutting down...");
@@ -1,15 +1,21 @@
 #include "webserver/WebServer.h"
 #include "handler/Handler.h"
 #include "http/HttpConnectionPool.h"
+#include "http/BufferPool.h"
+#include "http/HttpClock.h"
+#include <algorithm>
 #include <thread>
+#include <pthread.h>
+#include <sys/timerfd.h>
 
 WebServer::WebServer()
     : m_port(0), m_root(nullptr), m_close_log(0),
-      m_epollfd(-1), m_listenfd(-1),
+      m_epollfd(-1), m_listenfd(-1), m_clockfd(-1),
       m_connPool(nullptr),
       m_databaseURL(""), m_user(""), m_passWord(""), m_databaseName(""), m_sql_num(0),
-      m_pool(nullptr), m_thread_num(0), m_timeout_sec(15),
-      m_sub_reactor_num(0), m_round_robin_counter(0) // 初始化新成员
+      m_pool(nullptr), m_thread_num(0),
+      m_sub_reactor_num(0), m_round_robin_counter(0), m_reuse_port(0), // 初始化新成员
+      m_metrics_collector((size_t)-1)
 {}
 
 WebServer::~WebServer()
@@ -33,7 +39,24 @@ WebServer::~WebServer()
         }
     }
 
-    // 4. 删除 SubReactor 实例
+    // 4. 汇总各阶段的超时关闭次数，删除 SubReactor 实例（先移除引用它们的指标收集函数）
+    if (m_metrics_collector != (size_t)-1) {
+        Metrics::get_instance().remove_collector(m_metrics_collector);
+        m_metrics_collector = (size_t)-1;
+    }
+    uint64_t timeout_closes[(size_t)ConnPhase::Count] = {};
+    for (auto* sub : m_sub_reactors) {
+        if (sub) {
+            for (size_t i = 0; i < (size_t)ConnPhase::Count; ++i) {
+                timeout_closes[i] += sub->getTimeoutCloses((ConnPhase)i);
+            }
+        }
+    }
+    LOG_INFO("Timeout closes: header=%llu body=%llu idle=%llu write=%llu",
+             (unsigned long long)timeout_closes[(size_t)ConnPhase::Header],
+             (unsigned long long)timeout_closes[(size_t)ConnPhase::Body],
+             (unsigned long long)timeout_closes[(size_t)ConnPhase::Idle],
+             (unsigned long long)timeout_closes[(size_t)ConnPhase::Write]);
     for (auto* sub : m_sub_reactors) {
         delete sub;
     }
@@ -57,6 +80,10 @@ WebServer::~WebServer()
         close(m_pipefd[0]);
         m_pipefd[0] = -1;
     }
+    if (m_clockfd != -1) {
+        close(m_clockfd);
+        m_clockfd = -1;
+    }
     
     // 6. 销毁共享的工作线程池
     if (m_pool)
@@ -80,7 +107,8 @@ WebServer::~WebServer()
 }
 
 void WebServer::init(int port, string databaseURL, string user, string passWord, string databaseName,
-                     int sql_num,int thread_num, int close_log, int timeout_sec)
+                     int sql_num,int thread_num, int close_log, int reuse_port, int file_cache_mb,
+                     const ConnTimeouts &timeouts, int admin_trace)
 {
     m_port = port;
     m_databaseURL = databaseURL;
@@ -90,11 +118,12 @@ void WebServer::init(int port, string databaseURL, string user, string passWord,
     m_sql_num = sql_num;
     m_thread_num = thread_num; // 这是 *工作* 线程池的线程数
     m_close_log = close_log;
-    m_timeout_sec = timeout_sec;
+    m_timeouts = timeouts;
     m_pipefd[0] = -1;
     m_pipefd[1] = -1;
     stop_server = false;
     m_round_robin_counter = 0;
+    m_reuse_port = reuse_port;
 
     // 1. 初始化数据库连接池 (共享)
     m_connPool = SqlConnectionPool::GetInstance();
@@ -104,7 +133,7 @@ void WebServer::init(int port, string databaseURL, string user, string passWord,
     m_pool = new ThreadPool(m_thread_num, 10000);
 
     // 3. 初始化日志
-    Log::get_instance()->init("./record/ServerLog", m_close_log, 2000, 800000, 1000);
+    Log::get_instance()->init("./record/ServerLog", m_close_log, 2000, 800000, LOG_RING_DEFAULT_KB);
     LOG_INFO("WebServer (MainReactor) init...");
 
     // 4. 初始化 root 路径
@@ -118,24 +147,13 @@ void WebServer::init(int port, string databaseURL, string user, string passWord,
     // 5. 初始化路由和上下文 (共享)
     m_context.db_pool = m_connPool;
     m_context.doc_root = m_root;
+    m_context.admin_remote = (admin_trace == 2);
+    if (m_file_cache.init(m_root, (size_t)std::max(file_cache_mb, 0) * 1024 * 1024) && m_file_cache.enabled()) {
+        m_context.file_cache = &m_file_cache;
+    }
 
-    // API 路由
-    m_router.add_route(HttpMethod::GET, "/api/test", handle_simple_json_get);
-    m_router.add_route(HttpMethod::POST, "/api/register", handle_register);
-    m_router.add_route(HttpMethod::POST, "/api/auth/login", handle_login);
-    m_router.add_route(HttpMethod::GET, "/api/auth/validate_session", handle_validate_session);
-    m_router.add_route(HttpMethod::GET, "/api/auth/logout", handle_logout);
-    m_router.add_route(HttpMethod::GET, "/api/upgrade", handle_websocket_upgrade);
-    // 静态文件路由 - 使用正则表达式匹配各种文件扩展名
-    m_router.add_route(HttpMethod::GET, R"(/.*\.(html|htm|css|js|json|txt|xml|csv)$)", handle_static_file);
-    m_router.add_route(HttpMethod::GET, R"(/.*\.(jpg|jpeg|png|gif|bmp|webp|svg|ico)$)", handle_static_file);
-    m_router.add_route(HttpMethod::GET, R"(/.*\.(pdf|doc|docx|xls|xlsx|ppt|pptx)$)", handle_static_file);
-    m_router.add_route(HttpMethod::GET, R"(/.*\.(mp3|wav|mp4|avi)$)", handle_static_file);
-    m_router.add_route(HttpMethod::GET, R"(/.*\.(zip|tar|gz|rar)$)", handle_static_file);
-    m_router.add_route(HttpMethod::GET, R"(/.*\.(ttf|woff|woff2)$)", handle_static_file);
-    // 特殊处理：根目录和无扩展名的文件（如/index, /favicon等）
-    m_router.add_route(HttpMethod::GET, R"(^/$)", handle_static_file);  // 根目录重定向到index.html
-    m_router.add_route(HttpMethod::GET, R"(/[^.]*$)", handle_static_file);  // 无扩展名文件
+    // 路由表（见 Handler.cpp 的 register_routes）
+    register_routes(m_router, admin_trace > 0);
 
 
     // 6. 初始化从 Reactors
@@ -153,13 +171,158 @@ void WebServer::init(int port, string databaseURL, string user, string passWord,
     {
         m_sub_reactors[i] = new SubReactor();
         // 将共享资源传递给 SubReactor
-        m_sub_reactors[i]->init(m_pool, m_connPool, &m_router, &m_context, m_timeout_sec, &stop_server);
-        // 启动 SubReactor 线程
+        m_sub_reactors[i]->init(m_pool, m_connPool, &m_router, &m_context, m_timeouts, &stop_server, i);
+        // SubReactor 线程在 eventListen 中创建完监听套接字后才启动
+    }
+
+    // 7. 抓取 /metrics 时读取各组件自己持有的状态
+    m_metrics_collector = Metrics::get_instance().add_collector([this](MetricsWriter &w) { collect_metrics(w); });
+}
+
+void WebServer::collect_metrics(MetricsWriter &w)
+{
+    Metrics &metrics = Metrics::get_instance();
+
+    w.family("webserver_reactor_loop_seconds", "Time spent handling one batch of epoll events per SubReactor.", "histogram");
+    for (auto *sub : m_sub_reactors) {
+        HistogramSnapshot loop;
+        loop.add(sub->getLoopHistogram());
+        w.histogram("webserver_reactor_loop_seconds", "reactor=\"" + std::to_string(sub->getId()) + "\"", loop,
+                    METRICS_LATENCY_BOUNDS, METRICS_LATENCY_BOUND_COUNT, 1e-9);
+    }
+    w.family("webserver_reactor_task_queue_depth", "Tasks posted to a SubReactor and not yet run.", "gauge");
+    for (auto *sub : m_sub_reactors) {
+        w.sample("webserver_reactor_task_queue_depth", "reactor=\"" + std::to_string(sub->getId()) + "\"",
+                 metrics.reactor_queue_depth(sub->getId()));
+    }
+
+    w.family("webserver_threadpool_queue_length", "Tasks queued in the worker pool.", "gauge");
+    w.sample("webserver_threadpool_queue_length", "", (uint64_t)m_pool->queue_size());
+
+    static const std::pair<ConnPhase, const char *> phases[] = {
+        {ConnPhase::Header, "header"}, {ConnPhase::Body, "body"}, {ConnPhase::Idle, "idle"}, {ConnPhase::Write, "write"}};
+    w.family("webserver_timeout_closes_total", "Connections closed by a timeout, by phase.", "counter");
+    for (const auto &phase : phases) {
+        uint64_t closes = 0;
+        for (auto *sub : m_sub_reactors) {
+            closes += sub->getTimeoutCloses(phase.first);
+        }
+        w.sample("webserver_timeout_closes_total", std::string("phase=\"") + phase.second + "\"", closes);
+    }
+
+    HttpConnectionPool &conn_pool = HttpConnectionPool::get_instance();
+    w.family("webserver_http_connections_in_use", "Pooled HttpConnection objects in use.", "gauge");
+    w.sample("webserver_http_connections_in_use", "", (uint64_t)conn_pool.in_use());
+    w.family("webserver_http_connections_created_total", "HttpConnection objects ever created.", "counter");
+    w.sample("webserver_http_connections_created_total", "", (uint64_t)conn_pool.total_created());
+    w.family("webserver_http_connections_pooled", "Idle HttpConnection objects in the pool.", "gauge");
+    w.sample("webserver_http_connections_pooled", "", (uint64_t)conn_pool.pool_size());
+    // BufferPool：按尺寸等级
+    BufferPoolStats buffers = BufferPool::get_instance().stats();
+    auto class_label = [](size_t cls) { return "class=\"" + std::to_string(BUFFER_CLASS_SIZES[cls]) + "\""; };
+    auto per_class = [&](const char* name, const char* help, const char* type,
+                         uint64_t (*value)(const BufferClassStats&, size_t)) {
+        w.family(name, help, type);
+        for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+            w.sample(name, class_label(cls), value(buffers.classes[cls], cls));
+        }
+    };
+    per_class("webserver_buffer_pool_allocs_total", "Buffers allocated, by size class.", "counter",
+              [](const BufferClassStats& c, size_t) { return c.allocs; });
+    per_class("webserver_buffer_pool_in_use", "Buffers currently allocated, by size class.", "gauge",
+              [](const BufferClassStats& c, size_t) { return c.allocs - std::min(c.allocs, c.frees); });
+    per_class("webserver_buffer_pool_arena_bytes", "Arena bytes carved into blocks, by size class.", "gauge",
+              [](const BufferClassStats& c, size_t cls) { return c.arena_blocks * (uint64_t)BUFFER_CLASS_SIZES[cls]; });
+    per_class("webserver_buffer_pool_depot_magazines", "Magazines held in the global depot, by size class.", "gauge",
+              [](const BufferClassStats& c, size_t) { return c.depot_magazines; });
+    w.family("webserver_buffer_pool_depot_exchanges_total", "Magazine exchanges between thread caches and the depot.", "counter");
+    for (size_t cls = 0; cls < BUFFER_CLASS_COUNT; ++cls) {
+        w.sample("webserver_buffer_pool_depot_exchanges_total", class_label(cls) + ",op=\"get\"", buffers.classes[cls].depot_gets);
+        w.sample("webserver_buffer_pool_depot_exchanges_total", class_label(cls) + ",op=\"put\"", buffers.classes[cls].depot_puts);
+    }
+    w.family("webserver_buffer_pool_oversize_allocs_total", "Buffer allocations above the largest size class.", "counter");
+    w.sample("webserver_buffer_pool_oversize_allocs_total", "", buffers.oversize_allocs);
+    w.family("webserver_buffer_pool_fallback_allocs_total", "Buffer allocations served by operator new after the arena ran out.", "counter");
+    w.sample("webserver_buffer_pool_fallback_allocs_total", "", buffers.fallback_allocs);
+    w.family("webserver_buffer_pool_hugepages", "Whether the arenas use transparent huge pages.", "gauge");
+    w.sample("webserver_buffer_pool_hugepages", "", (uint64_t)buffers.hugepages);
+
+    w.family("webserver_log_dropped_total", "Log records dropped because the ring was full.", "counter");
+    w.sample("webserver_log_dropped_total", "", Log::get_instance()->dropped());
+}
+
+void WebServer::startSubReactors()
+{
+    // std::thread 构造之前的写入（监听套接字等）对新线程可见，此后各 Reactor 的 m_listenfd 不再修改
+    for (int i = 0; i < m_sub_reactor_num; ++i)
+    {
         m_sub_threads[i] = std::thread(&SubReactor::eventLoop, m_sub_reactors[i]);
     }
 }
 
 void WebServer::eventListen()
+{
+    if (m_reuse_port)
+    {
+        // SO_REUSEPORT 模式：按顺序为每个从 Reactor 创建监听套接字，组内下标即 Reactor 下标；
+        // 必须在从 Reactor 线程启动之前完成，eventLoop 每次事件都会读取 m_listenfd
+        for (int i = 0; i < m_sub_reactor_num; ++i)
+        {
+            if (!m_sub_reactors[i]->listenReusePort(m_port))
+            {
+                std::cerr << "SubReactor " << i << " listen on port " << m_port << " failed" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+        startSubReactors();
+
+        if (m_reuse_port == 2)
+        {
+            // 附加 CBPF 程序按 CPU 编号选择监听套接字，并把第 i 个从 Reactor 绑定到第 i 个 CPU，
+            // 使网卡软中断所在 CPU 与处理该连接的线程一致
+            if (Tools::attach_reuseport_cbpf(m_sub_reactors[0]->getListenFd(), m_sub_reactor_num))
+            {
+                int cpu_num = std::thread::hardware_concurrency();
+                for (int i = 0; i < m_sub_reactor_num && cpu_num > 0; ++i)
+                {
+                    cpu_set_t cpuset;
+                    CPU_ZERO(&cpuset);
+                    CPU_SET(i % cpu_num, &cpuset);
+                    pthread_setaffinity_np(m_sub_threads[i].native_handle(), sizeof(cpuset), &cpuset);
+                }
+            }
+            else
+            {
+                LOG_WARN("MainReactor: SO_ATTACH_REUSEPORT_CBPF unavailable, falling back to hash dispatch");
+            }
+        }
+    }
+    else
+    {
+        eventListenMain();
+        startSubReactors();
+    }
+
+    // 主 Reactor 的 epoll（SO_REUSEPORT 模式下只用于信号处理）
+    m_epollfd = epoll_create(5);
+    if (m_epollfd == -1) { perror("epoll_create error: Epoll创建失败"); exit(EXIT_FAILURE); }
+
+    if (m_listenfd != -1)
+    {
+        // 只把 m_listenfd 纳入主 epoll 监听 (LT模式)
+        Tools::addfd(m_epollfd, m_listenfd, false, 0);
+    }
+    
+    std::cout << "HTTP server (" << (m_reuse_port ? "SO_REUSEPORT Multi-Acceptor" : "Main-Sub Reactor")
+              << ") running on port " << m_port
+              << " | SubReactors=" << m_sub_reactor_num
+              << " | WorkerThreads=" << m_thread_num
+              << std::endl;
+
+    eventListenSignal();
+}
+
+void WebServer::eventListenMain()
 {
     // 创建监听套接字
     m_listenfd = socket(PF_INET, SOCK_STREAM, 0);
@@ -177,21 +340,12 @@ void WebServer::eventListen()
     if (ret < 0) { perror("bind error: 端口已经被占用"); exit(EXIT_FAILURE); }
     ret = listen(m_listenfd, 5);
     if (ret < 0) { perror("listen error: 监听失败"); exit(EXIT_FAILURE); }
+}
 
-    // 主 Reactor 的 epoll
-    m_epollfd = epoll_create(5);
-    if (m_epollfd == -1) { perror("epoll_create error: Epoll创建失败"); exit(EXIT_FAILURE); }
-
-    // 只把 m_listenfd 纳入主 epoll 监听 (LT模式)
-    Tools::addfd(m_epollfd, m_listenfd, false, 0);
-    
-    std::cout << "HTTP server (Main-Sub Reactor) running on port " << m_port
-              << " | SubReactors=" << m_sub_reactor_num
-              << " | WorkerThreads=" << m_thread_num
-              << std::endl;
-
+void WebServer::eventListenSignal()
+{
     // 创建 主 Reactor 的信号管道
-    ret = socketpair(PF_UNIX, SOCK_STREAM, 0, m_pipefd);
+    int ret = socketpair(PF_UNIX, SOCK_STREAM, 0, m_pipefd);
     if (ret == -1) { std::cerr << "socketpair error" << std::endl; exit(EXIT_FAILURE); }
     Tools::u_pipefd = m_pipefd; // Tools 静态成员指向此管道
     Tools::setnonblocking(m_pipefd[0]);
@@ -203,11 +357,20 @@ void WebServer::eventListen()
     // 设置信号处理函数
     Tools::addsig(SIGPIPE, SIG_IGN);
     Tools::addsig(SIGINT, Tools::sig_handler, false);
-    Tools::addsig(SIGALRM, Tools::sig_handler, false); // 主 Reactor 接收 SIGALRM
     Tools::addsig(SIGTERM, Tools::sig_handler, false);
-    
-    // 设置定时器信号
-    alarm(1);
+
+    // Date 响应头：先生成第一份，之后由每个整秒触发的 timerfd 更新
+    // （连接超时由各 SubReactor 自己的 timerfd 驱动，进程不再使用 SIGALRM）
+    HttpClock::update();
+    m_clockfd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_clockfd == -1) { perror("timerfd_create error"); exit(EXIT_FAILURE); }
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    itimerspec spec{};
+    spec.it_value.tv_sec = now.tv_sec + 1; // 对齐到下一个整秒，与 Date 的秒数同步翻转
+    spec.it_interval.tv_sec = 1;
+    timerfd_settime(m_clockfd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    Tools::addfd(m_epollfd, m_clockfd, false, 0); // LT模式
 }
 
 void WebServer::eventLoop()
@@ -215,7 +378,7 @@ void WebServer::eventLoop()
     LOG_INFO("MainReactor: Event loop starting...");
     while (!stop_server)
     {
-        // 等待 m_listenfd 和 m_pipefd[0]
+        // 等待 m_listenfd、m_pipefd[0] 和 m_clockfd
         int num = epoll_wait(m_epollfd, events, MAX_EVENT_NUMBER, -1);
         if (num < 0 && errno != EINTR)
         {
@@ -257,7 +420,15 @@ void WebServer::eventLoop()
                 }
                 continue;
             }
-            // 2. 处理信号
+            // 2. 每秒更新一次 Date/Server 前缀
+            else if (sockfd == m_clockfd)
+            {
+                uint64_t expirations;
+                if (read(m_clockfd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                    HttpClock::update(); // 所有响应共用的 Date/Server 前缀
+                }
+            }
+            // 3. 处理信号
             else if ((sockfd == m_pipefd[0]) && (events[i].events & EPOLLIN))
             {
                 while (true)
@@ -283,17 +454,6 @@ void WebServer::eventLoop()
                                 }
                                 break;
                             }
-                        case SIGALRM:
-                            {
-                                // LOG_DEBUG("MainReactor: Timer tick received. Forwarding to SubReactors.");
-                                int tick_msg = -2; // -2 代表 Tick
-                                for (auto* sub : m_sub_reactors) {
-                                    write(sub->getPipeFd(), &tick_msg, sizeof(tick_msg));
-                                }
-                                // 重新设置定时器
-                                alarm(1);
-                                break;
-                            }
                         default:
                             std::cerr << "unknown signal " << sigs[i] << std::endl;
                         }
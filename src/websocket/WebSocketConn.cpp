@@ -1,6 +1,7 @@
 #include "websocket/WebSocketServer.h"
 #include "websocket/WebSocketConn.h"
 #include "log/Log.h"
+#include "metrics/Metrics.h"
 #include <sys/socket.h>
 #include <unistd.h>
 #include <errno.h>
@@ -99,11 +100,25 @@ Action WebSocketConn::handle_write() {
     return Action::Read;
 }
 
+Action WebSocketConn::reject_overloaded() {
+    std::lock_guard<std::mutex> lock(write_mtx_);
+    // 关闭帧：FIN=1, opcode=0x8，载荷为 2 字节状态码 1013（0x03F5），排在尚未发完的数据之后
+    static const char close_frame[4] = {static_cast<char>(0x88), 0x02, 0x03, static_cast<char>(0xF5)};
+    write_buf_.append(close_frame, sizeof(close_frame));
+    // 只尝试一次非阻塞发送，内核缓冲区满时直接放弃
+    send(fd_, write_buf_.data(), write_buf_.size(), 0);
+    write_buf_.clear();
+    closed_ = true;
+    Metrics::local().ws_overload_closes.add();
+    return Action::Close;
+}
+
 void WebSocketConn::send_text(const std::string& text) {
     if (closed_) return;
     
     std::lock_guard<std::mutex> lock(write_mtx_);
     write_buf_.append(pack_text_frame(text));
+    Metrics::local().ws_frames_out.add();
 }
 
 bool WebSocketConn::write_buffer_empty() {
@@ -156,6 +171,7 @@ bool WebSocketConn::parseFrames() {
         // 提取 payload
         std::string payload = read_buf_.substr(header_len, payload_len);
         read_buf_.erase(0, header_len + payload_len);
+        Metrics::local().ws_frames_in.add();
 
         // unmask
         if (masked) {
@@ -178,6 +194,7 @@ bool WebSocketConn::parseFrames() {
             unsigned char pong_header[2] = {0x8A, 0x00}; // FIN=1, opcode=0xA (pong), no payload
             std::lock_guard<std::mutex> lock(write_mtx_);
             write_buf_.append(reinterpret_cast<char*>(pong_header), 2);
+            Metrics::local().ws_frames_out.add();
         } else if (opcode == 0xA) {
             // Pong frame - 忽略
         } else {
@@ -1,6 +1,7 @@
 #include "websocket/WebSocketServer.h"
 #include "websocket/WebSocketConn.h"
 #include "log/Log.h"
+#include "metrics/Metrics.h"
 #include <nlohmann/json.hpp>
 #include <chrono>
 
@@ -22,7 +23,7 @@ void WebSocketServer::setContext(RequestContext* context) {
 
 void WebSocketServer::registerCallback(int fd, ActionCallback cb) {
     std::lock_guard<std::mutex> lock(mtx_);
-    fd_callbacks_[fd] = cb;
+    fd_callbacks_[fd] = std::move(cb);
     LOG_DEBUG("Registered callback for fd=%d", fd);
 }
 
@@ -173,20 +174,22 @@ void WebSocketServer::broadcastRoomLocked(const std::string& room, const std::st
         return;
     }
     
-    // 打印房间成员
-    std::string members = "";
-    for (int member_fd : room_it->second) {
-        auto member_it = conns_.find(member_fd);
-        if (member_it != conns_.end()) {
-            members += std::to_string(member_fd) + "(" + member_it->second->username() + ") ";
-        } else {
-            members += std::to_string(member_fd) + "(not_in_conns) ";
+    // 打印房间成员（只在 debug 级别开启时拼接）
+    if (LOG_ENABLED(0)) {
+        std::string members = "";
+        for (int member_fd : room_it->second) {
+            auto member_it = conns_.find(member_fd);
+            if (member_it != conns_.end()) {
+                members += std::to_string(member_fd) + "(" + member_it->second->username() + ") ";
+            } else {
+                members += std::to_string(member_fd) + "(not_in_conns) ";
+            }
         }
+        
+        LOG_DEBUG("Broadcasting to room=%s, exclude_fd=%d, room_size=%zu, members=[%s], message=%s", 
+                  room.c_str(), exclude_fd, room_it->second.size(), members.c_str(), message.c_str());
     }
     
-    LOG_DEBUG("Broadcasting to room=%s, exclude_fd=%d, room_size=%zu, members=[%s], message=%s", 
-              room.c_str(), exclude_fd, room_it->second.size(), members.c_str(), message.c_str());
-    
     int broadcast_count = 0;
     for (int fd : room_it->second) {
         if (fd == exclude_fd) {
@@ -226,10 +229,14 @@ void WebSocketServer::broadcastRoomLocked(const std::string& room, const std::st
         }
     }
     
+    Metrics::local().ws_fanout.record((uint64_t)broadcast_count);
     LOG_DEBUG("Broadcast completed: room=%s, sent to %d connections", room.c_str(), broadcast_count);
 }
 
 void WebSocketServer::printRoomInfo(const std::string& room, const std::string& context) {
+    if (!LOG_ENABLED(1)) {
+        return;
+    }
     auto room_it = rooms_.find(room);
     if (room_it == rooms_.end()) {
         LOG_INFO("[%s] Room '%s' not found", context.c_str(), room.c_str());